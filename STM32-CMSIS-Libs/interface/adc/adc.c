@@ -1,6 +1,10 @@
 #include "adc.h"
+#include "adc_scan.h"
+#include "adc_watch.h"
+#include "adc_injected.h"
 #include "stdint.h"
 #include "stm32f10x.h"
+#include "libs_common.h"
 
 static void adc_config_init( ) {
     static _Bool finished = 0;
@@ -20,7 +24,7 @@ static void adc_config_init( ) {
     // 配置右对齐数据格式，单次转换模式
     ADC1->CR2 &= ~ADC_CR2_ALIGN;    // 右对齐
     ADC1->CR2 &= ~ADC_CR2_CONT;     // 单次转换模式
-    ADC1->CR2 &= ~ADC_CR2_EXTSEL;   // 软件触发
+    ADC1->CR2 |= ADC_CR2_EXTSEL;    // 软件触发 (EXTSEL = 111 SWSTART, 000 is TIM1_CC1)
     ADC1->CR2 |= ADC_CR2_EXTTRIG;   // 使能外部触发
 
     finished = 1;
@@ -59,7 +63,7 @@ uint8_t adc_init(ADC_CHANNEL ch) {
     ADC1->CR2 |= ADC_CR2_ADON;
     for (volatile int i = 0; i < 1000; i++);
     ADC1->CR2 |= ADC_CR2_CAL;
-    while (ADC1->CR2 & ADC_CR2_CAL);
+    while (ADC1->CR2 & ADC_CR2_CAL) HW_SPIN_HOOK();
 
     return 0;
 }
@@ -68,20 +72,56 @@ uint8_t adc_init(ADC_CHANNEL ch) {
  * @brief 读取指定ADC通道的单次转换值
  * @param ch ADC通道号
  * @return 12位ADC转换结果 (0-4095)
+ *         While adc_scan_start() runs, the latest scan value of the channel
+ *         (0 if it is not scanned) without a conversion.
  */
 uint16_t adc_get_single(ADC_CHANNEL ch) {
+    if ( adc_scan_running() ) return adc_scan_get(ch);
+
     // 1. 配置转换序列（即需要转换几个通道）
     ADC1->SQR1 = 0;  // 转换序列长度为1
     ADC1->SQR3 = ch; // 设置第一个转换通道
     
-    // 2. 开始转换
+    // 2. 清除上一次遗留的EOC标志，然后开始转换
+    ADC1->SR &= ~ADC_SR_EOC;
     ADC1->CR2 |= ADC_CR2_ADON;  // 启动转换
     
     // 3. 等待转换完成
-    while (!(ADC1->SR & ADC_SR_EOC));
+    while (!(ADC1->SR & ADC_SR_EOC)) HW_SPIN_HOOK();
     
     // 4. 读取转换结果并清除EOC标志
     uint16_t result = ADC1->DR;
     
     return result;
 }
+
+void adc_set_sample_time(ADC_CHANNEL ch, ADC_SAMPLE_TIME smp) {
+    if ( ch <= ADC_CH9_PB1 ) {
+        ADC1->SMPR2 = ( ADC1->SMPR2 & ~( 0b111 << ( ch * 3 ) ) ) | ( smp << ( ch * 3 ) );
+    } else {
+        ADC1->SMPR1 = ( ADC1->SMPR1 & ~( 0b111 << (( ch - 10 ) * 3) ) ) | ( smp << (( ch - 10 ) * 3) );
+    }
+}
+
+// Timer clocks per period at `rate_hz`, split into PSC and ARR (16 bits each)
+uint32_t adc_trigger_timer(TIM_TypeDef *tim, uint32_t tim_hz, uint32_t rate_hz) {
+    uint32_t ticks = ( tim_hz + rate_hz / 2 ) / rate_hz;
+    uint32_t psc = ( ticks - 1 ) / 0x10000;
+    uint32_t arr = ( ticks + psc / 2 ) / ( psc + 1 ) - 1;
+
+    tim->CR1 = 0;
+    tim->PSC = psc;
+    tim->ARR = arr;
+    tim->CNT = 0;
+    tim->CR2 = 0;
+    tim->EGR = TIM_EGR_UG;      // 装载预分频值
+    tim->CR2 = TIM_CR2_MMS_1;   // update event -> TRGO
+    return ( psc + 1 ) * ( arr + 1 );
+}
+
+// ADC1 and ADC2 share the interrupt: analog watchdog and injected group
+void ADC1_2_IRQHandler(void) {
+    uint32_t sr = ADC1->SR;
+    if ( sr & ADC_SR_JEOC ) adc_injected_irq();
+    if ( sr & ADC_SR_AWD ) adc_watch_irq();
+}
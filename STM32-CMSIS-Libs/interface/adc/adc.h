@@ -1,6 +1,7 @@
 #ifndef INTERFACE_ADC_H
 #define INTERFACE_ADC_H
 #include "stdint.h"
+#include "stm32f10x.h"
 
 typedef enum _ADC_CHANNEL {
     ADC_CH0_PA0,
@@ -21,7 +22,31 @@ typedef enum _ADC_CHANNEL {
     ADC_CH15_PC5
 } ADC_CHANNEL;
 
+// Sampling time of a channel, in ADC clocks (12 MHz); a conversion takes
+// 12.5 clocks more
+typedef enum _ADC_SAMPLE_TIME {
+    ADC_SMP_1_5,
+    ADC_SMP_7_5,
+    ADC_SMP_13_5,
+    ADC_SMP_28_5,
+    ADC_SMP_41_5,
+    ADC_SMP_55_5,
+    ADC_SMP_71_5,
+    ADC_SMP_239_5
+} ADC_SAMPLE_TIME;
+
 uint8_t adc_init(ADC_CHANNEL ch);
 uint16_t adc_get_single(ADC_CHANNEL ch);
 
+// The sampling time belongs to the channel: regular and injected
+// conversions of it both use it
+void adc_set_sample_time(ADC_CHANNEL ch, ADC_SAMPLE_TIME smp);
+
+/**
+ * @brief  Set up a stopped timer (clock already enabled) to emit TRGO on
+ *         every update at `rate_hz`, for the timed scan and injected group.
+ * @return timer clocks per period
+ */
+uint32_t adc_trigger_timer(TIM_TypeDef *tim, uint32_t tim_hz, uint32_t rate_hz);
+
 #endif
\ No newline at end of file
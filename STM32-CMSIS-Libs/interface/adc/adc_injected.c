@@ -0,0 +1,102 @@
+#include "adc_injected.h"
+#include "stddef.h"
+#include "stm32f10x.h"
+#include "delay/delay.h"
+#include "libs_common.h"
+#include "bitband/bitband.h"
+
+static struct {
+    uint8_t count;
+    bool timed;                 // TIM2 TRGO starts the group
+    adc_injected_fn fn;
+    void *arg;
+    volatile bool started;
+    volatile uint32_t groups;
+} inj;
+
+uint8_t adc_injected_start(const adc_injected_config_t *config) {
+    if ( config->count == 0 || config->count > ADC_INJECTED_MAX_CHANNELS ||
+         config->fn == NULL || config->rate_hz > ADC_INJECTED_TIM_HZ / 2 ) {
+        return 1;
+    }
+
+    adc_injected_stop();
+
+    // JL = count - 1; a sequence shorter than four uses the last JSQx slots,
+    // and JDR1 .. JDRn hold the results in conversion order
+    uint32_t jsqr = (uint32_t)( config->count - 1 ) << 20;
+    for ( uint8_t i = 0; i < config->count; i++ ) {
+        ADC_CHANNEL ch = config->channels[i];
+        adc_init(ch);
+        adc_set_sample_time(ch, config->sample_time);
+        jsqr |= (uint32_t)ch << ( ( ADC_INJECTED_MAX_CHANNELS - config->count + i ) * 5 );
+    }
+    ADC1->JSQR = jsqr;
+    ADC1->JOFR1 = ADC1->JOFR2 = ADC1->JOFR3 = ADC1->JOFR4 = 0;
+
+    inj.count = config->count;
+    inj.timed = config->rate_hz != 0;
+    inj.fn = config->fn;
+    inj.arg = config->arg;
+    inj.groups = 0;
+
+    // SCAN converts the whole injected group; single regular reads
+    // (SQR1.L = 0) are not affected by it
+    ADC1->SR = ~( ADC_SR_JEOC | ADC_SR_JSTRT );
+    ADC1->CR1 |= ADC_CR1_SCAN | ADC_CR1_JEOCIE;
+    NVIC_EnableIRQ(ADC1_2_IRQn);
+    inj.started = 1;
+
+    if ( !inj.timed ) {
+        // JSWSTART only
+        ADC1->CR2 |= ADC_CR2_JEXTSEL | ADC_CR2_JEXTTRIG;
+    } else {
+        ADC1->CR2 = ( ADC1->CR2 & ~ADC_CR2_JEXTSEL ) | ADC_CR2_JEXTSEL_1 | ADC_CR2_JEXTTRIG;
+        RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+        adc_trigger_timer(TIM2, ADC_INJECTED_TIM_HZ, config->rate_hz);
+        TIM2->CR1 = TIM_CR1_CEN;
+    }
+    return 0;
+}
+
+void adc_injected_stop(void) {
+    if ( !inj.started ) return;
+
+    if ( inj.timed ) {
+        TIM2->CR1 = 0;
+        TIM2->CR2 = 0;
+    }
+    ADC1->CR2 &= ~ADC_CR2_JEXTTRIG;
+    // Let a group already started finish (four conversions at most), or the
+    // next configuration's first trigger would be ignored
+    while ( ( ADC1->SR & ( ADC_SR_JSTRT | ADC_SR_JEOC ) ) == ADC_SR_JSTRT ) HW_SPIN_HOOK();
+    ADC1->CR1 &= ~ADC_CR1_JEOCIE;
+    ADC1->SR = ~( ADC_SR_JEOC | ADC_SR_JSTRT );
+    inj.started = 0;
+}
+
+uint8_t adc_injected_trigger(void) {
+    if ( !inj.started || inj.timed ) return 1;
+    // JSTRT is set from the start of the group until the interrupt clears it
+    if ( ADC1->SR & ADC_SR_JSTRT || ADC1->CR2 & ADC_CR2_JSWSTART ) return 2;
+
+    BITBAND_SET(ADC1->CR2, ADC_CR2_JSWSTART);
+    return 0;
+}
+
+uint32_t adc_injected_count(void) {
+    return inj.groups;
+}
+
+void adc_injected_irq(void) {
+    uint64_t now = delay_get_us();
+    ADC1->SR = ~( ADC_SR_JEOC | ADC_SR_JSTRT );
+    if ( !inj.started ) return;
+
+    uint16_t values[ADC_INJECTED_MAX_CHANNELS];
+    const volatile uint32_t *jdr = &ADC1->JDR1;
+    for ( uint8_t i = 0; i < inj.count; i++ ) values[i] = (uint16_t)jdr[i];
+
+    inj.groups++;
+    inj.fn(values, inj.count, now, inj.arg);
+}
@@ -0,0 +1,65 @@
+#ifndef INTERFACE_ADC_INJECTED_H
+#define INTERFACE_ADC_INJECTED_H
+#include "stdint.h"
+#include "stdbool.h"
+#include "adc.h"
+
+// ADC1 injected group: up to four channels converted ahead of the regular
+// sequence. A trigger preempts the regular conversion in progress, which is
+// redone afterwards, so a running adc_scan keeps going with its DMA and
+// only its frame that was interrupted comes out a bit later.
+#define ADC_INJECTED_MAX_CHANNELS   4
+
+// Timed injected groups are started by the update event of TIM2 (TRGO,
+// JEXTSEL = TIM2_TRGO)
+#define ADC_INJECTED_TIM_HZ         72000000UL
+
+/**
+ * @brief Called from the ADC interrupt once the group is converted.
+ * @param values        one result per channel, in the configured order
+ * @param timestamp_us  delay_get_us() when the last conversion ended
+ */
+typedef void (*adc_injected_fn)(const uint16_t *values, uint8_t count, uint64_t timestamp_us, void *arg);
+
+typedef struct {
+    const ADC_CHANNEL *channels;    // conversion order
+    uint8_t count;                  // 1 .. ADC_INJECTED_MAX_CHANNELS
+    ADC_SAMPLE_TIME sample_time;    // shared with regular conversions of
+                                    // the same channel
+    uint32_t rate_hz;               // groups per second started by TIM2,
+                                    // 0: only by adc_injected_trigger()
+    adc_injected_fn fn;
+    void *arg;
+} adc_injected_config_t;
+
+/**
+ * @brief  Set up the injected group and, with `rate_hz`, start TIM2.
+ *         The ADC stays powered (adc_init() of every channel); a regular scan
+ *         may be started or stopped before or after.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Invalid configuration.
+ */
+uint8_t adc_injected_start(const adc_injected_config_t *config);
+
+// Stop TIM2 and ignore further triggers; a group already started is finished
+// and delivered first
+void adc_injected_stop(void);
+
+/**
+ * @brief  Convert the group now (software trigger, JSWSTART); the callback
+ *         delivers the result.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Not started, or started with a rate (TIM2 owns the trigger).
+ *         - 2 The previous group is still being converted.
+ */
+uint8_t adc_injected_trigger(void);
+
+// Groups delivered to the callback
+uint32_t adc_injected_count(void);
+
+// JEOC set, called from ADC1_2_IRQHandler()
+void adc_injected_irq(void);
+
+#endif
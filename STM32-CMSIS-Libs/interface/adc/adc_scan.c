@@ -0,0 +1,241 @@
+#include "adc_scan.h"
+#include "stdint.h"
+#include "stddef.h"
+#include "stm32f10x.h"
+#include "libs_common.h"
+
+static struct {
+    ADC_CHANNEL channels[ADC_SCAN_MAX_CHANNELS];
+    uint8_t count;
+    uint16_t *buffer;
+    uint16_t frames;
+    uint16_t total;             // samples in the ring
+    uint32_t period;            // TIM3 clocks per frame, 0 when back to back
+    adc_scan_fn on_block;
+    void *arg;
+    uint8_t next_half;
+    volatile bool running;
+    volatile uint32_t blocks;
+    volatile uint32_t overruns;
+    // Oversampling, per channel: extra bits, running sum, samples in it and
+    // the last complete result
+    uint8_t oversample[ADC_SCAN_MAX_CHANNELS];
+    bool oversampling;
+    uint32_t sum[ADC_SCAN_MAX_CHANNELS];
+    uint16_t summed[ADC_SCAN_MAX_CHANNELS];
+    volatile uint16_t hires[ADC_SCAN_MAX_CHANNELS];
+    volatile bool hires_valid[ADC_SCAN_MAX_CHANNELS];
+} scan;
+
+// Sampling time + 12.5 ADC clocks per conversion, times two
+static const uint16_t conversion_x2[8] = { 28, 40, 52, 82, 108, 136, 168, 504 };
+
+// SQ1..SQ6 in SQR3, SQ7..SQ12 in SQR2, SQ13..SQ16 and the length in SQR1
+static void set_sequence(const ADC_CHANNEL *channels, uint8_t count) {
+    uint32_t sqr[3] = { ( count - 1 ) << 20, 0, 0 };
+    for ( uint8_t i = 0; i < count; i++ ) {
+        sqr[2 - i / 6] |= (uint32_t)channels[i] << ( ( i % 6 ) * 5 );
+    }
+    ADC1->SQR1 = sqr[0];
+    ADC1->SQR2 = sqr[1];
+    ADC1->SQR3 = sqr[2];
+}
+
+uint8_t adc_scan_start(const adc_scan_config_t *config) {
+    uint32_t total = 2UL * config->frames * config->count;
+    if ( config->count == 0 || config->count > ADC_SCAN_MAX_CHANNELS ||
+         config->frames == 0 || total > 0xFFFF || config->buffer == NULL ||
+         config->sample_rate_hz > ADC_SCAN_TIM_HZ / 2 ) {
+        return 1;
+    }
+    for ( uint8_t i = 0; config->oversample != NULL && i < config->count; i++ ) {
+        if ( config->oversample[i] > ADC_SCAN_MAX_OVERSAMPLE ) return 1;
+    }
+    // ADC clock is PCLK2 / 6, three TIM3 clocks per half ADC clock
+    uint32_t frame_ticks = config->count * conversion_x2[config->sample_time] * 3;
+    if ( config->sample_rate_hz != 0 &&
+         frame_ticks >= ( ADC_SCAN_TIM_HZ + config->sample_rate_hz / 2 ) / config->sample_rate_hz ) {
+        return 2;
+    }
+
+    adc_scan_stop();
+
+    for ( uint8_t i = 0; i < config->count; i++ ) {
+        scan.channels[i] = config->channels[i];
+        adc_init(config->channels[i]);
+        adc_set_sample_time(config->channels[i], config->sample_time);
+    }
+    scan.count = config->count;
+    scan.buffer = config->buffer;
+    scan.frames = config->frames;
+    scan.total = (uint16_t)total;
+    scan.on_block = config->on_block;
+    scan.arg = config->arg;
+    scan.next_half = 0;
+    scan.blocks = 0;
+    scan.overruns = 0;
+    scan.oversampling = 0;
+    for ( uint8_t i = 0; i < config->count; i++ ) {
+        scan.oversample[i] = config->oversample != NULL ? config->oversample[i] : 0;
+        scan.oversampling |= scan.oversample[i] != 0;
+        scan.sum[i] = 0;
+        scan.summed[i] = 0;
+        scan.hires_valid[i] = 0;
+    }
+
+    set_sequence(scan.channels, scan.count);
+
+    // DMA1 channel 1 (ADC1 request): DR -> ring, 16 bits, circular
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+    DMA1_Channel1->CCR = 0;
+    DMA1->IFCR = DMA_IFCR_CGIF1;
+    DMA1_Channel1->CPAR = (uintptr_t)&ADC1->DR;
+    DMA1_Channel1->CMAR = (uintptr_t)scan.buffer;
+    DMA1_Channel1->CNDTR = scan.total;
+    uint32_t ccr = DMA_CCR1_PL_1 | DMA_CCR1_MSIZE_0 | DMA_CCR1_PSIZE_0 |
+                   DMA_CCR1_MINC | DMA_CCR1_CIRC;
+    if ( scan.on_block != NULL || scan.oversampling ) {
+        ccr |= DMA_CCR1_HTIE | DMA_CCR1_TCIE | DMA_CCR1_TEIE;
+        NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    }
+    DMA1_Channel1->CCR = ccr | DMA_CCR1_EN;
+
+    // Scan the sequence, every conversion goes to the DMA
+    ADC1->CR1 |= ADC_CR1_SCAN;
+    scan.running = 1;
+    if ( config->sample_rate_hz == 0 ) {
+        // Continuously, restarted by the ADC itself
+        scan.period = 0;
+        ADC1->CR2 |= ADC_CR2_DMA | ADC_CR2_CONT;
+        ADC1->CR2 |= ADC_CR2_ADON;  // ADON written again: start
+    } else {
+        // Once per TIM3 update; generating one now starts the first frame
+        RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+        scan.period = adc_trigger_timer(TIM3, ADC_SCAN_TIM_HZ, config->sample_rate_hz);
+        ADC1->CR2 = ( ADC1->CR2 & ~( ADC_CR2_EXTSEL | ADC_CR2_CONT ) ) |
+                    ADC_CR2_EXTSEL_2 | ADC_CR2_EXTTRIG | ADC_CR2_DMA;
+        TIM3->EGR = TIM_EGR_UG;
+        TIM3->CR1 = TIM_CR1_CEN;
+    }
+
+    // Until the first frame is in the ring
+    uint32_t first_frame = (uint32_t)scan.total - scan.count;
+    while ( DMA1_Channel1->CNDTR > first_frame ) HW_SPIN_HOOK();
+    return 0;
+}
+
+void adc_scan_stop(void) {
+    if ( !scan.running ) return;
+
+    if ( scan.period != 0 ) {
+        TIM3->CR1 = 0;
+        TIM3->CR2 = 0;
+    }
+
+    // Power the ADC down to end the sequence in progress, then back up so
+    // the next ADON write starts a conversion again. Software trigger again.
+    // SCAN stays for the injected group; an injected group cut short here
+    // is not delivered.
+    ADC1->CR2 = ( ADC1->CR2 & ~( ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_ADON ) ) | ADC_CR2_EXTSEL;
+    ADC1->SR = ~ADC_SR_JSTRT;
+    DMA1_Channel1->CCR = 0;
+    NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    DMA1->IFCR = DMA_IFCR_CGIF1;
+    scan.running = 0;
+
+    ADC1->CR2 |= ADC_CR2_ADON;
+    for (volatile int i = 0; i < 1000; i++);
+}
+
+bool adc_scan_running(void) {
+    return scan.running;
+}
+
+uint32_t adc_scan_period(void) {
+    return scan.running ? scan.period : 0;
+}
+
+uint16_t adc_scan_latest(uint8_t index) {
+    if ( !scan.running || index >= scan.count ) return 0;
+
+    // CNDTR counts down the samples left in this lap of the ring; the frame
+    // before the one being written is the newest complete one
+    uint16_t written = scan.total - DMA1_Channel1->CNDTR;
+    uint16_t frame = written / scan.count;
+    frame = frame == 0 ? 2 * scan.frames - 1 : frame - 1;
+    return scan.buffer[frame * scan.count + index];
+}
+
+uint16_t adc_scan_get(ADC_CHANNEL ch) {
+    for ( uint8_t i = 0; i < scan.count; i++ ) {
+        if ( scan.channels[i] == ch ) return adc_scan_latest(i);
+    }
+    return 0;
+}
+
+uint16_t adc_scan_oversampled(uint8_t index) {
+    if ( !scan.running || index >= scan.count ) return 0;
+    if ( scan.hires_valid[index] ) return scan.hires[index];
+    return adc_scan_latest(index) << scan.oversample[index];
+}
+
+uint32_t adc_scan_blocks(void) {
+    return scan.blocks;
+}
+
+uint32_t adc_scan_overruns(void) {
+    return scan.overruns;
+}
+
+// Add a block to the oversampling sums; every 4^n samples of a channel make
+// one result of 12 + n bits
+static void oversample_block(const uint16_t *block) {
+    for ( uint8_t i = 0; i < scan.count; i++ ) {
+        uint8_t n = scan.oversample[i];
+        if ( n == 0 ) continue;
+        uint16_t ratio = 1u << ( 2 * n );
+        uint32_t sum = scan.sum[i];
+        uint16_t summed = scan.summed[i];
+        const uint16_t *sample = block + i;
+        for ( uint16_t f = 0; f < scan.frames; f++, sample += scan.count ) {
+            sum += *sample;
+            if ( ++summed == ratio ) {
+                scan.hires[i] = sum >> n;
+                scan.hires_valid[i] = 1;
+                sum = 0;
+                summed = 0;
+            }
+        }
+        scan.sum[i] = sum;
+        scan.summed[i] = summed;
+    }
+}
+
+static void block_done(uint8_t half) {
+    const uint16_t *block = scan.buffer + half * scan.frames * scan.count;
+
+    // A skipped half means its data was overwritten before it was handed out
+    if ( half != scan.next_half ) scan.overruns++;
+    scan.next_half = half ^ 1;
+    scan.blocks++;
+    if ( scan.oversampling ) oversample_block(block);
+    if ( scan.on_block != NULL ) scan.on_block(block, scan.frames, scan.arg);
+}
+
+void DMA1_Channel1_IRQHandler(void) {
+    uint32_t isr = DMA1->ISR;
+
+    if ( isr & DMA_ISR_TEIF1 ) DMA1->IFCR = DMA_IFCR_CTEIF1;
+    // Both halves pending: the first one is already being overwritten
+    if ( ( isr & ( DMA_ISR_HTIF1 | DMA_ISR_TCIF1 ) ) == ( DMA_ISR_HTIF1 | DMA_ISR_TCIF1 ) ) {
+        scan.overruns++;
+    }
+    if ( isr & DMA_ISR_HTIF1 ) {
+        DMA1->IFCR = DMA_IFCR_CHTIF1;
+        block_done(0);
+    }
+    if ( isr & DMA_ISR_TCIF1 ) {
+        DMA1->IFCR = DMA_IFCR_CTCIF1;
+        block_done(1);
+    }
+}
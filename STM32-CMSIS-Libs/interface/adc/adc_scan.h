@@ -0,0 +1,90 @@
+#ifndef INTERFACE_ADC_SCAN_H
+#define INTERFACE_ADC_SCAN_H
+#include "stdint.h"
+#include "stdbool.h"
+#include "adc.h"
+
+// Length of the ADC1 regular sequence
+#define ADC_SCAN_MAX_CHANNELS   16
+
+// Oversampling: 4^n samples summed and shifted right by n give 12 + n bits
+#define ADC_SCAN_MAX_OVERSAMPLE 4
+
+// Fixed-rate scans are started by the update event of TIM3 (TRGO), which
+// counts at the APB1 timer clock
+#define ADC_SCAN_TIM_HZ         72000000UL
+
+/**
+ * @brief Called from the DMA interrupt when one half of the ring is full.
+ *        The other half is being written meanwhile, so the callback must be
+ *        done with `block` before that one fills up too.
+ * @param block  `frames` frames of one sample per channel, in scan order
+ */
+typedef void (*adc_scan_fn)(const uint16_t *block, uint16_t frames, void *arg);
+
+typedef struct {
+    const ADC_CHANNEL *channels;    // conversion order, copied by start
+    uint8_t count;                  // 1 .. ADC_SCAN_MAX_CHANNELS
+    ADC_SAMPLE_TIME sample_time;
+    uint16_t *buffer;               // ring of 2 * frames * count samples
+    uint16_t frames;                // frames per half
+    adc_scan_fn on_block;           // NULL: no interrupts unless oversampling
+    void *arg;
+    uint32_t sample_rate_hz;        // frames per second started by TIM3,
+                                    // 0: scan back to back at full speed
+    const uint8_t *oversample;      // per channel in scan order: n extra bits
+                                    // from 4^n samples, NULL: none
+} adc_scan_config_t;
+
+/**
+ * @brief  Convert the channel list continuously: ADC1 scans it and DMA1
+ *         channel 1 writes every frame into the circular buffer. Frames
+ *         follow each other back to back, or with `sample_rate_hz` each one
+ *         is started by TIM3 so they are evenly spaced whatever the CPU
+ *         does. The rate is rounded to ADC_SCAN_TIM_HZ / adc_scan_period().
+ *         Returns once the first frame is in, so adc_scan_latest() is valid.
+ *         Oversampled channels are summed block by block in the DMA
+ *         interrupt, which is then enabled even without `on_block`.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Invalid configuration (also an oversample above
+ *             ADC_SCAN_MAX_OVERSAMPLE).
+ *         - 2 A frame takes longer to convert than the sampling period.
+ */
+uint8_t adc_scan_start(const adc_scan_config_t *config);
+
+// Stop the scan; adc_get_single() converts on demand again
+void adc_scan_stop(void);
+
+bool adc_scan_running(void);
+
+// TIM3 clocks between two frames of a fixed-rate scan, 0 when back to back
+uint32_t adc_scan_period(void);
+
+/**
+ * @brief  Latest complete conversion of the channel at `index` in the scan
+ *         list, straight from the ring: no conversion, no waiting.
+ */
+uint16_t adc_scan_latest(uint8_t index);
+
+/**
+ * @brief  Latest conversion of `ch`.
+ * @return 0 if the channel is not part of the scan
+ */
+uint16_t adc_scan_get(ADC_CHANNEL ch);
+
+/**
+ * @brief  Latest oversampled result of the channel at `index`: the sum of
+ *         4^n consecutive samples shifted right by n, so 0 .. 2^(12 + n) - 1.
+ *         Extra bits are only real if the input carries at least about one
+ *         LSB of noise. Until the first sum is complete, and for channels
+ *         without oversampling, this is adc_scan_latest() << n.
+ */
+uint16_t adc_scan_oversampled(uint8_t index);
+
+// Halves served by the DMA interrupt, and halves that were already being
+// overwritten when their interrupt was served
+uint32_t adc_scan_blocks(void);
+uint32_t adc_scan_overruns(void);
+
+#endif
@@ -0,0 +1,134 @@
+#include "adc_watch.h"
+#include "stddef.h"
+#include "stm32f10x.h"
+
+enum { LEVEL_UNKNOWN, LEVEL_BELOW, LEVEL_ABOVE };
+
+static adc_watch_t *watches;
+static adc_watch_t *fast_watch;     // owner of the analog watchdog
+static volatile uint32_t events;
+
+static bool has_levels(const adc_watch_t *w) {
+    return !( w->low == 0 && w->high == 0xFFFF );
+}
+
+static void notify(adc_watch_t *w, ADC_WATCH_EVENT event, uint16_t value) {
+    events++;
+    w->fn(w, event, value, w->arg);
+}
+
+// Watchdog window of the fast subscriber: the side of the band it has to
+// cross next, or the whole band while the level is not known yet
+static void arm_window(const adc_watch_t *w) {
+    switch ( w->level ) {
+    case LEVEL_BELOW:
+        ADC1->LTR = 0;
+        ADC1->HTR = w->high > 0xFFF ? 0xFFF : w->high;
+        break;
+    case LEVEL_ABOVE:
+        ADC1->LTR = w->low;
+        ADC1->HTR = 0xFFF;
+        break;
+    default:
+        ADC1->LTR = w->low;
+        ADC1->HTR = w->high > 0xFFF ? 0xFFF : w->high;
+        break;
+    }
+}
+
+static void set_level(adc_watch_t *w, uint8_t level, uint16_t value) {
+    if ( level == w->level ) return;
+    w->level = level;
+    if ( w == fast_watch ) arm_window(w);
+    notify(w, level == LEVEL_ABOVE ? ADC_WATCH_ABOVE : ADC_WATCH_BELOW, value);
+}
+
+static void evaluate(adc_watch_t *w, uint16_t value) {
+    if ( has_levels(w) ) {
+        if ( value > w->high ) {
+            set_level(w, LEVEL_ABOVE, value);
+        } else if ( value < w->low ) {
+            set_level(w, LEVEL_BELOW, value);
+        }
+    }
+    if ( w->delta != 0 ) {
+        uint16_t moved = value > w->reported ? value - w->reported : w->reported - value;
+        if ( !w->started || moved >= w->delta ) {
+            w->reported = value;
+            notify(w, ADC_WATCH_CHANGE, value);
+        }
+    }
+    w->started = 1;
+}
+
+uint8_t adc_watch_add(adc_watch_t *watch) {
+    if ( watch->fn == NULL || watch->low > watch->high ) return 1;
+    if ( watch->fast && fast_watch != NULL && fast_watch != watch ) return 2;
+
+    adc_watch_remove(watch);
+    watch->level = LEVEL_UNKNOWN;
+    watch->reported = 0;
+    watch->started = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    watch->next = watches;
+    watches = watch;
+    __set_PRIMASK(primask);
+
+    if ( watch->fast ) {
+        // Analog watchdog on the one regular channel, interrupt when a
+        // conversion leaves [LTR, HTR]
+        fast_watch = watch;
+        arm_window(watch);
+        ADC1->SR = ~ADC_SR_AWD;
+        ADC1->CR1 = ( ADC1->CR1 & ~ADC_CR1_AWDCH ) | watch->channel |
+                    ADC_CR1_AWDSGL | ADC_CR1_AWDEN | ADC_CR1_AWDIE;
+        NVIC_EnableIRQ(ADC1_2_IRQn);
+    }
+    return 0;
+}
+
+void adc_watch_remove(adc_watch_t *watch) {
+    if ( watch == fast_watch ) {
+        // ADC1_2_IRQn stays enabled, the injected group shares it
+        ADC1->CR1 &= ~( ADC_CR1_AWDEN | ADC_CR1_AWDIE );
+        ADC1->SR = ~ADC_SR_AWD;
+        fast_watch = NULL;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for ( adc_watch_t **link = &watches; *link != NULL; link = &( *link )->next ) {
+        if ( *link == watch ) {
+            *link = watch->next;
+            break;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+void adc_watch_feed(ADC_CHANNEL ch, uint16_t value) {
+    for ( adc_watch_t *w = watches; w != NULL; w = w->next ) {
+        if ( w->channel == ch ) evaluate(w, value);
+    }
+}
+
+uint32_t adc_watch_events(void) {
+    return events;
+}
+
+void adc_watch_irq(void) {
+    ADC1->SR = ~ADC_SR_AWD;
+
+    adc_watch_t *w = fast_watch;
+    if ( w == NULL ) return;
+    // DR still holds the conversion that left the window: the next one of
+    // the scan is at least 14 ADC clocks away
+    uint16_t value = ADC1->DR & 0xFFF;
+    if ( value > w->high ) {
+        set_level(w, LEVEL_ABOVE, value);
+    } else if ( value < w->low ) {
+        set_level(w, LEVEL_BELOW, value);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef INTERFACE_ADC_WATCH_H
+#define INTERFACE_ADC_WATCH_H
+#include "stdint.h"
+#include "stdbool.h"
+#include "adc.h"
+
+// Threshold events on ADC channels, so readers sleep until a value moves.
+// Each subscriber watches one channel for:
+// - level crossings with hysteresis: ABOVE once the value exceeds `high`,
+//   BELOW once it drops under `low`, nothing while it stays in between;
+// - with `delta`, any move of at least `delta` from the last reported value.
+// Values come from adc_watch_feed(), typically once per scan block from the
+// on_block callback (block mean, filtered value...). One subscriber can be
+// `fast`: the ADC analog watchdog then compares every raw conversion of its
+// channel against the band it has to leave next, so a crossing is reported
+// one conversion after it happens instead of at the end of the block.
+//
+// Callbacks run in the interrupt that fed the value (DMA or ADC); queue the
+// work and call delay_idle_wakeup() from there. The DMA and ADC interrupts
+// must not preempt each other (same priority, the default).
+
+typedef enum _ADC_WATCH_EVENT {
+    ADC_WATCH_ABOVE,            // rose above high
+    ADC_WATCH_BELOW,            // fell under low
+    ADC_WATCH_CHANGE,           // moved by delta (or first value)
+} ADC_WATCH_EVENT;
+
+struct adc_watch;
+typedef void (*adc_watch_fn)(struct adc_watch *watch, ADC_WATCH_EVENT event, uint16_t value, void *arg);
+
+typedef struct adc_watch {
+    ADC_CHANNEL channel;
+    uint16_t low, high;         // hysteresis band, low <= high; low 0 and
+                                // high 0xFFFF: no level events
+    uint16_t delta;             // 0: level events only
+    bool fast;                  // use the analog watchdog (raw 12-bit counts)
+    adc_watch_fn fn;
+    void *arg;
+
+    // State
+    uint8_t level;
+    uint16_t reported;          // value of the last CHANGE event
+    bool started;
+    struct adc_watch *next;
+} adc_watch_t;
+
+/**
+ * @brief  Subscribe `watch` (owned by the caller, usually static) with its
+ *         channel, thresholds and callback filled in. The first value fed
+ *         reports CHANGE, and ABOVE or BELOW if it is outside the band; a
+ *         value starting inside the band reports the first crossing out.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Invalid band or callback.
+ *         - 2 `fast`, but another subscriber already has the watchdog.
+ */
+uint8_t adc_watch_add(adc_watch_t *watch);
+
+// Unsubscribe; releases the watchdog of a fast subscriber
+void adc_watch_remove(adc_watch_t *watch);
+
+// New value of `ch`: run its subscribers' thresholds
+void adc_watch_feed(ADC_CHANNEL ch, uint16_t value);
+
+// Events reported since start-up, hardware watchdog ones included
+uint32_t adc_watch_events(void);
+
+// Analog watchdog flag set, called from ADC1_2_IRQHandler()
+void adc_watch_irq(void);
+
+#endif
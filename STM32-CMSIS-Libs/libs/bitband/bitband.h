@@ -0,0 +1,50 @@
+#ifndef LIBS_BITBAND_H
+#define LIBS_BITBAND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "RTE_Components.h"
+#include CMSIS_device_header
+
+// Cortex-M3 bit-banding: each bit of the first megabyte of SRAM
+// (0x20000000) and of the peripherals (0x40000000) has its own word in an
+// alias region (0x22000000 / 0x42000000). Loading the word gives the bit as
+// 0 or 1; storing to it changes only that bit, in one read-modify-write the
+// bus performs atomically. So a control bit shared with an interrupt handler
+// needs no masking, and testing a status flag is one load, no AND.
+//
+// The macros take the register itself and its CMSIS mask (one bit set):
+//     while ( !BITBAND_READ(USART1->SR, USART_SR_TXE) ) {}
+//     BITBAND_SET(TIM5->DIER, TIM_DIER_CC1IE);
+// With a constant register and mask the alias address folds to a constant.
+//
+// Not for clearing rc_w0 flags (the SR registers): the write-back of the
+// other bits would clear a flag raised in between. Store ~flag to SR.
+//
+// The host build has no alias region (PERIPH_BB_BASE is not defined): the
+// same macros are plain reads and read-modify-writes there.
+
+#ifdef PERIPH_BB_BASE
+
+static inline volatile uint32_t *bitband_alias(const volatile void *reg, uint32_t mask) {
+    uintptr_t addr = (uintptr_t)reg;
+    uintptr_t base = addr >= PERIPH_BASE ? PERIPH_BB_BASE : SRAM_BB_BASE;
+    return (volatile uint32_t *)( base + ( addr & 0xFFFFF ) * 32u + __builtin_ctz(mask) * 4u );
+}
+
+#define BITBAND(reg, mask)              ( *bitband_alias(&(reg), (mask)) )
+#define BITBAND_READ(reg, mask)         ( (bool)BITBAND(reg, mask) )
+#define BITBAND_SET(reg, mask)          ( BITBAND(reg, mask) = 1 )
+#define BITBAND_CLEAR(reg, mask)        ( BITBAND(reg, mask) = 0 )
+#define BITBAND_WRITE(reg, mask, v)     ( BITBAND(reg, mask) = ( (v) != 0 ) )
+
+#else
+
+#define BITBAND_READ(reg, mask)         ( ( (reg) & (mask) ) != 0 )
+#define BITBAND_SET(reg, mask)          ( (reg) |= (mask) )
+#define BITBAND_CLEAR(reg, mask)        ( (reg) &= ~(mask) )
+#define BITBAND_WRITE(reg, mask, v)     ( (v) ? BITBAND_SET(reg, mask) : BITBAND_CLEAR(reg, mask) )
+
+#endif
+
+#endif
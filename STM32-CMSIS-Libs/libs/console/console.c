@@ -1,6 +1,7 @@
 #include "console.h"
 #include "Driver_Common.h"
 #include "Driver_USART.h"
+#include "../delay/delay.h"
 #include <stdint.h>
 #include <string.h>
 
@@ -22,6 +23,7 @@ void USART1_Event_Callback(uint32_t event) {
         rx_count = MAX_CHUNK_SIZE;
         Driver_USART1.Control(ARM_USART_ABORT_RECEIVE, 0);
         Driver_USART1.Receive(rx_buffer, MAX_CHUNK_SIZE);
+        delay_idle_wakeup();
 #if USE_CMSIS_OS
         osEventFlagsSet(consoleRxEventFlagsID, CONSOLE_RX_NEW_MSG_EVENT);
 #endif
@@ -32,6 +34,7 @@ void USART1_Event_Callback(uint32_t event) {
         rx_complete = true;
         Driver_USART1.Control(ARM_USART_ABORT_RECEIVE, 0);
         Driver_USART1.Receive(rx_buffer, MAX_CHUNK_SIZE);
+        delay_idle_wakeup();
 #if USE_CMSIS_OS
         osEventFlagsSet(consoleRxEventFlagsID, CONSOLE_RX_NEW_MSG_EVENT);
 #endif
@@ -70,10 +73,10 @@ int8_t console_info( uint8_t* msg, uint32_t len ) {
     int8_t res;
     res = Driver_USART1.Send("[INFO]: ", 8);
     if ( res != ARM_DRIVER_OK ) return res;
-    while ( Driver_USART1.GetStatus().tx_busy );
+    while ( Driver_USART1.GetStatus().tx_busy ) HW_SPIN_HOOK();
     res = Driver_USART1.Send( msg, len );
     if ( res != ARM_DRIVER_OK ) return res;
-    while ( Driver_USART1.GetStatus().tx_busy );
+    while ( Driver_USART1.GetStatus().tx_busy ) HW_SPIN_HOOK();
 #if USE_CMSIS_OS
     osStatus_t releaseStatus = osMutexRelease(consoleMutexId);
     if ( releaseStatus != osOK ) return releaseStatus;
@@ -89,10 +92,10 @@ int8_t console_debug( uint8_t* msg, uint32_t len ) {
     int8_t res;
     res = Driver_USART1.Send("[DEBUG]: ", 9);
     if ( res != ARM_DRIVER_OK ) return res;
-    while ( Driver_USART1.GetStatus().tx_busy );
+    while ( Driver_USART1.GetStatus().tx_busy ) HW_SPIN_HOOK();
     res = Driver_USART1.Send( msg, len );
     if ( res != ARM_DRIVER_OK ) return res;
-    while ( Driver_USART1.GetStatus().tx_busy );
+    while ( Driver_USART1.GetStatus().tx_busy ) HW_SPIN_HOOK();
 #if USE_CMSIS_OS
     osStatus_t releaseStatus = osMutexRelease(consoleMutexId);
     if ( releaseStatus != osOK ) return releaseStatus;
@@ -108,10 +111,10 @@ int8_t console_error( uint8_t* msg, uint32_t len ) {
     int8_t res;
     res = Driver_USART1.Send("[ERROR]: ", 9);
     if ( res != ARM_DRIVER_OK ) return res;
-    while ( Driver_USART1.GetStatus().tx_busy );
+    while ( Driver_USART1.GetStatus().tx_busy ) HW_SPIN_HOOK();
     res = Driver_USART1.Send( msg, len );
     if ( res != ARM_DRIVER_OK ) return res;
-    while ( Driver_USART1.GetStatus().tx_busy );
+    while ( Driver_USART1.GetStatus().tx_busy ) HW_SPIN_HOOK();
 #if USE_CMSIS_OS
     osStatus_t releaseStatus = osMutexRelease(consoleMutexId);
     if ( releaseStatus != osOK ) return releaseStatus;
@@ -127,7 +130,7 @@ int8_t console_hex( uint8_t* buf, uint32_t len ) {
     int8_t res;
     res = Driver_USART1.Send(buf, len);
     if ( res != ARM_DRIVER_OK ) return res;
-    while ( Driver_USART1.GetStatus().tx_busy );
+    while ( Driver_USART1.GetStatus().tx_busy ) HW_SPIN_HOOK();
 #if USE_CMSIS_OS
     osStatus_t releaseStatus = osMutexRelease(consoleMutexId);
     if ( releaseStatus != osOK ) return releaseStatus;
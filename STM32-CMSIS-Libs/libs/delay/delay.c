@@ -12,6 +12,56 @@ volatile uint32_t systick_counter = 0;
 
 volatile bool is_delay_inited = false;
 
+// TIM6 wraps counted by its update interrupt, upper bits of delay_get_us()
+static volatile uint32_t tim6_wraps = 0;
+
+static volatile bool idle_wakeup = false;
+#if USE_CMSIS_OS
+// Thread waiting in delay_idle(), woken by delay_idle_wakeup()
+static osThreadId_t volatile idle_thread = NULL;
+#endif
+
+#if DELAY_TICKLESS_IDLE
+static volatile bool idle_timer_fired = false;
+#if USE_CMSIS_OS == 0
+// Part of a millisecond that has passed but not been counted as a tick yet
+static uint32_t idle_carry_us = 0;
+#endif
+
+// TIM7: one-pulse 1 MHz timer used as the wake-up source while the tick is stopped
+static void idle_timer_init(void) {
+    RCC->APB1ENR |= RCC_APB1ENR_TIM7EN;
+    TIM7->PSC = 72 - 1;
+    TIM7->CR1 = TIM_CR1_OPM | TIM_CR1_URS;
+    TIM7->EGR = TIM_EGR_UG;     // 装载预分频值，URS 使其不产生中断
+    TIM7->SR = 0;
+    TIM7->DIER = TIM_DIER_UIE;
+    NVIC_EnableIRQ(TIM7_IRQn);
+}
+
+void TIM7_IRQHandler(void) {
+    TIM7->SR = 0;
+    idle_timer_fired = true;
+}
+
+// Sleep for up to `us` (1 ~ 65536) microseconds, return the time actually slept
+static uint32_t idle_timer_sleep(uint32_t us) {
+    idle_timer_fired = false;
+    TIM7->ARR = us - 1;
+    TIM7->CNT = 0;
+    TIM7->SR = 0;
+    TIM7->CR1 |= TIM_CR1_CEN;
+
+    __WFI();
+
+    uint32_t slept = (idle_timer_fired || (TIM7->SR & TIM_SR_UIF)) ? us : TIM7->CNT;
+    TIM7->CR1 &= ~TIM_CR1_CEN;
+    TIM7->SR = 0;
+    NVIC_ClearPendingIRQ(TIM7_IRQn);
+    return slept;
+}
+#endif
+
 void delay_init() {
     if ( is_delay_inited ) return;
 
@@ -36,11 +86,22 @@ void delay_init() {
     // 配置TIM6
     TIM6->PSC = 72 - 1;
     TIM6->ARR = 0xFFFF;
+    TIM6->CR1 = TIM_CR1_URS;
+    TIM6->EGR = TIM_EGR_UG;     // 装载预分频值，URS 使其不置位 UIF
     TIM6->CNT = 0;
+    TIM6->SR = 0;
+
+    // 溢出中断把计数扩展到 64 位，见 delay_get_us()
+    TIM6->DIER = TIM_DIER_UIE;
+    NVIC_EnableIRQ(TIM6_IRQn);
 
     // 启动定时器
     TIM6->CR1 |= TIM_CR1_CEN;
 
+    #if USE_CMSIS_OS == 0 && DELAY_TICKLESS_IDLE
+    idle_timer_init();
+    #endif
+
     is_delay_inited = true;
 }
 
@@ -51,6 +112,31 @@ void SysTick_Handler() {
 }
 #endif
 
+void TIM6_IRQHandler(void) {
+    // Clear and count in one step, so no reader sees the wrap twice or not at all
+    __disable_irq();
+    TIM6->SR = ~TIM_SR_UIF;
+    ++tim6_wraps;
+    __enable_irq();
+}
+
+uint64_t delay_get_us(void) {
+    if ( !is_delay_inited ) delay_init();
+    for (;;) {
+        uint32_t high = tim6_wraps;
+        uint32_t wraps = high;
+        uint16_t low = TIM6->CNT;
+        if (TIM6->SR & TIM_SR_UIF) {
+            // Wrapped but not counted yet (interrupts masked or about to run):
+            // re-read so that `low` is certainly after the wrap.
+            low = TIM6->CNT;
+            ++wraps;
+        }
+        // The interrupt ran in between: the two halves may not match, retry
+        if (high == tim6_wraps) return ((uint64_t)wraps << 16) | low;
+    }
+}
+
 uint32_t delay_get_tick() {
     if ( !is_delay_inited ) delay_init();
     #if USE_CMSIS_OS == 0
@@ -64,7 +150,7 @@ void delay_ms(uint32_t ms) {
     if ( !is_delay_inited ) delay_init();
     #if USE_CMSIS_OS == 0
     uint32_t start = systick_counter;
-    while (systick_counter - start < ms);
+    while (systick_counter - start < ms) HW_SPIN_HOOK();
     #else
     osDelay(ms);
     #endif
@@ -72,11 +158,11 @@ void delay_ms(uint32_t ms) {
 }
 
 // t: expiration time, prd: period, now: current time. Return true if expired
+// For more than a few periodic jobs use libs/sched instead of polling this.
 bool timer_expired(uint32_t *t, uint32_t prd, uint32_t now) {
     if ( !is_delay_inited ) delay_init();
-    if (now + prd < *t) *t = 0;                    // Time wrapped? Reset timer
     if (*t == 0) *t = now + prd;                   // First poll? Set expiration
-    if (*t > now) return false;                    // Not expired yet, return
+    if ((int32_t)(now - *t) < 0) return false;     // Not expired yet (wrap safe)
     *t = (now - *t) > prd ? now + prd : *t + prd;  // Next expiration time
     return true;                                   // Expired, return true
 }
@@ -91,10 +177,100 @@ void delay_us(uint16_t us) {
     // 检查是否会发生溢出
     if (target > start) {
         // 无溢出情况：直接等待
-        while (TIM6->CNT < target && TIM6->CNT >= start);
+        while (TIM6->CNT < target && TIM6->CNT >= start) HW_SPIN_HOOK();
     } else {
         // 会发生溢出：先等到溢出，再等到目标值
-        while (TIM6->CNT >= start);  // 等待溢出
-        while (TIM6->CNT < target);  // 等待到目标值
+        while (TIM6->CNT >= start) HW_SPIN_HOOK();  // 等待溢出
+        while (TIM6->CNT < target) HW_SPIN_HOOK();  // 等待到目标值
     }
 }
+
+void delay_idle_wakeup(void) {
+    idle_wakeup = true;
+    #if USE_CMSIS_OS
+    osThreadId_t thread = idle_thread;
+    if (thread != NULL) osThreadFlagsSet(thread, DELAY_IDLE_THREAD_FLAG);
+    #endif
+}
+
+#if USE_CMSIS_OS == 0
+void delay_idle(uint32_t ms) {
+    if ( !is_delay_inited ) delay_init();
+
+    __disable_irq();
+    if (idle_wakeup || ms == 0) {
+        idle_wakeup = false;
+        __enable_irq();
+        return;
+    }
+
+    #if DELAY_TICKLESS_IDLE
+    if (ms >= 2) {
+        if (ms > DELAY_IDLE_MAX_MS) ms = DELAY_IDLE_MAX_MS;
+
+        // 停止 SysTick，记录当前这 1 ms 已经过去的时间
+        SysTick->CTRL &= ~SysTick_CTRL_ENABLE;
+        uint32_t val = SysTick->VAL;    // 0: just restarted or just expired (then pending)
+        uint32_t total_us = idle_carry_us + (val ? (SysTick->LOAD - val) / 72 : 0);
+        if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+            // The tick expired right before it was stopped
+            SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+            total_us += 1000;
+        }
+
+        // The carry and the stopped tick may already cover the whole wait
+        if (total_us < ms * 1000) total_us += idle_timer_sleep(ms * 1000 - total_us);
+
+        // 补上睡眠期间的 tick，不足 1 ms 的部分留到下一次
+        uint32_t ticks = total_us / 1000;
+        idle_carry_us = total_us % 1000;
+        systick_counter += ticks;
+        lv_tick_inc(ticks);
+
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE;
+        __enable_irq();
+        return;
+    }
+    #endif
+
+    // Sleep until the next interrupt, at most until the next tick
+    __WFI();
+    __enable_irq();
+}
+#else
+void delay_idle(uint32_t ms) {
+    // Published before idle_wakeup is checked: a wake-up in between sets the
+    // flag, and the wait below returns at once
+    osThreadFlagsClear(DELAY_IDLE_THREAD_FLAG);
+    idle_thread = osThreadGetId();
+    if (idle_wakeup) {
+        idle_thread = NULL;
+        idle_wakeup = false;
+        return;
+    }
+    // RTX runs its idle thread (tickless below) while this thread waits
+    uint32_t flags = osThreadFlagsWait(DELAY_IDLE_THREAD_FLAG, osFlagsWaitAny, ms);
+    idle_thread = NULL;
+    if ((flags & osFlagsError) == 0) idle_wakeup = false;
+}
+
+#if DELAY_TICKLESS_IDLE
+// RTX idle thread: suspend the kernel tick and sleep on TIM7 until the next
+// timeout. Granularity is one kernel tick (1 ms, OS_TICK_FREQ).
+__NO_RETURN void osRtxIdleThread(void *argument) {
+    (void)argument;
+    idle_timer_init();
+
+    for (;;) {
+        uint32_t ticks = osKernelSuspend();
+        if (ticks == 0) {
+            osKernelResume(0);
+            continue;
+        }
+        if (ticks > DELAY_IDLE_MAX_MS) ticks = DELAY_IDLE_MAX_MS;
+        osKernelResume(idle_timer_sleep(ticks * 1000) / 1000);
+    }
+}
+#endif
+#endif
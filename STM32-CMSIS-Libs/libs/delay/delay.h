@@ -7,6 +7,20 @@
 #include "stdbool.h"
 #include "libs_common.h"
 
+// Stop the 1 ms tick while idle and wake up from TIM7 instead. Applies to
+// delay_idle() without RTOS and to the RTX idle thread with USE_CMSIS_OS.
+#ifndef DELAY_TICKLESS_IDLE
+#define DELAY_TICKLESS_IDLE 1
+#endif
+
+// Longest single tickless sleep; TIM7 counts microseconds in 16 bits.
+#define DELAY_IDLE_MAX_MS 60
+
+#if USE_CMSIS_OS
+// Thread flag used by delay_idle_wakeup() to wake the thread in delay_idle().
+#define DELAY_IDLE_THREAD_FLAG  0x20000000U
+#endif
+
 void delay_init();
 
 #if USE_CMSIS_OS == 0
@@ -14,8 +28,28 @@ void SysTick_Handler(void);
 #endif
 
 uint32_t delay_get_tick();
+
+/**
+ * @brief Microseconds since delay_init(). TIM6 counts the low 16 bits and its
+ *        update interrupt the rest, so the value is monotonic and never wraps.
+ *        Lock free and callable from any context, also with interrupts masked
+ *        as long as that lasts less than one TIM6 period (65 ms).
+ */
+uint64_t delay_get_us(void);
 void delay_ms( uint32_t ms );
 void delay_us( uint16_t us );
 bool timer_expired(uint32_t *t, uint32_t prd, uint32_t now);
 
+/**
+ * @brief Sleep (WFI) for up to `ms` milliseconds. Returns earlier when an
+ *        interrupt wakes the core, so callers re-check their events and
+ *        deadlines afterwards. The tick count stays exact across the sleep.
+ */
+void delay_idle(uint32_t ms);
+
+// Make the current or next delay_idle() return at once. Interrupt safe; call
+// it from handlers that queue work for the main loop. With USE_CMSIS_OS it
+// wakes the thread waiting in delay_idle() (one at a time).
+void delay_idle_wakeup(void);
+
 #endif
\ No newline at end of file
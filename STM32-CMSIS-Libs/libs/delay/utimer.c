@@ -0,0 +1,160 @@
+#include "utimer.h"
+#include "delay.h"
+#include "../bitband/bitband.h"
+#include <stddef.h>
+
+// Largest step programmed into the 16 bit compare register at once
+#define UTIMER_MAX_STEP 0x8000
+
+static utimer_t *queue = NULL;          // pending timers ordered by deadline
+static volatile uint16_t overflows = 0; // upper half of utimer_now()
+static bool is_utimer_inited = false;
+
+static bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+uint8_t utimer_init(void) {
+    if ( is_utimer_inited ) return 0;
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+
+    TIM5->PSC = 72 - 1;         // 1 MHz
+    TIM5->ARR = 0xFFFF;
+    TIM5->CNT = 0;
+    TIM5->EGR = TIM_EGR_UG;     // 装载预分频值
+    TIM5->SR = 0;
+    TIM5->DIER = TIM_DIER_UIE;  // 溢出中断用于扩展到 32 位
+    NVIC_EnableIRQ(TIM5_IRQn);
+    TIM5->CR1 |= TIM_CR1_CEN;
+
+    is_utimer_inited = true;
+    return 0;
+}
+
+uint32_t utimer_now(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint16_t high = overflows;
+    uint16_t low = TIM5->CNT;
+    // An overflow not yet counted by the interrupt: CNT already wrapped
+    if ((TIM5->SR & TIM_SR_UIF) && low < 0x8000) ++high;
+    __set_PRIMASK(primask);
+    return ((uint32_t)high << 16) | low;
+}
+
+// Program the compare channel for the head of the queue. Called with
+// interrupts disabled.
+static void arm_compare(void) {
+    if (queue == NULL) {
+        BITBAND_CLEAR(TIM5->DIER, TIM_DIER_CC1IE);
+        return;
+    }
+    int32_t left = (int32_t)(queue->due - utimer_now());
+    if (left > UTIMER_MAX_STEP) left = UTIMER_MAX_STEP;
+    if (left < 1) left = 1;
+
+    TIM5->CCR1 = (uint16_t)(TIM5->CNT + left);
+    TIM5->SR = ~TIM_SR_CC1IF;
+    BITBAND_SET(TIM5->DIER, TIM_DIER_CC1IE);
+
+    // Deadline passed while programming: make sure the interrupt runs
+    if (!before(utimer_now(), queue->due)) NVIC_SetPendingIRQ(TIM5_IRQn);
+}
+
+uint8_t utimer_start_at(utimer_t *timer, uint32_t due, utimer_fn_t fn, void *arg) {
+    if ( !is_utimer_inited ) utimer_init();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (timer->pending) {
+        __set_PRIMASK(primask);
+        return 1;
+    }
+    timer->fn = fn;
+    timer->arg = arg;
+    timer->due = due;
+    timer->pending = true;
+
+    utimer_t **p = &queue;
+    while (*p != NULL && !before(due, (*p)->due)) p = &(*p)->next;
+    timer->next = *p;
+    *p = timer;
+    if (queue == timer) arm_compare();
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+uint8_t utimer_start(utimer_t *timer, uint32_t us, utimer_fn_t fn, void *arg) {
+    return utimer_start_at(timer, utimer_now() + us, fn, arg);
+}
+
+void utimer_cancel(utimer_t *timer) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (timer->pending) {
+        for (utimer_t **p = &queue; *p != NULL; p = &(*p)->next) {
+            if (*p == timer) {
+                *p = timer->next;
+                break;
+            }
+        }
+        timer->pending = false;
+        arm_compare();
+    }
+    __set_PRIMASK(primask);
+}
+
+void TIM5_IRQHandler(void) {
+    if (TIM5->SR & TIM_SR_UIF) {
+        TIM5->SR = ~TIM_SR_UIF;
+        ++overflows;
+    }
+    TIM5->SR = ~TIM_SR_CC1IF;
+
+    // Run everything that is due, then re-arm for the next deadline
+    __disable_irq();
+    while (queue != NULL && !before(utimer_now(), queue->due)) {
+        utimer_t *timer = queue;
+        queue = timer->next;
+        timer->pending = false;
+        __enable_irq();
+        timer->fn(timer->arg);
+        __disable_irq();
+    }
+    arm_compare();
+    __enable_irq();
+}
+
+static void wake_sleeper(void *arg) {
+#if USE_CMSIS_OS
+    osThreadFlagsSet((osThreadId_t)arg, UTIMER_THREAD_FLAG);
+#else
+    (void)arg;
+#endif
+}
+
+void utimer_sleep_us(uint32_t us) {
+    if (us < UTIMER_MIN_SLEEP_US) {
+        delay_us((uint16_t)us);
+        return;
+    }
+
+    utimer_t timer = { 0 };
+#if USE_CMSIS_OS
+    osThreadFlagsClear(UTIMER_THREAD_FLAG);
+    utimer_start(&timer, us, wake_sleeper, osThreadGetId());
+    osThreadFlagsWait(UTIMER_THREAD_FLAG, osFlagsWaitAny, osWaitForever);
+#else
+    utimer_start(&timer, us, wake_sleeper, NULL);
+    // Checked with interrupts masked: an expiry between the check and WFI
+    // stays pending and still ends the WFI, instead of being missed
+    __disable_irq();
+    while (timer.pending) {
+        __WFI();
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
+#endif
+}
@@ -0,0 +1,68 @@
+#ifndef UTIMER_H
+#define UTIMER_H
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+#include <stdint.h>
+#include <stdbool.h>
+#include "libs_common.h"
+
+// One-shot microsecond timers on TIM5 (1 MHz, compare channel 1). Any number
+// of timers can be pending; they share the compare channel in deadline
+// order. Callbacks run in the TIM5 interrupt, so keep them short and do not
+// call blocking functions from them.
+
+// Waits shorter than this are busy-waited by utimer_sleep_us(): below it a
+// context switch costs more than it saves.
+#define UTIMER_MIN_SLEEP_US 20
+
+#if USE_CMSIS_OS
+// Thread flag used by utimer_sleep_us() to wake the sleeping thread.
+#define UTIMER_THREAD_FLAG  0x40000000U
+#endif
+
+typedef void (*utimer_fn_t)(void *arg);
+
+typedef struct utimer {
+    utimer_fn_t fn;
+    void *arg;
+    uint32_t due;               // utimer_now() value of the deadline
+    struct utimer *next;
+    volatile bool pending;
+} utimer_t;
+
+/**
+ * @brief  Start TIM5 as the free running 1 MHz time base.
+ * @return status code
+ *         - 0 success
+ */
+uint8_t utimer_init(void);
+
+// Microseconds since utimer_init(), wraps after ~71 minutes.
+uint32_t utimer_now(void);
+
+/**
+ * @brief  Call `fn(arg)` from the TIM5 interrupt `us` microseconds from now.
+ * @return status code
+ *         - 0 success
+ *         - 1 the timer is already pending
+ */
+uint8_t utimer_start(utimer_t *timer, uint32_t us, utimer_fn_t fn, void *arg);
+
+/**
+ * @brief  Same as utimer_start() with an absolute deadline, so periodic
+ *         callbacks re-armed from their handler do not drift.
+ */
+uint8_t utimer_start_at(utimer_t *timer, uint32_t due, utimer_fn_t fn, void *arg);
+
+// Cancel a pending timer; nothing happens if it already fired.
+void utimer_cancel(utimer_t *timer);
+
+/**
+ * @brief Wait `us` microseconds without spinning: the calling thread blocks
+ *        on UTIMER_THREAD_FLAG with USE_CMSIS_OS, otherwise the core sleeps
+ *        in WFI. Short waits fall back to delay_us().
+ */
+void utimer_sleep_us(uint32_t us);
+
+#endif
@@ -1,6 +1,15 @@
 #include "dht11.h"
 #include "../delay/delay.h"
+#include "../delay/utimer.h"
+#include "../bitband/bitband.h"
 #include <stdint.h>
+#include <stddef.h>
+
+dht11_sensor_t dht11_board = DHT11_SENSOR(DHT11_GPIO_BANK, DHT11_PIN_NUM, DHT11_TYPE_DHT11, "board");
+
+// Sensor owning each EXTI line, and the lines that have one
+static dht11_sensor_t *line_sensor[16];
+static volatile uint16_t sensor_lines = 0;
 
 static uint8_t save_data_from_buf( uint8_t *buf, dht11_dt *dest ) {
     dest->negative = ((1<<7) & buf[3]) ? 1 : 0;
@@ -12,6 +21,28 @@ static uint8_t save_data_from_buf( uint8_t *buf, dht11_dt *dest ) {
     return 0;
 }
 
+// DHT22: humidity and temperature are 16 bit in 0.1 units, sign in bit 15
+static uint8_t save_data_from_buf_dht22( uint8_t *buf, dht11_dt *dest ) {
+    uint16_t humidity = (buf[0] << 8) | buf[1];
+    uint16_t temp = ((buf[2] & 0x7F) << 8) | buf[3];
+    dest->negative = (buf[2] & 0x80) ? 1 : 0;
+    dest->temp = temp / 10;
+    dest->temp_dec = temp % 10;
+    dest->humity = humidity / 10;
+    dest->humity_dec = humidity % 10;
+    dest->check = buf[4];
+    return 0;
+}
+
+static gpio_pin_t sensor_pin(const dht11_sensor_t *sensor) {
+    return GPIO_PIN(sensor->bank, sensor->pin);
+}
+
+static IRQn_Type exti_irq(uint8_t line) {
+    if (line < 5) return (IRQn_Type)(EXTI0_IRQn + line);
+    return line < 10 ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
 // Reset DHT11.
 void dht11_rst(void)
 {
@@ -48,88 +79,166 @@ uint8_t dht11_check(void)
     return 0;
 }
 
-static uint8_t dht11_read_bit(void)
-{
-    uint16_t retry = 0;
-    
-    // 等待变为低电平（每个位开始）
-    while(DHT11_DQ_IN && retry < 100) 
-    {
-        retry++;
-        delay_us(1);
+// Decode the 40 bits from the captured edge timestamps
+static uint8_t decode_edges(dht11_sensor_t *sensor) {
+    uint8_t buf[5] = { 0 };
+
+    for (uint8_t i = 0; i < 40; i++) {
+        uint16_t period = sensor->edges[i + 2] - sensor->edges[i + 1];
+        buf[i / 8] = (buf[i / 8] << 1) | (period > DHT11_BIT1_MIN_US);
     }
-    if(retry >= 100) return 0; // 超时，返回0
-    
-    retry = 0;
-    // 等待变高电平（数据位）
-    while(!DHT11_DQ_IN && retry < 100) 
-    {
-        retry++;
-        delay_us(1);
+
+    uint8_t checksum = buf[0] + buf[1] + buf[2] + buf[3];
+    if ( checksum != buf[4] ) return 2;
+    if ( sensor->type == DHT11_TYPE_DHT22 ) save_data_from_buf_dht22(buf, sensor->dest);
+    else save_data_from_buf(buf, sensor->dest);
+    return 0;
+}
+
+static void read_finish(dht11_sensor_t *sensor, uint8_t status) {
+    __disable_irq();
+    if ( !sensor->busy ) {
+        // The other of timeout / last edge got here first
+        __enable_irq();
+        return;
     }
-    if(retry >= 100) return 0; // 超时，返回0
-    
-    // Bit 0 -> 23-27us 高电平
-    // Bit 1 -> 68-74us 高电平
-    // 如果高电平持续时间较长，则为'1'，否则为'0'
-    // 延时50ms后检测当前为高电平还是低电平
-    // 不能使用 delay_us(1) 来计算持续了多少微秒
-    // 因为在 1us 时间内 delay_us 调用的时间就已经远大于 1us
-    delay_us(50);
-    if(DHT11_DQ_IN) return 1;
-    else return 0;
-}
-
-static uint8_t dht11_read_byte(void)
-{
-    uint8_t i, dat;
-    dat = 0;
-    
-    for (i = 0; i < 8; i++)
-    {
-        dat <<= 1;
-        dat |= dht11_read_bit();
+    BITBAND_CLEAR(EXTI->IMR, 1u << sensor->pin);
+    utimer_cancel(&sensor->timer);
+    if ( status == 0 ) status = decode_edges(sensor);
+    sensor->busy = false;
+    __enable_irq();
+
+    if ( sensor->done != NULL ) sensor->done(status, sensor->arg);
+}
+
+static void read_timeout(void *arg) {
+    read_finish(arg, 1);    // No answer, or fewer edges than a full frame
+}
+
+// End of the start signal: release the line and capture the answer
+static void start_released(void *arg) {
+    dht11_sensor_t *sensor = arg;
+    gpio_pin_high(sensor_pin(sensor));
+    gpio_pin_config(sensor_pin(sensor), GPIO_CFG_IN_PULL);
+
+    sensor->edge_count = 0;
+    EXTI->PR = 1u << sensor->pin;
+    BITBAND_SET(EXTI->IMR, 1u << sensor->pin);
+    utimer_start(&sensor->timer, DHT11_TIMEOUT_US, read_timeout, sensor);
+}
+
+void dht11_exti_irq(void) {
+    uint16_t now = (uint16_t)delay_get_us();
+    uint32_t lines = EXTI->PR & EXTI->IMR & sensor_lines;
+    EXTI->PR = lines;
+
+    while ( lines != 0 ) {
+        dht11_sensor_t *sensor = line_sensor[__builtin_ctz(lines)];
+        lines &= lines - 1;
+
+        uint8_t n = sensor->edge_count;
+        if ( n >= DHT11_EDGES ) continue;
+        sensor->edges[n] = now;
+        sensor->edge_count = ++n;
+        if ( n == DHT11_EDGES ) read_finish(sensor, 0);
     }
-    
-    return dat;
+}
+
+void DHT11_EXTI_IRQHandler(void) {
+    dht11_exti_irq();
+}
+
+uint8_t dht11_sensor_read_async(dht11_sensor_t *sensor, dht11_dt *datavalue,
+                                dht11_done_fn done, void *arg) {
+    __disable_irq();
+    if ( sensor->busy ) {
+        __enable_irq();
+        return 3;
+    }
+    sensor->busy = true;
+    __enable_irq();
+
+    sensor->dest = datavalue;
+    sensor->done = done;
+    sensor->arg = arg;
+
+    // Start signal: hold the line low
+    gpio_pin_config(sensor_pin(sensor), GPIO_CFG_OUT_PP_50MHZ);
+    gpio_pin_low(sensor_pin(sensor));
+    uint32_t start_us = sensor->type == DHT11_TYPE_DHT22 ? DHT22_START_US : DHT11_START_US;
+    utimer_start(&sensor->timer, start_us, start_released, sensor);
+    return 0;
+}
+
+bool dht11_sensor_busy(const dht11_sensor_t *sensor) {
+    return sensor->busy;
+}
+
+static void read_done(uint8_t status, void *arg) {
+    *(volatile uint8_t *)arg = status;
+}
+
+uint8_t dht11_sensor_read(dht11_sensor_t *sensor, dht11_dt *datavalue) {
+    volatile uint8_t status = 0xFF;
+
+    if ( dht11_sensor_read_async(sensor, datavalue, read_done, (void *)&status) != 0 ) return 1;
+    #if USE_CMSIS_OS
+    while ( status == 0xFF ) osDelay(1);
+    #else
+    // Masked around the check so the completion cannot slip in before WFI
+    __disable_irq();
+    while ( status == 0xFF ) {
+        __WFI();
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
+    #endif
+    return status;
+}
+
+uint8_t dht11_sensor_init(dht11_sensor_t *sensor) {
+    uint8_t line = sensor->pin;
+
+    gpio_pin_clock_enable(sensor_pin(sensor));
+    RCC->APB2ENR |= RCC_APB2ENR_AFIOEN;
+    gpio_pin_high(sensor_pin(sensor));
+    gpio_pin_config(sensor_pin(sensor), GPIO_CFG_IN_PULL);
+
+    // EXTI line of the pin, falling edges, masked until a read starts
+    BITBAND_CLEAR(EXTI->IMR, 1u << line);
+    AFIO->EXTICR[line / 4] &= ~(0xF << ((line % 4) * 4));
+    AFIO->EXTICR[line / 4] |= (uint32_t)(sensor->bank - 'A') << ((line % 4) * 4);
+    BITBAND_CLEAR(EXTI->RTSR, 1u << line);
+    BITBAND_SET(EXTI->FTSR, 1u << line);
+    line_sensor[line] = sensor;
+    sensor_lines |= 1u << line;
+    NVIC_EnableIRQ(exti_irq(line));
+
+    // Any answer, even with a bad checksum, means the sensor is there
+    dht11_dt data;
+    return dht11_sensor_read(sensor, &data) == 1 ? 1 : 0;
 }
 
 // Read datas from DHT11.
 uint8_t dht11_read(dht11_dt *datavalue)
 {
-    uint8_t buf[5];
-    uint8_t i;
-    
-    dht11_rst();
-    
-    uint8_t check_result = dht11_check();
-    if(check_result == 0)
-    {
-        for(i = 0; i < 5; i++) 
-        {
-            buf[i] = dht11_read_byte();
-        }
-        
-        uint8_t checksum = buf[0] + buf[1] + buf[2] + buf[3];
-        
-        if ( checksum == buf[4] ) {
-            save_data_from_buf(buf, datavalue);
-        }
-        
-        // 0 -> Success, 2-> Checksum falied.
-        return ( checksum == buf[4] ) ? 0 : 2;
-    }
-    else
-    {
-        return 1; // Failed to communicate with DHT11.
-    }
+    return dht11_sensor_read(&dht11_board, datavalue);
+}
+
+uint8_t dht11_read_async(dht11_dt *datavalue, dht11_done_fn done, void *arg) {
+    return dht11_sensor_read_async(&dht11_board, datavalue, done, arg);
+}
+
+bool dht11_busy(void) {
+    return dht11_sensor_busy(&dht11_board);
 }
 
 // Init DHT11
 uint8_t dht11_init(void)
 {
     // 使能 DHT11 所在 Pin 的时钟
-    RCC->APB2ENR |= DHT11_GPIO_CLK;
+    gpio_pin_clock_enable(DHT11_PIN);
     
     // 配置GPIO为推挽输出
     DHT11_IO_OUT();
@@ -138,7 +247,5 @@ uint8_t dht11_init(void)
     // DHT11需要上电后至少1秒才能稳定
     delay_ms(1500);  // 等待1.5秒确保稳定
     
-    dht11_rst();
-    
-    return dht11_check();
+    return dht11_sensor_init(&dht11_board);
 }
@@ -2,15 +2,32 @@
 #define __DHT11_H
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "RTE_Components.h"
 #include CMSIS_device_header
+#include "../delay/utimer.h"
+#include "../gpio/gpio_pin.h"
 
-// DHT11 GPIO
-#define DHT11_GPIO_PORT     GPIOC
+// DHT11 GPIO of the board sensor
+#define DHT11_GPIO_BANK     'C'
 #define DHT11_PIN_NUM       4
-#define DHT11_GPIO_PIN      (1 << DHT11_PIN_NUM)
-#define DHT11_GPIO_CLK      RCC_APB2ENR_IOPCEN
+#define DHT11_PIN           GPIO_PIN(DHT11_GPIO_BANK, DHT11_PIN_NUM)
 
+// EXTI interrupt of the board sensor's line; dht11_exti_irq() is called from
+// it. Sensors on other lines call dht11_exti_irq() from their own handler.
+#define DHT11_EXTI_IRQn         EXTI4_IRQn
+#define DHT11_EXTI_IRQHandler   EXTI4_IRQHandler
+
+// Falling edges of one transfer: response, 40 bit starts and the stop bit.
+// The time between two falling edges is 50 us low plus 26 us (0) or 70 us (1)
+// high, so a bit is 1 when its period is longer than DHT11_BIT1_MIN_US.
+#define DHT11_EDGES             42
+#define DHT11_BIT1_MIN_US       100
+// The answer takes ~5 ms after the start signal is released
+#define DHT11_TIMEOUT_US        10000
+// Start signal: DHT11 needs at least 18 ms low, DHT22/AM2302 at least 1 ms
+#define DHT11_START_US          20000
+#define DHT22_START_US          2000
 
 // DHT11数据结构
 typedef struct {
@@ -22,38 +39,97 @@ typedef struct {
     _Bool negative;     // 是否为负数
 } dht11_dt;
 
+typedef enum {
+    DHT11_TYPE_DHT11 = 0,   // 1 C / 1 %RH, bytes are integer and decimal parts
+    DHT11_TYPE_DHT22,       // DHT22 / AM2302: 16-bit values in 0.1 units
+} dht11_type_t;
+
+/**
+ * @brief Called when an asynchronous read finishes, from interrupt context.
+ * @param status same codes as dht11_read()
+ */
+typedef void (*dht11_done_fn)(uint8_t status, void *arg);
+
+// One sensor on its own pin. Pins of different sensors must have different
+// numbers, since each number is one EXTI line. Owned by the caller (usually
+// static); only bank, pin, type and name are set by the caller.
+typedef struct dht11_sensor {
+    char bank;                  // 'A' .. 'G'
+    uint8_t pin;                // 0 .. 15
+    dht11_type_t type;
+    const char *name;           // for console output, may be NULL
+
+    // Read in progress
+    volatile bool busy;
+    dht11_dt *dest;
+    dht11_done_fn done;
+    void *arg;
+    utimer_t timer;             // end of the start signal, then the timeout
+    volatile uint8_t edge_count;
+    uint16_t edges[DHT11_EDGES];    // falling edges, low 16 bits of delay_get_us()
+} dht11_sensor_t;
+
+#define DHT11_SENSOR(b, p, t, n)    { .bank = (b), .pin = (p), .type = (t), .name = (n) }
+
+// The sensor on the board, PC4
+extern dht11_sensor_t dht11_board;
+
 // Set the PIN to Input with pull-up / pull-down Mode ( 0x8 -> 0b1000 )
-#define DHT11_IO_IN()   do { \
-    if(DHT11_PIN_NUM < 8) { \
-        DHT11_GPIO_PORT->CRL &= ~(0xF << (DHT11_PIN_NUM * 4)); \
-        DHT11_GPIO_PORT->CRL |= (0x8 << (DHT11_PIN_NUM * 4)); \
-    } else { \
-        DHT11_GPIO_PORT->CRH &= ~(0xF << ((DHT11_PIN_NUM - 8) * 4)); \
-        DHT11_GPIO_PORT->CRH |= (0x8 << ((DHT11_PIN_NUM - 8) * 4)); \
-    } \
-} while(0)
+#define DHT11_IO_IN()       gpio_pin_config(DHT11_PIN, GPIO_CFG_IN_PULL)
 
 // Set the PIN to Push-pull Output Mode ( 0x3 -> 0b0011 )
-#define DHT11_IO_OUT()  do { \
-    if(DHT11_PIN_NUM < 8) { \
-        DHT11_GPIO_PORT->CRL &= ~(0xF << (DHT11_PIN_NUM * 4)); \
-        DHT11_GPIO_PORT->CRL |= (0x3 << (DHT11_PIN_NUM * 4)); \
-    } else { \
-        DHT11_GPIO_PORT->CRH &= ~(0xF << ((DHT11_PIN_NUM - 8) * 4)); \
-        DHT11_GPIO_PORT->CRH |= (0x3 << ((DHT11_PIN_NUM - 8) * 4)); \
-    } \
-} while(0)
+#define DHT11_IO_OUT()      gpio_pin_config(DHT11_PIN, GPIO_CFG_OUT_PP_50MHZ)
 
 // Set the output of the DHT11 PIN
-#define DHT11_DQ_OUT(x)  do { \
-    if(x) DHT11_GPIO_PORT->BSRR = DHT11_GPIO_PIN; \
-    else DHT11_GPIO_PORT->BRR = DHT11_GPIO_PIN; \
-} while(0)
+#define DHT11_DQ_OUT(x)     gpio_pin_write(DHT11_PIN, (x))
 
 // Read the input of the DHT11 PIN
-#define DHT11_DQ_IN      (DHT11_GPIO_PORT->IDR & DHT11_GPIO_PIN)
+#define DHT11_DQ_IN         gpio_pin_read(DHT11_PIN)
+
+
+/**
+ * @brief  Set up the pin and its EXTI line and check that the sensor answers.
+ *         Sensors need ~1 s after power-up before the first read; wait for
+ *         that before calling this.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Timed out.
+ */
+uint8_t dht11_sensor_init(dht11_sensor_t *sensor);
 
+/**
+ * @brief  Start a read without blocking. The start signal is timed by utimer
+ *         and the answer is captured as falling-edge timestamps by the EXTI
+ *         interrupt of the pin, then decoded in one pass. `datavalue` is
+ *         written before `done` runs and only if the read succeeded.
+ * @return status code
+ *         - 0 Started.
+ *         - 3 A read of this sensor is already in progress.
+ */
+uint8_t dht11_sensor_read_async(dht11_sensor_t *sensor, dht11_dt *datavalue,
+                                dht11_done_fn done, void *arg);
+
+/**
+ * @brief  Read a sensor, the CPU sleeps while the interrupts do the transfer.
+ * @return status code, see dht11_read()
+ */
+uint8_t dht11_sensor_read(dht11_sensor_t *sensor, dht11_dt *datavalue);
+
+// True while a read of the sensor is in progress
+bool dht11_sensor_busy(const dht11_sensor_t *sensor);
+
+// Capture edges of every sensor being read; call from the EXTI handler of
+// each line that has a sensor other than the board one.
+void dht11_exti_irq(void);
 
+/* The functions below act on the board sensor, dht11_board. */
+
+/**
+ * @brief  Power-up wait, then dht11_sensor_init(&dht11_board).
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Timed out.
+ */
 uint8_t dht11_init(void);
 /**
  * @brief  Check the connectivity between DHT11 and MCU.
@@ -74,4 +150,10 @@ uint8_t dht11_check(void);
 uint8_t dht11_read(dht11_dt *datavalue);
 void dht11_rst(void);
 
+// dht11_sensor_read_async(&dht11_board, ...)
+uint8_t dht11_read_async(dht11_dt *datavalue, dht11_done_fn done, void *arg);
+
+// True while a read of the board sensor is in progress
+bool dht11_busy(void);
+
 #endif /* __DHT11_H */
@@ -0,0 +1,284 @@
+#include "dht11_service.h"
+#include "../console/console.h"
+#include "../delay/delay.h"
+#include "../delay/utimer.h"
+#include <stddef.h>
+#include <stdio.h>
+
+// One read on the bus at a time; due services queue up behind it
+static dht11_service_t *bus_owner = NULL;
+static dht11_service_t *wait_head = NULL;
+static dht11_service_t **wait_tail = &wait_head;
+
+static uint64_t last_first_read_us = 0;
+static bool has_first_read = false;
+
+static int16_t temp_x10(const dht11_dt *d) {
+    int16_t t = d->temp * 10 + d->temp_dec;
+    return d->negative ? -t : t;
+}
+
+static void set_temp_x10(dht11_dt *d, int16_t t) {
+    d->negative = t < 0;
+    if ( t < 0 ) t = -t;
+    d->temp = t / 10;
+    d->temp_dec = t % 10;
+}
+
+// Median of a small window by insertion sort
+static int16_t median_of(const int16_t *values, uint8_t count) {
+    int16_t sorted[DHT11_MEDIAN_N];
+    for (uint8_t i = 0; i < count; i++) {
+        int16_t v = values[i];
+        uint8_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+        sorted[j] = v;
+    }
+    return sorted[count / 2];
+}
+
+static bool is_spike(int16_t delta, int16_t limit) {
+    return delta > limit || delta < -limit;
+}
+
+// Return true if the reading was accepted into the filter
+static bool filter_push(dht11_service_t *svc, const dht11_dt *d) {
+    int16_t t = temp_x10(d);
+    int16_t h = d->humity * 10 + d->humity_dec;
+
+    // Outside anything a DHT11/DHT22 can report: a bit error the checksum missed
+    if ( h > 1000 || t < -400 || t > 800 ) return false;
+
+    if ( svc->window_count > 0 ) {
+        bool spike = is_spike(t - svc->median_temp, DHT11_SPIKE_TEMP_X10) ||
+                     is_spike(h - svc->median_humi, DHT11_SPIKE_HUMI_X10);
+        if ( spike ) {
+            // Only readings that agree with the first spike confirm a step;
+            // an unrelated one starts over from itself
+            bool agrees = svc->spike_count > 0 &&
+                          !is_spike(t - svc->spike_temp, DHT11_SPIKE_TEMP_X10) &&
+                          !is_spike(h - svc->spike_humi, DHT11_SPIKE_HUMI_X10);
+            if ( !agrees ) {
+                svc->spike_count = 0;
+                svc->spike_temp = t;
+                svc->spike_humi = h;
+            }
+            if ( ++svc->spike_count < DHT11_SPIKE_CONFIRM ) return false;
+            // It persisted: follow the step at once
+            svc->window_count = 0;
+            svc->window_pos = 0;
+        }
+    }
+    svc->spike_count = 0;
+
+    svc->window_temp[svc->window_pos] = t;
+    svc->window_humi[svc->window_pos] = h;
+    svc->window_pos = (svc->window_pos + 1) % DHT11_MEDIAN_N;
+    if ( svc->window_count < DHT11_MEDIAN_N ) svc->window_count++;
+
+    svc->median_temp = median_of(svc->window_temp, svc->window_count);
+    svc->median_humi = median_of(svc->window_humi, svc->window_count);
+    return true;
+}
+
+static void period_fn(void *arg);
+
+// Bring the next read forward after a failure, doubling the wait each time
+static bool schedule_retry(dht11_service_t *svc, uint16_t failures) {
+    uint8_t shift = failures - 1 < DHT11_BACKOFF_MAX ? failures - 1 : DHT11_BACKOFF_MAX;
+    uint32_t wait_us = (DHT11_MIN_INTERVAL_MS * 1000UL) << shift;
+    if ( wait_us >= svc->period_us || !svc->timer.pending ) return false;
+
+    utimer_cancel(&svc->timer);
+    utimer_start(&svc->timer, wait_us, period_fn, svc);
+    return true;
+}
+
+static void read_done(uint8_t status, void *arg);
+
+// Start the read now; called with interrupts disabled and the bus free
+static bool bus_begin(dht11_service_t *svc) {
+    if ( dht11_sensor_read_async(svc->sensor, &svc->reading, read_done, svc) != 0 ) return false;
+    bus_owner = svc;
+    svc->last_start_us = delay_get_us();
+    svc->has_started = true;
+    return true;
+}
+
+// Hand the bus to the first waiting service that can start
+static void bus_release(void) {
+    bus_owner = NULL;
+    while ( bus_owner == NULL && wait_head != NULL ) {
+        dht11_service_t *svc = wait_head;
+        wait_head = svc->next_waiting;
+        if ( wait_head == NULL ) wait_tail = &wait_head;
+        svc->waiting = false;
+        bus_begin(svc);
+    }
+}
+
+// Single writer of the sample: runs in the interrupt that completes the read
+static void read_done(uint8_t status, void *arg) {
+    dht11_service_t *svc = arg;
+    dht11_sample_t *s = &svc->sample;
+
+    if ( status == 0 && !filter_push(svc, &svc->reading) ) status = 4;
+
+    svc->seq++;
+    __COMPILER_BARRIER();
+
+    s->last_status = status;
+    s->reads++;
+    if ( status == 0 ) {
+        s->data = svc->reading;
+        set_temp_x10(&s->data, svc->median_temp);
+        s->data.humity = svc->median_humi / 10;
+        s->data.humity_dec = svc->median_humi % 10;
+        s->time_us = delay_get_us();
+        s->flags = DHT11_SAMPLE_VALID;
+        s->failures = 0;
+    } else {
+        if ( status == 1 ) s->timeouts++;
+        else if ( status == 2 ) s->checksum_errors++;
+        else s->glitches++;
+        if ( s->failures < UINT16_MAX ) s->failures++;
+        if ( s->flags & DHT11_SAMPLE_VALID ) s->flags |= DHT11_SAMPLE_STALE;
+        if ( schedule_retry(svc, s->failures) ) s->retries++;
+    }
+
+    __COMPILER_BARRIER();
+    svc->seq++;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bus_release();
+    __set_PRIMASK(primask);
+}
+
+// Microseconds until the sensor may be read again, 0 if now
+static uint32_t wait_before_read(dht11_service_t *svc) {
+    uint32_t wait_us = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t elapsed = delay_get_us() - svc->last_start_us;
+    if ( svc->has_started && elapsed < DHT11_MIN_INTERVAL_MS * 1000ULL ) {
+        wait_us = (uint32_t)(DHT11_MIN_INTERVAL_MS * 1000ULL - elapsed);
+    }
+    __set_PRIMASK(primask);
+    return wait_us;
+}
+
+static uint8_t start_read(dht11_service_t *svc) {
+    uint8_t result = 1;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if ( wait_before_read(svc) != 0 || svc->waiting || bus_owner == svc ) {
+        result = 1;
+    } else if ( bus_owner != NULL ) {
+        svc->waiting = true;
+        svc->next_waiting = NULL;
+        *wait_tail = svc;
+        wait_tail = &svc->next_waiting;
+        result = 0;
+    } else {
+        result = bus_begin(svc) ? 0 : 1;
+    }
+
+    __set_PRIMASK(primask);
+    return result;
+}
+
+static void period_fn(void *arg) {
+    dht11_service_t *svc = arg;
+
+    // A requested read, or the last one before a restart, began less than
+    // DHT11_MIN_INTERVAL_MS ago: read when the interval ends and count the
+    // period from there
+    uint32_t wait_us = wait_before_read(svc);
+    if ( wait_us != 0 ) {
+        utimer_start(&svc->timer, wait_us, period_fn, svc);
+        return;
+    }
+    start_read(svc);
+    utimer_start_at(&svc->timer, svc->timer.due + svc->period_us, period_fn, svc);
+}
+
+uint8_t dht11_service_start(dht11_service_t *service, dht11_sensor_t *sensor, uint32_t period_ms) {
+    if ( period_ms < DHT11_MIN_INTERVAL_MS ) period_ms = DHT11_MIN_INTERVAL_MS;
+    // utimer deadlines must stay within half of its 32-bit us range
+    if ( period_ms > 30 * 60 * 1000 ) period_ms = 30 * 60 * 1000;
+
+    dht11_service_stop(service);
+    service->sensor = sensor;
+    service->period_us = period_ms * 1000;
+
+    // Offset the first read from the one of the previous service
+    uint64_t now = delay_get_us();
+    uint64_t first = now;
+    if ( has_first_read && last_first_read_us + DHT11_STAGGER_MS * 1000 > now ) {
+        first = last_first_read_us + DHT11_STAGGER_MS * 1000;
+    }
+    last_first_read_us = first;
+    has_first_read = true;
+
+    utimer_start(&service->timer, (uint32_t)(first - now), period_fn, service);
+    return 0;
+}
+
+void dht11_service_stop(dht11_service_t *service) {
+    utimer_cancel(&service->timer);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ( service->waiting ) {
+        dht11_service_t **p = &wait_head;
+        while ( *p != service ) p = &(*p)->next_waiting;
+        *p = service->next_waiting;
+        if ( wait_tail == &service->next_waiting ) wait_tail = p;
+        service->waiting = false;
+    }
+    __set_PRIMASK(primask);
+}
+
+uint8_t dht11_service_request(dht11_service_t *service) {
+    return start_read(service);
+}
+
+uint32_t dht11_service_get(dht11_service_t *service, dht11_sample_t *sample) {
+    uint32_t seq;
+    do {
+        seq = service->seq;
+        __COMPILER_BARRIER();
+        *sample = service->sample;
+        __COMPILER_BARRIER();
+    } while ( (seq & 1) || seq != service->seq );
+    return seq / 2;
+}
+
+void dht11_service_dump(dht11_service_t *service) {
+    const char *name = service->sensor != NULL && service->sensor->name != NULL ?
+                       service->sensor->name : "dht11";
+    dht11_sample_t s;
+    char line[120];
+    int len;
+
+    dht11_service_get(service, &s);
+    if ( s.flags & DHT11_SAMPLE_VALID ) {
+        len = snprintf(line, sizeof(line), "%s: %s%d.%d C %d.%d %%RH, %lu ms old%s\r\n", name,
+                       s.data.negative ? "-" : "", s.data.temp, s.data.temp_dec,
+                       s.data.humity, s.data.humity_dec,
+                       (unsigned long)((delay_get_us() - s.time_us) / 1000),
+                       (s.flags & DHT11_SAMPLE_STALE) ? " (stale)" : "");
+    } else {
+        len = snprintf(line, sizeof(line), "%s: no valid reading\r\n", name);
+    }
+    console_info((uint8_t *)line, len);
+
+    len = snprintf(line, sizeof(line),
+                   "%s: %lu reads, %lu timeout, %lu checksum, %lu glitch, %lu retries, %u failing\r\n",
+                   name, (unsigned long)s.reads, (unsigned long)s.timeouts,
+                   (unsigned long)s.checksum_errors, (unsigned long)s.glitches,
+                   (unsigned long)s.retries, s.failures);
+    console_info((uint8_t *)line, len);
+}
@@ -0,0 +1,119 @@
+#ifndef __DHT11_SERVICE_H
+#define __DHT11_SERVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dht11.h"
+
+// The DHT11 may not be read more often than this
+#define DHT11_MIN_INTERVAL_MS   2000
+
+// Published values are the median of the last DHT11_MEDIAN_N accepted
+// readings (odd, 1 disables the filter)
+#ifndef DHT11_MEDIAN_N
+#define DHT11_MEDIAN_N          3
+#endif
+
+// A reading this far from the current median is a glitch unless
+// DHT11_SPIKE_CONFIRM readings in a row are within the same distance of it
+// (then it is a real step)
+#define DHT11_SPIKE_TEMP_X10    50      // 5.0 C
+#define DHT11_SPIKE_HUMI_X10    150     // 15.0 %RH
+#define DHT11_SPIKE_CONFIRM     2
+
+// Reads of different sensors never overlap: a read that comes due while
+// another sensor is being read waits for it. New services are offset by
+// this much from the previous one so that this rarely happens.
+#define DHT11_STAGGER_MS        50
+
+// After a failed read, retry after DHT11_MIN_INTERVAL_MS, then twice as long
+// each time up to 2^DHT11_BACKOFF_MAX times, but never later than the period
+#define DHT11_BACKOFF_MAX       4
+
+// dht11_sample_t.flags
+#define DHT11_SAMPLE_VALID      0x01    // data holds a successful reading
+#define DHT11_SAMPLE_STALE      0x02    // the latest read failed, data is older
+
+// Snapshot of the sensor service
+typedef struct {
+    dht11_dt data;              // filtered value
+    uint64_t time_us;           // delay_get_us() of the last accepted reading
+    uint8_t flags;              // DHT11_SAMPLE_*
+    uint8_t last_status;        // status of the latest read, see dht11_read(),
+                                // or 4 when the filter rejected it as a glitch
+    uint16_t failures;          // reads failed in a row
+    uint32_t reads;             // reads attempted
+    uint32_t timeouts;          // no answer or an incomplete frame
+    uint32_t checksum_errors;
+    uint32_t glitches;          // implausible values and rejected spikes
+    uint32_t retries;           // reads brought forward after a failure
+} dht11_sample_t;
+
+// One sensor served in the background. Owned by the caller (usually
+// static), all fields are private.
+typedef struct dht11_service {
+    dht11_sensor_t *sensor;
+    uint32_t period_us;
+    utimer_t timer;             // next periodic read or retry
+    uint64_t last_start_us;
+    bool has_started;
+    bool waiting;               // due, waiting for the bus
+    dht11_dt reading;           // destination of the read in flight
+    struct dht11_service *next_waiting;
+
+    // Filter, only touched by the completion interrupt
+    int16_t window_temp[DHT11_MEDIAN_N];    // 0.1 C
+    int16_t window_humi[DHT11_MEDIAN_N];    // 0.1 %RH
+    uint8_t window_count;
+    uint8_t window_pos;
+    uint8_t spike_count;        // spikes in a row that agree with the first
+    int16_t spike_temp;         // first of them
+    int16_t spike_humi;
+    int16_t median_temp;
+    int16_t median_humi;
+
+    // Seqlock: odd while the interrupt updates the sample
+    volatile uint32_t seq;
+    dht11_sample_t sample;
+} dht11_service_t;
+
+/**
+ * @brief  Read `sensor` every `period_ms` (DHT11_MIN_INTERVAL_MS up to 30
+ *         minutes) in the background. The first read starts DHT11_STAGGER_MS
+ *         after the one of the service started before. Call
+ *         dht11_sensor_init() (or dht11_init() for the board sensor) first.
+ *         Reads run entirely from interrupts (utimer and EXTI), so no thread
+ *         or main loop job is needed.
+ *         Two reads never start less than DHT11_MIN_INTERVAL_MS apart: a
+ *         periodic read that comes too soon after a requested one (or after
+ *         the last read before a restart) waits for the interval to end, and
+ *         the period continues from there.
+ * @return status code
+ *         - 0 success
+ */
+uint8_t dht11_service_start(dht11_service_t *service, dht11_sensor_t *sensor, uint32_t period_ms);
+
+void dht11_service_stop(dht11_service_t *service);
+
+/**
+ * @brief  Ask for a read now, e.g. when a screen opens. Ignored if the last
+ *         read started less than DHT11_MIN_INTERVAL_MS ago.
+ * @return status code
+ *         - 0 read started or waiting for the bus
+ *         - 1 rate limited or a read is already running
+ */
+uint8_t dht11_service_request(dht11_service_t *service);
+
+/**
+ * @brief  Copy the latest sample. Never blocks on the sensor; any number of
+ *         threads may read at once. The cache is a seqlock written from the
+ *         DHT11 interrupts, so do not call this from a handler that can
+ *         preempt them.
+ * @return update count, changes whenever a read finishes (ok or not)
+ */
+uint32_t dht11_service_get(dht11_service_t *service, dht11_sample_t *sample);
+
+// Print the filtered value and the error counters on the console
+void dht11_service_dump(dht11_service_t *service);
+
+#endif /* __DHT11_SERVICE_H */
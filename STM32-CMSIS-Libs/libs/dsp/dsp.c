@@ -0,0 +1,161 @@
+#include "dsp.h"
+#include <math.h>
+#include <stddef.h>
+
+void dsp_adc_to_q15(const uint16_t *in, uint16_t stride, q15_t *out, uint16_t n) {
+    for (uint16_t i = 0; i < n; ++i, in += stride) {
+        out[i] = (q15_t)((*in & 0xFFF) << 3);
+    }
+}
+
+uint8_t dsp_cic_init(dsp_cic_t *f, uint8_t order, uint8_t shift) {
+    if (order == 0 || order > DSP_CIC_MAX_ORDER || shift == 0 || shift > 15 ||
+        order * shift > 20) {
+        return 1;
+    }
+    for (uint8_t i = 0; i < DSP_CIC_MAX_ORDER; ++i) {
+        f->integ[i] = 0;
+        f->comb[i] = 0;
+    }
+    f->order = order;
+    f->shift = shift;
+    f->phase = 0;
+    return 0;
+}
+
+uint16_t dsp_cic_decimate(dsp_cic_t *f, const uint16_t *in, uint16_t stride, q15_t *out, uint16_t n) {
+    const uint8_t order = f->order;
+    const uint16_t ratio = 1u << f->shift;
+    // Full scale after the combs is 4095 << (order * shift); Q15 wants << 3
+    const int8_t norm = order * f->shift - 3;
+    uint16_t written = 0;
+
+    for (uint16_t i = 0; i < n; ++i, in += stride) {
+        uint32_t v = *in & 0xFFF;
+        for (uint8_t k = 0; k < order; ++k) v = f->integ[k] += v;
+        if (++f->phase < ratio) continue;
+        f->phase = 0;
+
+        for (uint8_t k = 0; k < order; ++k) {
+            uint32_t prev = f->comb[k];
+            f->comb[k] = v;
+            v -= prev;
+        }
+        int32_t y = norm > 0 ? (int32_t)((v + (1u << (norm - 1))) >> norm) : (int32_t)(v << -norm);
+        out[written++] = dsp_sat_q15(y);
+    }
+    return written;
+}
+
+uint8_t dsp_fir_init(dsp_fir_t *f, const q15_t *coeffs, uint16_t taps, q15_t *state, uint16_t factor) {
+    if (coeffs == NULL || state == NULL || taps == 0 || taps > 0x7FFF || factor == 0) return 1;
+    for (uint16_t i = 0; i < 2 * taps; ++i) state[i] = 0;
+    f->coeffs = coeffs;
+    f->state = state;
+    f->taps = taps;
+    f->pos = 0;
+    f->factor = factor;
+    f->phase = 0;
+    return 0;
+}
+
+uint16_t dsp_fir_decimate(dsp_fir_t *f, const q15_t *in, uint16_t stride, q15_t *out, uint16_t n) {
+    const uint16_t taps = f->taps;
+    uint16_t written = 0;
+
+    for (uint16_t i = 0; i < n; ++i, in += stride) {
+        f->state[f->pos] = f->state[f->pos + taps] = *in;
+        if (++f->pos == taps) f->pos = 0;
+        if (++f->phase < f->factor) continue;
+        f->phase = 0;
+
+        // state[pos .. pos + taps) runs from the oldest sample to the newest
+        const q15_t *x = &f->state[f->pos];
+        const q15_t *h = &f->coeffs[taps - 1];
+        int32_t acc = 1 << 14;
+        for (uint16_t k = 0; k < taps; ++k) acc += (int32_t)*x++ * *h--;
+        out[written++] = dsp_sat_q15(acc >> 15);
+    }
+    return written;
+}
+
+void dsp_biquad_init(dsp_biquad_t *f, const int16_t coeffs[5]) {
+    f->b0 = coeffs[0];
+    f->b1 = coeffs[1];
+    f->b2 = coeffs[2];
+    f->a1 = coeffs[3];
+    f->a2 = coeffs[4];
+    f->x1 = f->x2 = f->y1 = f->y2 = 0;
+}
+
+static int16_t to_q14(float x) {
+    return dsp_sat_q15((int32_t)lrintf(x * 16384.0f));
+}
+
+void dsp_biquad_lowpass(dsp_biquad_t *f, float fc_hz, float fs_hz) {
+    // Audio EQ cookbook low-pass with Q = 1 / sqrt(2)
+    float w0 = 2.0f * 3.14159265f * fc_hz / fs_hz;
+    float cw = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * 0.70710678f);
+    float a0 = 1.0f + alpha;
+
+    int16_t c[5];
+    c[0] = to_q14((1.0f - cw) / 2.0f / a0);
+    c[2] = c[0];
+    c[3] = to_q14(-2.0f * cw / a0);
+    c[4] = to_q14((1.0f - alpha) / a0);
+    // b1 takes the rounding so that b0 + b1 + b2 == 1 + a1 + a2 exactly
+    c[1] = dsp_sat_q15(16384 + c[3] + c[4] - 2 * c[0]);
+    dsp_biquad_init(f, c);
+}
+
+void dsp_biquad_process(dsp_biquad_t *f, const q15_t *in, q15_t *out, uint16_t n) {
+    q15_t x1 = f->x1, x2 = f->x2, y1 = f->y1, y2 = f->y2;
+
+    for (uint16_t i = 0; i < n; ++i) {
+        q15_t x = in[i];
+        // Q15 * Q14, summed in 64 bits (SMLAL): the feedback terms alone can
+        // come close to 2^31
+        int64_t acc = 1 << 13;
+        acc += (int32_t)f->b0 * x;
+        acc += (int32_t)f->b1 * x1;
+        acc += (int32_t)f->b2 * x2;
+        acc -= (int32_t)f->a1 * y1;
+        acc -= (int32_t)f->a2 * y2;
+        q15_t y = dsp_sat_q15((int32_t)(acc >> 14));
+
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        out[i] = y;
+    }
+    f->x1 = x1;
+    f->x2 = x2;
+    f->y1 = y1;
+    f->y2 = y2;
+}
+
+uint8_t dsp_mavg_init(dsp_mavg_t *f, q15_t *history, uint16_t len, q15_t initial) {
+    if (history == NULL || len == 0) return 1;
+    for (uint16_t i = 0; i < len; ++i) history[i] = initial;
+    f->history = history;
+    f->len = len;
+    f->pos = 0;
+    f->sum = (int32_t)initial * len;
+    return 0;
+}
+
+void dsp_mavg_process(dsp_mavg_t *f, const q15_t *in, q15_t *out, uint16_t n) {
+    const int32_t len = f->len;
+    const int32_t half = len / 2;
+
+    for (uint16_t i = 0; i < n; ++i) {
+        q15_t x = in[i];
+        f->sum += x - f->history[f->pos];
+        f->history[f->pos] = x;
+        if (++f->pos == len) f->pos = 0;
+        // Rounded to nearest, also for negative sums
+        out[i] = (q15_t)(f->sum >= 0 ? (f->sum + half) / len : -((half - f->sum) / len));
+    }
+}
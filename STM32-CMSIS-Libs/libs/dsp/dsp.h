@@ -0,0 +1,131 @@
+#ifndef LIBS_DSP_H
+#define LIBS_DSP_H
+
+#include <stdint.h>
+
+// Block-based fixed-point filters for ADC streams. Samples are Q15 (int16_t,
+// [-1, 1)); a 12-bit ADC reading becomes value << 3, so full scale is 0.9998.
+// Every stage keeps its own state and processes a block per call, so a DMA
+// half-block callback can run a whole chain and publish one value.
+//
+// Sums are 32 bits (MUL/MLA) except in the biquad, whose feedback needs the
+// 64-bit SMLAL. The Cortex-M3 has no dual 16-bit MAC (SMLAD), so the loops
+// are kept simple instead.
+//
+// Decimators take `stride` so they read one channel straight out of an
+// interleaved adc_scan block: in[0], in[stride], in[2 * stride]...
+
+typedef int16_t q15_t;
+
+#define DSP_CIC_MAX_ORDER   4
+
+static inline q15_t dsp_sat_q15(int32_t x) {
+    return x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : (q15_t)x;
+}
+
+// 12-bit ADC samples to Q15
+void dsp_adc_to_q15(const uint16_t *in, uint16_t stride, q15_t *out, uint16_t n);
+
+// Q15 back to 12-bit ADC counts, rounded and clamped to 0..4095
+static inline uint16_t dsp_q15_to_adc(q15_t x) {
+    int32_t v = ((int32_t)x + 4) >> 3;
+    return v < 0 ? 0 : v > 4095 ? 4095 : (uint16_t)v;
+}
+
+// Q15 to 0..scale (e.g. 100 for percent), rounded
+static inline int32_t dsp_q15_scale(q15_t x, int32_t scale) {
+    return ((int32_t)x * scale + (1 << 14)) >> 15;
+}
+
+/* CIC decimator: `order` integrators at the input rate, `order` combs at
+ * 1 / 2^shift of it. No multiplications at all; the gain 2^(order * shift)
+ * is removed by a shift. Integrators wrap modulo 2^32, which the combs undo,
+ * so order * shift must stay <= 20 for 12-bit input. */
+typedef struct {
+    uint32_t integ[DSP_CIC_MAX_ORDER];
+    uint32_t comb[DSP_CIC_MAX_ORDER];   // previous input of each comb
+    uint8_t order;
+    uint8_t shift;                      // decimation 2^shift
+    uint16_t phase;                     // inputs since the last output
+} dsp_cic_t;
+
+/**
+ * @brief  Set up a CIC decimator by 2^shift.
+ * @return status code
+ *         - 0 success
+ *         - 1 order or shift out of range
+ */
+uint8_t dsp_cic_init(dsp_cic_t *f, uint8_t order, uint8_t shift);
+
+/**
+ * @brief  Feed `n` 12-bit ADC samples, `stride` apart.
+ * @return outputs written to `out` (Q15), n / 2^shift give or take one
+ */
+uint16_t dsp_cic_decimate(dsp_cic_t *f, const uint16_t *in, uint16_t stride, q15_t *out, uint16_t n);
+
+/* FIR decimator by `factor`: only every factor-th output is computed. The
+ * delay line is stored twice (2 * taps samples) so each dot product runs over
+ * contiguous memory. The sum is 32 bits: the absolute coefficient sum must be
+ * below 2, which any low-pass meets. */
+typedef struct {
+    const q15_t *coeffs;
+    q15_t *state;                       // 2 * taps samples
+    uint16_t taps;
+    uint16_t pos;
+    uint16_t factor;
+    uint16_t phase;
+} dsp_fir_t;
+
+/**
+ * @return status code
+ *         - 0 success
+ *         - 1 invalid taps or factor
+ */
+uint8_t dsp_fir_init(dsp_fir_t *f, const q15_t *coeffs, uint16_t taps, q15_t *state, uint16_t factor);
+
+// Same as dsp_cic_decimate() but Q15 in; returns the outputs written
+uint16_t dsp_fir_decimate(dsp_fir_t *f, const q15_t *in, uint16_t stride, q15_t *out, uint16_t n);
+
+/* Biquad, direct form I:
+ *     y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2
+ * Coefficients are Q14 (range [-2, 2)) in the order b0 b1 b2 a1 a2. */
+typedef struct {
+    int16_t b0, b1, b2, a1, a2;
+    q15_t x1, x2, y1, y2;
+} dsp_biquad_t;
+
+void dsp_biquad_init(dsp_biquad_t *f, const int16_t coeffs[5]);
+
+/**
+ * @brief  Butterworth low-pass (Q = 0.707) with its cut-off at fc_hz for
+ *         samples at fs_hz. The coefficients are rounded so the DC gain is
+ *         exactly 1; for precision keep fc_hz above about fs_hz / 100, which
+ *         is what decimating first is for. Uses floating point, call it once
+ *         at start-up.
+ */
+void dsp_biquad_lowpass(dsp_biquad_t *f, float fc_hz, float fs_hz);
+
+// Filter `n` samples; `out` may be `in`
+void dsp_biquad_process(dsp_biquad_t *f, const q15_t *in, q15_t *out, uint16_t n);
+
+/* Moving average over `len` samples: a running sum, so the cost per sample
+ * does not depend on len. */
+typedef struct {
+    q15_t *history;                     // len samples
+    uint16_t len;
+    uint16_t pos;
+    int32_t sum;
+} dsp_mavg_t;
+
+/**
+ * @brief  The average starts from `initial`, as if the history were full of it.
+ * @return status code
+ *         - 0 success
+ *         - 1 len is 0
+ */
+uint8_t dsp_mavg_init(dsp_mavg_t *f, q15_t *history, uint16_t len, q15_t initial);
+
+// `out` may be `in`
+void dsp_mavg_process(dsp_mavg_t *f, const q15_t *in, q15_t *out, uint16_t n);
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef LIBS_GPIO_PIN_H
+#define LIBS_GPIO_PIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "RTE_Components.h"
+#include CMSIS_device_header
+#include "../bitband/bitband.h"
+
+// A GPIO pin as a value: port index (0 = A) and pin number. Pins are named
+// once as constants, e.g.
+//     #define ST7789_DC   GPIO_PIN('E', 0)
+// and every accessor below is static inline, so with a constant pin the port
+// address, the mask and the CRL/CRH choice are computed by the compiler and
+// gpio_pin_high() is a single store to BSRR, gpio_pin_read() a single load.
+// A struct rather than a number, so a bare pin number or a port letter is a
+// compile error where a pin is expected.
+typedef struct {
+    uint8_t port;
+    uint8_t pin;
+} gpio_pin_t;
+
+#define GPIO_PIN(bank, n)       ((gpio_pin_t){ (uint8_t)((bank) - 'A'), (uint8_t)(n) })
+// Same, for static initialisers
+#define GPIO_PIN_INIT(bank, n)  { (uint8_t)((bank) - 'A'), (uint8_t)(n) }
+
+// CNF[1:0] MODE[1:0] of a pin in CRL/CRH
+#define GPIO_CFG_ANALOG         0x0
+#define GPIO_CFG_IN_FLOAT       0x4     // reset state
+#define GPIO_CFG_IN_PULL        0x8     // pull-up or pull-down by ODR
+#define GPIO_CFG_OUT_PP_2MHZ    0x2
+#define GPIO_CFG_OUT_PP_50MHZ   0x3
+#define GPIO_CFG_OUT_OD_2MHZ    0x6
+#define GPIO_CFG_AF_PP_50MHZ    0xB
+
+static inline GPIO_TypeDef *gpio_pin_port(gpio_pin_t p) {
+    return (GPIO_TypeDef *)( GPIOA_BASE + 0x400 * p.port );
+}
+
+static inline uint32_t gpio_pin_mask(gpio_pin_t p) {
+    return 1u << p.pin;
+}
+
+// Bit-band aliases of the pin's ODR and IDR bits: writing a 0/1 value or
+// reading the level needs no mask, shift or branch. The host build has no
+// bit-band region and uses BSRR/IDR.
+#ifdef PERIPH_BB_BASE
+#define GPIO_PIN_BB(p, reg)     BITBAND(gpio_pin_port(p)->reg, gpio_pin_mask(p))
+#endif
+
+// Enable the clock of the pin's port
+static inline void gpio_pin_clock_enable(gpio_pin_t p) {
+    RCC->APB2ENR |= RCC_APB2ENR_IOPAEN << p.port;
+}
+
+// Set the pin's GPIO_CFG_*. CRL/CRH hold eight pins each, so the update is
+// done with interrupts masked.
+static inline void gpio_pin_config(gpio_pin_t p, uint32_t cfg) {
+    GPIO_TypeDef *gpio = gpio_pin_port(p);
+    volatile uint32_t *cr = p.pin < 8 ? &gpio->CRL : &gpio->CRH;
+    uint32_t pos = ( p.pin % 8 ) * 4;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *cr = ( *cr & ~( 0xFu << pos ) ) | ( cfg << pos );
+    __set_PRIMASK(primask);
+}
+
+static inline void gpio_pin_high(gpio_pin_t p) {
+    gpio_pin_port(p)->BSRR = gpio_pin_mask(p);
+}
+
+static inline void gpio_pin_low(gpio_pin_t p) {
+    gpio_pin_port(p)->BRR = gpio_pin_mask(p);
+}
+
+static inline void gpio_pin_write(gpio_pin_t p, bool high) {
+#ifdef PERIPH_BB_BASE
+    GPIO_PIN_BB(p, ODR) = high;
+#else
+    gpio_pin_port(p)->BSRR = high ? gpio_pin_mask(p) : gpio_pin_mask(p) << 16;
+#endif
+}
+
+// Input level
+static inline bool gpio_pin_read(gpio_pin_t p) {
+#ifdef PERIPH_BB_BASE
+    return GPIO_PIN_BB(p, IDR);
+#else
+    return ( gpio_pin_port(p)->IDR >> p.pin ) & 1;
+#endif
+}
+
+// Level the pin is driven to (ODR)
+static inline bool gpio_pin_output(gpio_pin_t p) {
+#ifdef PERIPH_BB_BASE
+    return GPIO_PIN_BB(p, ODR);
+#else
+    return ( gpio_pin_port(p)->ODR >> p.pin ) & 1;
+#endif
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "gui.h"
+#include "../delay/delay.h"
+#include "RTE_Components.h"
+#include CMSIS_device_header
+#include <stddef.h>
+
+// Slots posted to since the last gui_process(), newest first
+static gui_slot_t *pending;
+static volatile uint32_t posts;
+static uint32_t applied;
+
+#if USE_CMSIS_OS
+static osThreadId_t gui_thread = NULL;
+#endif
+
+// Leaves the value and the pending link alone: a zeroed slot may already
+// have been posted to
+void gui_slot_init(gui_slot_t *slot, lv_obj_t *obj, gui_apply_fn apply, void *arg) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    slot->obj = obj;
+    slot->apply = apply;
+    slot->arg = arg;
+    __set_PRIMASK(primask);
+}
+
+void gui_post(gui_slot_t *slot, int32_t value) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    slot->value = value;
+    posts++;
+    bool link = !slot->pending;
+    if ( link ) {
+        slot->pending = true;
+        slot->next = pending;
+        pending = slot;
+    }
+    __set_PRIMASK(primask);
+
+    if ( link ) gui_wakeup();
+}
+
+uint32_t gui_process(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    gui_slot_t *list = pending;
+    pending = NULL;
+    __set_PRIMASK(primask);
+
+    // Oldest first
+    gui_slot_t *fifo = NULL;
+    while ( list != NULL ) {
+        gui_slot_t *next = list->next;
+        list->next = fifo;
+        fifo = list;
+        list = next;
+    }
+
+    uint32_t count = 0;
+    while ( fifo != NULL ) {
+        gui_slot_t *slot = fifo;
+        fifo = slot->next;
+
+        // From here a post links the slot again and is applied next time
+        primask = __get_PRIMASK();
+        __disable_irq();
+        int32_t value = slot->value;
+        slot->pending = false;
+        __set_PRIMASK(primask);
+
+        if ( slot->apply == NULL ) continue;     // not initialised yet
+        slot->apply(slot->obj, value, slot->arg);
+        count++;
+    }
+    applied += count;
+    return count;
+}
+
+void gui_wakeup(void) {
+#if USE_CMSIS_OS
+    if ( gui_thread != NULL && osThreadGetId() != gui_thread ) {
+        osThreadFlagsSet(gui_thread, GUI_THREAD_FLAG);
+    }
+#else
+    delay_idle_wakeup();
+#endif
+}
+
+void gui_get_stats(gui_stats_t *stats) {
+    stats->posts = posts;
+    stats->applied = applied;
+}
+
+void gui_apply_bar(lv_obj_t *obj, int32_t value, void *arg) {
+    (void)arg;
+    lv_bar_set_value(obj, value, LV_ANIM_ON);
+}
+
+void gui_apply_slider(lv_obj_t *obj, int32_t value, void *arg) {
+    (void)arg;
+    lv_slider_set_value(obj, value, LV_ANIM_ON);
+}
+
+void gui_apply_label(lv_obj_t *obj, int32_t value, void *arg) {
+    lv_label_set_text_fmt(obj, (const char *)arg, (int)value);
+}
+
+#if USE_CMSIS_OS
+static void gui_thread_main(void *argument) {
+    const gui_thread_config_t *config = argument;
+
+    if ( config->setup != NULL ) config->setup(config->arg);
+    for (;;) {
+        gui_process();
+        if ( config->poll != NULL ) config->poll(config->arg);
+        uint32_t next = lv_timer_handler();
+        osThreadFlagsWait(GUI_THREAD_FLAG, osFlagsWaitAny,
+                          next == LV_NO_TIMER_READY ? osWaitForever : next);
+    }
+}
+
+osThreadId_t gui_start_thread(const osThreadAttr_t *attr, const gui_thread_config_t *config) {
+    gui_thread = osThreadNew(gui_thread_main, (void *)config, attr);
+    return gui_thread;
+}
+#endif
@@ -0,0 +1,88 @@
+#ifndef LIBS_GUI_H
+#define LIBS_GUI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "libs_common.h"
+#include "../lvgl/lvgl.h"
+
+// Widget updates from any thread or interrupt for LVGL, which is not thread
+// safe. One context owns LVGL (the GUI thread started by gui_start_thread()
+// with USE_CMSIS_OS, otherwise the main loop): it alone calls LVGL,
+// gui_process() and lv_timer_handler().
+//
+// Each widget that others update has a slot. gui_post() stores the value in
+// the slot and, unless it is already pending, links the slot into the
+// pending list with interrupts masked for a few instructions; it never
+// blocks and never calls LVGL. gui_process() applies every pending slot once
+// with the latest value posted to it, so a sensor posting at 1 kHz costs
+// one widget update per GUI pass, and no lock is held while LVGL renders.
+// The pending list holds each slot at most once, so it cannot overflow.
+//
+// Posting wakes the owner: delay_idle_wakeup() for a main loop, the thread
+// flag GUI_THREAD_FLAG for the GUI thread.
+
+#if USE_CMSIS_OS
+// Thread flag that wakes the GUI thread
+#define GUI_THREAD_FLAG     0x01
+#endif
+
+// Called by gui_process() with the latest value posted to the slot
+typedef void (*gui_apply_fn)(lv_obj_t *obj, int32_t value, void *arg);
+
+typedef struct gui_slot {
+    lv_obj_t *obj;
+    gui_apply_fn apply;
+    void *arg;
+    volatile int32_t value;     // latest posted
+    volatile bool pending;
+    struct gui_slot *next;      // in the pending list
+} gui_slot_t;
+
+typedef struct {
+    uint32_t posts;             // gui_post() calls
+    uint32_t applied;           // apply calls; the rest were coalesced
+} gui_stats_t;
+
+// Set up a slot for `obj`. Owner only. A zeroed (static) slot may be posted
+// to before this; its latest value is applied by the next gui_process().
+void gui_slot_init(gui_slot_t *slot, lv_obj_t *obj, gui_apply_fn apply, void *arg);
+
+// Show `value` in the slot's widget. Any thread or interrupt.
+void gui_post(gui_slot_t *slot, int32_t value);
+
+/**
+ * @brief  Apply the pending slots, each once with its latest value, in the
+ *         order they first became pending. Owner only.
+ * @return number of slots applied
+ */
+uint32_t gui_process(void);
+
+// Make the owner run now. Any thread or interrupt.
+void gui_wakeup(void);
+
+void gui_get_stats(gui_stats_t *stats);
+
+// Appliers for common widgets
+void gui_apply_bar(lv_obj_t *obj, int32_t value, void *arg);        // lv_bar_set_value(), animated
+void gui_apply_slider(lv_obj_t *obj, int32_t value, void *arg);     // lv_slider_set_value(), animated
+void gui_apply_label(lv_obj_t *obj, int32_t value, void *arg);      // arg: printf format of one int
+
+#if USE_CMSIS_OS
+typedef struct {
+    void (*setup)(void *arg);   // first, in the GUI thread: lv_init(), ports, widgets, slots
+    bool (*poll)(void *arg);    // every pass before lv_timer_handler(), may be NULL
+    void *arg;
+} gui_thread_config_t;
+
+/**
+ * @brief  Start the GUI thread. It calls `config->setup`, then loops:
+ *         gui_process(), `config->poll`, lv_timer_handler(), and waits for
+ *         GUI_THREAD_FLAG until the next LVGL timer is due.
+ *         `config` must stay valid.
+ * @return thread id, NULL on failure
+ */
+osThreadId_t gui_start_thread(const osThreadAttr_t *attr, const gui_thread_config_t *config);
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+#include "gui_bind.h"
+#include <stddef.h>
+#include <string.h>
+
+// Bindings holding a value for later, in no particular order
+static gui_bind_t *deferred;
+
+static void show(gui_bind_t *bind, int32_t value) {
+    bind->show(bind->obj, value, bind->arg);
+    bind->shown = value;
+    bind->shown_valid = true;
+    bind->shown_tick = lv_tick_get();
+}
+
+void gui_bind_init(gui_bind_t *bind, lv_obj_t *obj, gui_bind_show_fn show, void *arg, uint16_t min_ms) {
+    // Re-initialised while holding a value: take it off the deferred list,
+    // or the bindings after it would never be polled again
+    if ( bind->deferred ) {
+        gui_bind_t **link = &deferred;
+        while ( *link != NULL && *link != bind ) link = &(*link)->next;
+        if ( *link != NULL ) *link = bind->next;
+    }
+    bind->obj = obj;
+    bind->show = show;
+    bind->arg = arg;
+    bind->min_ms = min_ms;
+    bind->shown_valid = false;
+    bind->deferred = false;
+    bind->next = NULL;
+}
+
+bool gui_bind_set(gui_bind_t *bind, int32_t value) {
+    if ( bind->deferred ) {
+        // Shown when the interval ends; back to the shown value cancels it
+        bind->latest = value;
+        return false;
+    }
+    if ( bind->shown_valid && value == bind->shown ) return false;
+
+    if ( bind->shown_valid && bind->min_ms != 0 && lv_tick_elaps(bind->shown_tick) < bind->min_ms ) {
+        bind->latest = value;
+        bind->deferred = true;
+        bind->next = deferred;
+        deferred = bind;
+        return false;
+    }
+    show(bind, value);
+    return true;
+}
+
+uint32_t gui_bind_poll(void) {
+    uint32_t next = UINT32_MAX;
+
+    for ( gui_bind_t **link = &deferred; *link != NULL; ) {
+        gui_bind_t *bind = *link;
+        uint32_t elapsed = lv_tick_elaps(bind->shown_tick);
+        if ( elapsed < bind->min_ms ) {
+            if ( bind->min_ms - elapsed < next ) next = bind->min_ms - elapsed;
+            link = &bind->next;
+            continue;
+        }
+        *link = bind->next;
+        bind->deferred = false;
+        if ( bind->latest != bind->shown ) show(bind, bind->latest);
+    }
+    return next;
+}
+
+void gui_bind_apply(lv_obj_t *obj, int32_t value, void *bind) {
+    (void)obj;
+    gui_bind_set(bind, value);
+}
+
+void gui_bind_show_bar(lv_obj_t *obj, int32_t value, void *arg) {
+    (void)arg;
+    lv_bar_set_value(obj, value, LV_ANIM_ON);
+}
+
+void gui_bind_show_slider(lv_obj_t *obj, int32_t value, void *arg) {
+    (void)arg;
+    lv_slider_set_value(obj, value, LV_ANIM_ON);
+}
+
+void gui_bind_show_label(lv_obj_t *obj, int32_t value, void *text) {
+    gui_bind_text_t *t = text;
+    char buf[GUI_BIND_TEXT_LEN];
+
+    lv_snprintf(buf, sizeof(buf), t->fmt, (int)value);
+    gui_bind_label_text(obj, t, buf);
+}
+
+void gui_bind_label_text(lv_obj_t *obj, gui_bind_text_t *t, const char *text) {
+    if ( lv_label_get_text(obj) == t->text && strcmp(t->text, text) == 0 ) return;
+    strncpy(t->text, text, sizeof(t->text) - 1);
+    t->text[sizeof(t->text) - 1] = '\0';
+    lv_label_set_text_static(obj, t->text);
+}
@@ -0,0 +1,82 @@
+#ifndef LIBS_GUI_BIND_H
+#define LIBS_GUI_BIND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../lvgl/lvgl.h"
+
+// Bindings of data sources to widgets, for values that are set far more
+// often than they change. gui_bind_set() compares the value with the one
+// the widget shows and returns at once when it is the same: no formatting,
+// no lv_label allocation, no invalidated area. A changed value is shown
+// right away unless the binding was updated less than `min_ms` ago; then
+// it is kept and gui_bind_poll() shows the latest one when the interval
+// ends, so a noisy source redraws its widget at most every `min_ms`.
+//
+// Label bindings format into a buffer of the binding and show it with
+// lv_label_set_text_static(), so the label allocates nothing on updates.
+//
+// Owner of LVGL only (see gui.h); gui_bind_apply() makes a binding the
+// target of a gui slot, for sources in other threads or interrupts.
+
+#define GUI_BIND_TEXT_LEN   24
+
+// Shows `value` in `obj`
+typedef void (*gui_bind_show_fn)(lv_obj_t *obj, int32_t value, void *arg);
+
+typedef struct gui_bind {
+    lv_obj_t *obj;
+    gui_bind_show_fn show;
+    void *arg;
+    uint16_t min_ms;            // shortest time between two updates, 0: none
+    bool shown_valid;
+    bool deferred;              // `latest` waits for the interval to end
+    int32_t shown;              // value the widget shows
+    int32_t latest;
+    uint32_t shown_tick;        // lv_tick_get() of the last update
+    struct gui_bind *next;      // in the deferred list
+} gui_bind_t;
+
+// Text of a label binding
+typedef struct {
+    const char *fmt;            // printf format of the value, one int
+    char text[GUI_BIND_TEXT_LEN];
+} gui_bind_text_t;
+
+/**
+ * @brief Bind `obj`, shown by `show(obj, value, arg)`. The first
+ *        gui_bind_set() always shows its value. `bind` must be zeroed
+ *        (static) or initialised before; a value it still holds for later
+ *        is dropped.
+ */
+void gui_bind_init(gui_bind_t *bind, lv_obj_t *obj, gui_bind_show_fn show, void *arg, uint16_t min_ms);
+
+/**
+ * @brief  Show `value` if it differs from the widget's, now or when the
+ *         binding's interval ends.
+ * @return true if the widget was updated now
+ */
+bool gui_bind_set(gui_bind_t *bind, int32_t value);
+
+/**
+ * @brief  Show the deferred values whose interval has ended.
+ * @return ms until the next deferred value is due, UINT32_MAX if none
+ */
+uint32_t gui_bind_poll(void);
+
+// Slot applier (gui_slot_init() with the binding as `arg`): gui_bind_set()
+void gui_bind_apply(lv_obj_t *obj, int32_t value, void *bind);
+
+// Show functions for common widgets
+void gui_bind_show_bar(lv_obj_t *obj, int32_t value, void *arg);       // animated
+void gui_bind_show_slider(lv_obj_t *obj, int32_t value, void *arg);    // animated
+void gui_bind_show_label(lv_obj_t *obj, int32_t value, void *text);    // gui_bind_text_t
+
+/**
+ * @brief Show `text` in a label through the buffer of `t`: nothing is
+ *        allocated, and nothing is redrawn if the text is the same. For
+ *        show functions that format more than one number.
+ */
+void gui_bind_label_text(lv_obj_t *obj, gui_bind_text_t *t, const char *text);
+
+#endif
@@ -0,0 +1,166 @@
+#include "key.h"
+#include "../delay/delay.h"
+#include "../delay/utimer.h"
+#include "../bitband/bitband.h"
+#include <stddef.h>
+
+typedef struct {
+    gpio_pin_t pin;
+    volatile bool pressed;      // debounced state
+    bool long_sent;             // LONG queued for this press
+    uint32_t hold_due;          // utimer_now() of the next LONG / REPEAT
+    utimer_t timer;             // debounce, then hold
+} key_state_t;
+
+static key_state_t keys[KEY_MAX_KEYS];
+static uint8_t key_count;
+static uint8_t line_key[16];    // key on each EXTI line
+static uint16_t key_lines;
+
+static key_event_t queue[KEY_QUEUE_LEN];
+static volatile uint8_t queue_head;     // written by the TIM5 interrupt only
+static volatile uint8_t queue_tail;     // written by key_get() only
+static volatile uint32_t dropped;
+
+static key_notify_fn notify;
+static void *notify_arg;
+
+static IRQn_Type exti_irq(uint8_t line) {
+    if (line < 5) return (IRQn_Type)(EXTI0_IRQn + line);
+    return line < 10 ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+static void push(uint8_t key, KEY_EVENT type) {
+    uint8_t head = queue_head;
+    if ( (uint8_t)( head - queue_tail ) == KEY_QUEUE_LEN ) {
+        dropped++;
+        return;
+    }
+    key_event_t *event = &queue[head % KEY_QUEUE_LEN];
+    event->key = key;
+    event->type = type;
+    event->time_us = utimer_now();
+    queue_head = head + 1;
+
+    delay_idle_wakeup();
+    if ( notify != NULL ) notify(notify_arg);
+}
+
+// Held: LONG once, then REPEAT, on deadlines counted from the press
+static void hold(void *arg) {
+    key_state_t *k = arg;
+    uint8_t key = (uint8_t)( k - keys );
+
+    push(key, k->long_sent ? KEY_EVENT_REPEAT : KEY_EVENT_LONG);
+    k->long_sent = true;
+    k->hold_due += KEY_REPEAT_MS * 1000u;
+    utimer_start_at(&k->timer, k->hold_due, hold, k);
+}
+
+// The line has been quiet for KEY_DEBOUNCE_MS. PR is cleared before the
+// level is read, so an edge after the read raises the interrupt again once
+// the line is unmasked.
+static void debounced(void *arg) {
+    key_state_t *k = arg;
+    uint8_t key = (uint8_t)( k - keys );
+    uint32_t bit = gpio_pin_mask(k->pin);
+
+    EXTI->PR = bit;
+    bool pressed = !gpio_pin_read(k->pin);
+    if ( pressed != k->pressed ) {
+        k->pressed = pressed;
+        push(key, pressed ? KEY_EVENT_PRESS : KEY_EVENT_RELEASE);
+        if ( pressed ) {
+            k->long_sent = false;
+            k->hold_due = utimer_now() + KEY_LONG_MS * 1000u;
+        }
+    }
+    // A bounce within a hold keeps the LONG / REPEAT schedule of the press
+    if ( k->pressed ) utimer_start_at(&k->timer, k->hold_due, hold, k);
+    BITBAND_SET(EXTI->IMR, bit);
+}
+
+// Mask the line and (re)start the debounce time; edges of a bouncing
+// contact are not even taken as interrupts until it has settled
+static void debounce(key_state_t *k) {
+    BITBAND_CLEAR(EXTI->IMR, gpio_pin_mask(k->pin));
+    utimer_cancel(&k->timer);
+    utimer_start(&k->timer, KEY_DEBOUNCE_MS * 1000u, debounced, k);
+}
+
+void key_exti_irq(void) {
+    uint32_t lines = EXTI->PR & EXTI->IMR & key_lines;
+    EXTI->PR = lines;
+
+    while ( lines != 0 ) {
+        key_state_t *k = &keys[line_key[__builtin_ctz(lines)]];
+        lines &= lines - 1;
+        debounce(k);
+    }
+}
+
+void KEY_EXTI_IRQHandler(void) {
+    key_exti_irq();
+}
+
+uint8_t key_init(const gpio_pin_t *pins, uint8_t count) {
+    if ( pins == NULL || count == 0 || count > KEY_MAX_KEYS ) return 1;
+    uint16_t lines = 0;
+    for ( uint8_t i = 0; i < count; i++ ) {
+        if ( lines & gpio_pin_mask(pins[i]) ) return 1;
+        lines |= gpio_pin_mask(pins[i]);
+    }
+
+    utimer_init();
+    RCC->APB2ENR |= RCC_APB2ENR_AFIOEN;
+    key_count = count;
+    key_lines = lines;
+    for ( uint8_t i = 0; i < count; i++ ) {
+        key_state_t *k = &keys[i];
+        uint8_t line = pins[i].pin;
+
+        k->pin = pins[i];
+        k->pressed = false;
+        utimer_cancel(&k->timer);
+        gpio_pin_clock_enable(k->pin);
+        gpio_pin_high(k->pin);
+        gpio_pin_config(k->pin, GPIO_CFG_IN_PULL);
+
+        // EXTI line of the pin, both edges
+        BITBAND_CLEAR(EXTI->IMR, 1u << line);
+        AFIO->EXTICR[line / 4] &= ~(0xF << ((line % 4) * 4));
+        AFIO->EXTICR[line / 4] |= (uint32_t)k->pin.port << ((line % 4) * 4);
+        BITBAND_SET(EXTI->RTSR, 1u << line);
+        BITBAND_SET(EXTI->FTSR, 1u << line);
+        line_key[line] = i;
+        NVIC_EnableIRQ(exti_irq(line));
+
+        // First look at the level after the debounce time, then unmask
+        debounce(k);
+    }
+    return 0;
+}
+
+void key_set_notify(key_notify_fn fn, void *arg) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    notify = fn;
+    notify_arg = arg;
+    __set_PRIMASK(primask);
+}
+
+bool key_get(key_event_t *event) {
+    uint8_t tail = queue_tail;
+    if ( tail == queue_head ) return false;
+    *event = queue[tail % KEY_QUEUE_LEN];
+    queue_tail = tail + 1;
+    return true;
+}
+
+bool key_pressed(uint8_t key) {
+    return key < key_count && keys[key].pressed;
+}
+
+uint32_t key_dropped(void) {
+    return dropped;
+}
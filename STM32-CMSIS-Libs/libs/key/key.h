@@ -0,0 +1,76 @@
+#ifndef KEY_H
+#define KEY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../gpio/gpio_pin.h"
+
+// Push buttons read by interrupts. An edge on a key's EXTI line masks the
+// line, so the bounces of the contact raise no further interrupts, and
+// starts a utimer. KEY_DEBOUNCE_MS later the level is read: if it differs
+// from the key's state it becomes the state and a PRESS or RELEASE event is
+// queued, then the line is unmasked. A key held for KEY_LONG_MS queues LONG, then REPEAT every
+// KEY_REPEAT_MS until it is released. Nothing polls the pins: an idle
+// keypad costs no CPU time.
+//
+// Keys are numbered by their place in the pin list given to key_init().
+// They are active low (pressed pulls the pin to ground) and get the internal
+// pull-up. Each key takes the EXTI line of its pin number, so the numbers
+// must differ from each other and from the DHT11 (PC4, EXTI4).
+//
+// Events go into a ring that the TIM5 interrupt (utimer) fills and one
+// reader empties with key_get(): no lock, no allocation. Queuing an event
+// calls delay_idle_wakeup() and the notify callback, if any.
+
+#define KEY_MAX_KEYS        8
+#define KEY_DEBOUNCE_MS     20
+#define KEY_LONG_MS         600
+#define KEY_REPEAT_MS       150
+// Ring size, a power of two
+#define KEY_QUEUE_LEN       16
+
+// The board key (key 1, PC1) takes EXTI1; key_exti_irq() is called from its
+// handler. Keys on other lines call key_exti_irq() from theirs.
+#define KEY_EXTI_IRQHandler EXTI1_IRQHandler
+
+typedef enum {
+    KEY_EVENT_PRESS = 0,
+    KEY_EVENT_RELEASE,
+    KEY_EVENT_LONG,             // held KEY_LONG_MS, once per press
+    KEY_EVENT_REPEAT            // held, every KEY_REPEAT_MS after LONG
+} KEY_EVENT;
+
+typedef struct {
+    uint8_t key;                // index into the key_init() list
+    uint8_t type;               // KEY_EVENT
+    uint32_t time_us;           // utimer_now() when the event was decided
+} key_event_t;
+
+// Called from the TIM5 interrupt after an event was queued
+typedef void (*key_notify_fn)(void *arg);
+
+/**
+ * @brief  Set up `pins` as inputs with pull-up and arm their EXTI lines on
+ *         both edges. A key held down at this point reports PRESS once
+ *         debounced.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 No pins, more than KEY_MAX_KEYS or two on one EXTI line.
+ */
+uint8_t key_init(const gpio_pin_t *pins, uint8_t count);
+
+void key_set_notify(key_notify_fn fn, void *arg);
+
+// Take the oldest event; false if there is none
+bool key_get(key_event_t *event);
+
+// Debounced state of a key
+bool key_pressed(uint8_t key);
+
+// Events lost because the ring was full
+uint32_t key_dropped(void);
+
+// Debounce edges of every key; call from the EXTI handler of each key line
+void key_exti_irq(void);
+
+#endif
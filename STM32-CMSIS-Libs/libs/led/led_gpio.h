@@ -4,10 +4,10 @@
 #include <stdint.h>
 #include "RTE_Components.h"
 #include CMSIS_device_header
+#include "../gpio/gpio_pin.h"
 
 /* Init the LED GPIO Port output */
 static inline void led_init(const char bank, const uint8_t pin) {
-    GPIO_TypeDef *gpio = (GPIO_TypeDef *) ( GPIOA_BASE + 0x400 * ( bank - 'A' ) );
     /* Set mode bits in CRL/CRH
      * 00: Input mode (reset state)
      * 01: Output mode, max speed 10 MHz.
@@ -29,17 +29,7 @@ static inline void led_init(const char bank, const uint8_t pin) {
      *  11: Alternate function output Open-drain
      * For LED devices, we use push-pull output.
     */
-    if ( pin < 8 ) {
-        // Reset the bits before setting the bits.
-        uint32_t pos = pin * 4;
-        gpio->CRL &= ~(0xF << pos);        // Clear 4 bits (1111 binary)
-        gpio->CRL |= (0x2 << pos);         // 0x2 (hex) -> 0010 (binary)
-    } else if ( pin < 16 ) {
-        // Reset the bits before setting the bits.
-        uint32_t pos = (pin - 8) * 4;
-        gpio->CRH &= ~(0xF << pos);        // Clear 4 bits (1111 binary)
-        gpio->CRH |= (0x2 << pos);         // 0x2 (hex) -> 0010 (binary)
-    }
+    gpio_pin_config(GPIO_PIN(bank, pin), GPIO_CFG_OUT_PP_2MHZ);
 }
 
 /* LED ON */
@@ -52,15 +42,13 @@ the GPIOx_BSRR register (x = A .. G).
      * Bits 15:0  BSy: Port x Set bit y (y= 0 .. 15)
      * Note: If both BSx and BRx are set, BSx has priority.
     */
-    GPIO_TypeDef *gpio = (GPIO_TypeDef *) ( GPIOA_BASE + 0x400 * ( bank - 'A' ) );
     /* Our LED is common anode LED, so reset means turn it on. */
-    gpio->BSRR = (1 << (pin + 16));
+    gpio_pin_low(GPIO_PIN(bank, pin));
 }
 
 /* LED OFF */
 static inline void led_off(const char bank, const uint8_t pin) {
-    GPIO_TypeDef *gpio = (GPIO_TypeDef *) ( GPIOA_BASE + 0x400 * ( bank - 'A' ) );
-    gpio->BSRR = (1 << pin);
+    gpio_pin_high(GPIO_PIN(bank, pin));
 }
 
-#endif
\ No newline at end of file
+#endif
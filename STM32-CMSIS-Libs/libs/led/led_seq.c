@@ -0,0 +1,156 @@
+#include "led_seq.h"
+#include "../delay/utimer.h"
+#include <stddef.h>
+
+#define GPIO_PORTS  7               // A .. G
+
+static const gpio_pin_t *leds;
+static uint8_t led_count;
+static bool leds_active_low;
+static uint16_t lit;
+static led_seq_t *tracks;           // playing, in no particular order
+static utimer_t timer;
+
+static bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+// Light the LEDs of `mask` that are set in `on` and turn off the others,
+// with one BSRR store per port. Called with interrupts disabled.
+static void show(uint16_t mask, uint16_t on) {
+    uint32_t bsrr[GPIO_PORTS] = { 0 };
+
+    lit = ( lit & ~mask ) | ( on & mask );
+    for ( uint8_t i = 0; i < led_count; i++ ) {
+        if ( !( mask & ( 1u << i ) ) ) continue;
+        bool high = ( ( lit >> i ) & 1 ) != leds_active_low;
+        uint32_t bit = gpio_pin_mask(leds[i]);
+        bsrr[leds[i].port] |= high ? bit : bit << 16;
+    }
+    for ( uint8_t port = 0; port < GPIO_PORTS; port++ ) {
+        if ( bsrr[port] ) gpio_pin_port((gpio_pin_t){ port, 0 })->BSRR = bsrr[port];
+    }
+}
+
+// The step shown by `seq` has ended: show the next one, or turn the LEDs
+// off after the last lap. Returns false when the track has finished.
+static bool advance(led_seq_t *seq) {
+    if ( ++seq->index == seq->count ) {
+        seq->index = 0;
+        if ( seq->loops != LED_SEQ_FOREVER && --seq->loops == 0 ) {
+            show(seq->mask, 0);
+            seq->playing = 0;
+            return 0;
+        }
+    }
+    show(seq->mask, seq->steps[seq->index].on);
+    seq->due += seq->steps[seq->index].ms * 1000u;
+    return 1;
+}
+
+static void tick(void *arg);
+
+// Re-arm the shared utimer for the earliest step. Called with interrupts
+// disabled.
+static void arm(void) {
+    utimer_cancel(&timer);
+    if ( tracks == NULL ) return;
+
+    uint32_t due = tracks->due;
+    for ( led_seq_t *seq = tracks->next; seq != NULL; seq = seq->next ) {
+        if ( before(seq->due, due) ) due = seq->due;
+    }
+    utimer_start_at(&timer, due, tick, NULL);
+}
+
+static void unlink(led_seq_t *seq) {
+    for ( led_seq_t **link = &tracks; *link != NULL; link = &( *link )->next ) {
+        if ( *link == seq ) {
+            *link = seq->next;
+            break;
+        }
+    }
+}
+
+// TIM5 interrupt: every step that is due, on all tracks. A late interrupt
+// catches up rather than shifting the pattern.
+static void tick(void *arg) {
+    (void)arg;
+    uint32_t now = utimer_now();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for ( led_seq_t **link = &tracks; *link != NULL; ) {
+        led_seq_t *seq = *link;
+        while ( !before(now, seq->due) && advance(seq) ) {}
+        if ( seq->playing ) {
+            link = &seq->next;
+        } else {
+            *link = seq->next;
+        }
+    }
+    arm();
+    __set_PRIMASK(primask);
+}
+
+uint8_t led_seq_init(const gpio_pin_t *pins, uint8_t count, bool active_low) {
+    if ( pins == NULL || count == 0 || count > LED_SEQ_MAX_LEDS ) return 1;
+
+    utimer_init();
+    leds = pins;
+    led_count = count;
+    leds_active_low = active_low;
+    for ( uint8_t i = 0; i < count; i++ ) {
+        gpio_pin_clock_enable(pins[i]);
+        gpio_pin_write(pins[i], active_low);
+        gpio_pin_config(pins[i], GPIO_CFG_OUT_PP_2MHZ);
+    }
+    lit = 0;
+    return 0;
+}
+
+uint8_t led_seq_play(led_seq_t *seq, const led_seq_step_t *steps, uint8_t count,
+                     uint16_t mask, uint16_t loops) {
+    mask &= (uint16_t)( ( 1u << led_count ) - 1 );
+    if ( steps == NULL || count == 0 || mask == 0 ) return 1;
+    for ( uint8_t i = 0; i < count; i++ ) {
+        if ( steps[i].ms == 0 ) return 1;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ( seq->playing ) unlink(seq);
+    seq->steps = steps;
+    seq->count = count;
+    seq->index = 0;
+    seq->mask = mask;
+    seq->loops = loops;
+    seq->due = utimer_now() + steps[0].ms * 1000u;
+    show(mask, steps[0].on);
+    seq->next = tracks;
+    tracks = seq;
+    seq->playing = 1;
+    arm();
+    __set_PRIMASK(primask);
+    return 0;
+}
+
+void led_seq_stop(led_seq_t *seq) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ( seq->playing ) {
+        unlink(seq);
+        show(seq->mask, 0);
+        seq->playing = 0;
+        arm();
+    }
+    __set_PRIMASK(primask);
+}
+
+bool led_seq_playing(const led_seq_t *seq) {
+    return seq->playing;
+}
+
+uint16_t led_seq_lit(void) {
+    return lit;
+}
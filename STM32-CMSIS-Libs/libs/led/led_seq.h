@@ -0,0 +1,68 @@
+#ifndef LED_SEQ_H
+#define LED_SEQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../gpio/gpio_pin.h"
+
+// LED patterns played from the TIM5 interrupt (utimer): no thread, stack or
+// busy loop per LED. The LEDs are numbered by their place in the pin list
+// given to led_seq_init(); a pattern is a table of steps, each a bit mask of
+// the LEDs that are lit and how long it lasts.
+//
+// Several patterns (tracks) can play at once, each on its own LEDs and with
+// its own timing. They share one utimer: its callback applies every step
+// that is due, writing each GPIO port's BSRR once, and re-arms for the
+// earliest next step. Steps follow their deadlines, not the interrupt
+// latency, so patterns do not drift.
+
+#define LED_SEQ_MAX_LEDS    16
+// Pattern loops until led_seq_stop()
+#define LED_SEQ_FOREVER     0
+
+typedef struct {
+    uint16_t on;                // LEDs lit during the step, bit n = LED n
+    uint16_t ms;                // 1 .. 65535
+} led_seq_step_t;
+
+typedef struct led_seq {
+    const led_seq_step_t *steps;
+    uint8_t count;
+    uint8_t index;              // step shown now
+    uint16_t mask;              // LEDs this track drives
+    uint16_t loops;             // laps left, LED_SEQ_FOREVER: no end
+    uint32_t due;               // utimer_now() of the next step
+    struct led_seq *next;
+    volatile bool playing;
+} led_seq_t;
+
+/**
+ * @brief  Make `pins` (clock, push-pull output) the sequencer's LEDs, all
+ *         off. `active_low` for common-anode LEDs, lit while the pin is low.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 No pins or more than LED_SEQ_MAX_LEDS.
+ */
+uint8_t led_seq_init(const gpio_pin_t *pins, uint8_t count, bool active_low);
+
+/**
+ * @brief  Play `steps` on the LEDs in `mask`, from the first step now.
+ *         `loops` laps (LED_SEQ_FOREVER: until stopped); at the end the
+ *         track's LEDs are turned off. A track already playing restarts
+ *         with the new pattern. Tracks playing at once should not share LEDs.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Empty pattern, a zero-length step or no LED in `mask`.
+ */
+uint8_t led_seq_play(led_seq_t *seq, const led_seq_step_t *steps, uint8_t count,
+                     uint16_t mask, uint16_t loops);
+
+// Stop the track and turn its LEDs off
+void led_seq_stop(led_seq_t *seq);
+
+bool led_seq_playing(const led_seq_t *seq);
+
+// LEDs lit now, bit n = LED n
+uint16_t led_seq_lit(void);
+
+#endif
@@ -2,10 +2,20 @@
 #define LIBS_COMMON_H
 
 // Mark if the project uses cmsis os.
+// The host simulation build overrides this from the command line.
+#ifndef USE_CMSIS_OS
 #define USE_CMSIS_OS 1
+#endif
 
 #if USE_CMSIS_OS
 #include "cmsis_os2.h"
 #endif
 
-#endif
\ No newline at end of file
+// Called in the body of every busy-wait loop on a peripheral register.
+// Empty on the target; the host simulation defines it to advance the
+// virtual clock so the loop can terminate.
+#ifndef HW_SPIN_HOOK
+#define HW_SPIN_HOOK()
+#endif
+
+#endif
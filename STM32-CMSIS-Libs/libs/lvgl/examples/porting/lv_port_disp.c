@@ -14,6 +14,7 @@
 #include <stdbool.h>
 
 #include "../../st7789/simple_st7789_driver.h"
+#include "../../profile/profile.h"
 
 /*********************
  *      DEFINES
@@ -152,6 +153,7 @@ void disp_disable_update(void)
 static void disp_flush(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
 {
     if(disp_flush_enabled) {
+        PROFILE_BEGIN(disp_flush);
         simple_st7789_set_window(area->x1, area->y1, area->x2, area->y2);
         simple_st7789_send_command(ST7789_RAMWR);
         
@@ -161,6 +163,7 @@ static void disp_flush(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_colo
         uint8_t* pixel_data = (uint8_t*)color_p;
         
         simple_st7789_send_data_buf(pixel_data, data_size);
+        PROFILE_END(disp_flush);
     }
 
     /*IMPORTANT!!!
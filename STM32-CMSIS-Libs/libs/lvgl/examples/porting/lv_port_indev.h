@@ -1,11 +1,10 @@
-
 /**
  * @file lv_port_indev_templ.h
  *
  */
 
 /*Copy this file as "lv_port_indev.h" and set this value to "1" to enable content*/
-#if 0
+#if 1
 
 #ifndef LV_PORT_INDEV_TEMPL_H
 #define LV_PORT_INDEV_TEMPL_H
@@ -17,7 +16,11 @@ extern "C" {
 /*********************
  *      INCLUDES
  *********************/
+#if defined(LV_LVGL_H_INCLUDE_SIMPLE)
+#include "lvgl.h"
+#else
 #include "lvgl/lvgl.h"
+#endif
 
 /*********************
  *      DEFINES
@@ -30,8 +33,22 @@ extern "C" {
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
+/* Initialize the keys (libs/key) and register them as LVGL keypad / encoder input devices.
+ * Call it after lv_port_disp_init(). It creates a group and makes it the default one, so the
+ * widgets created afterwards can be reached with the keys.
+ */
 void lv_port_indev_init(void);
 
+/* Feed the queued key events to LVGL. The input devices are in event mode: their read timers
+ * are paused, so LVGL never polls the keys and idle input costs nothing. Call it from the loop
+ * or thread that runs lv_timer_handler(), whenever it wakes up.
+ * Returns true if an event was read, the screen may need a refresh soon.
+ */
+bool lv_port_indev_process(void);
+
+/* Group the input devices control */
+lv_group_t * lv_port_indev_group(void);
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,122 @@
+#include "profile.h"
+#include "../console/console.h"
+#include <stdio.h>
+#include <string.h>
+
+static profile_probe_t probes[PROFILE_MAX_PROBES];
+static uint32_t probe_count = 0;
+
+uint8_t profile_init(void) {
+    // The trace block gates the DWT, including its cycle counter.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    if (DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk) return 1;
+
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    return 0;
+}
+
+static void probe_clear(profile_probe_t *p) {
+    const char *name = p->name;
+    memset(p, 0, sizeof(*p));
+    p->name = name;
+    p->min = UINT32_MAX;
+}
+
+profile_probe_t *profile_probe(const char *name) {
+    profile_probe_t *p = NULL;
+
+    // Probes register from interrupts too: look up and claim in one go
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0; i < probe_count && p == NULL; ++i) {
+        if (strcmp(probes[i].name, name) == 0) p = &probes[i];
+    }
+    if (p == NULL && probe_count < PROFILE_MAX_PROBES) {
+        p = &probes[probe_count];
+        p->name = name;
+        probe_clear(p);
+        ++probe_count;
+    }
+    __set_PRIMASK(primask);
+    return p;
+}
+
+void profile_record(profile_probe_t *p, uint32_t cycles) {
+    if (p == NULL) return;
+
+    uint32_t us = cycles / PROFILE_CPU_MHZ;
+    uint32_t bin = us ? 31 - __builtin_clz(us) : 0;
+    if (bin >= PROFILE_HIST_BINS) bin = PROFILE_HIST_BINS - 1;
+
+    // An interrupt may record into the same probe, or reset it
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ++p->count;
+    p->total += cycles;
+    if (cycles < p->min) p->min = cycles;
+    if (cycles > p->max) p->max = cycles;
+    ++p->hist[bin];
+    __set_PRIMASK(primask);
+}
+
+void profile_reset(void) {
+    for (uint32_t i = 0; i < probe_count; ++i) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        probe_clear(&probes[i]);
+        __set_PRIMASK(primask);
+    }
+}
+
+// Consistent copy of a probe that interrupts may be recording into
+static void probe_copy(profile_probe_t *dest, const profile_probe_t *p) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *dest = *p;
+    __set_PRIMASK(primask);
+}
+
+uint32_t profile_get_probes(profile_probe_t *dest, uint32_t max) {
+    uint32_t n = probe_count < max ? probe_count : max;
+    for (uint32_t i = 0; i < n; ++i) probe_copy(&dest[i], &probes[i]);
+    return n;
+}
+
+void profile_dump(void) {
+    char line[160];
+    int len;
+
+    len = snprintf(line, sizeof(line), "%-20s %8s %10s %10s %10s [us]\r\n",
+                   "probe", "count", "min", "mean", "max");
+    console_info((uint8_t *)line, len);
+
+    for (uint32_t i = 0; i < probe_count; ++i) {
+        profile_probe_t copy;
+        const profile_probe_t *p = &copy;
+        probe_copy(&copy, &probes[i]);
+        if (p->count == 0) continue;
+
+        uint32_t mean = (uint32_t)(p->total / p->count);
+        len = snprintf(line, sizeof(line), "%-20s %8lu %10lu %10lu %10lu\r\n", p->name,
+                       (unsigned long)p->count,
+                       (unsigned long)(p->min / PROFILE_CPU_MHZ),
+                       (unsigned long)(mean / PROFILE_CPU_MHZ),
+                       (unsigned long)(p->max / PROFILE_CPU_MHZ));
+        console_info((uint8_t *)line, len);
+
+        // Histogram: "<2us:n 2us:n 4us:n ..." for the non-empty bins
+        len = snprintf(line, sizeof(line), "%-20s", "");
+        for (uint32_t b = 0; b < PROFILE_HIST_BINS && len < (int)sizeof(line) - 24; ++b) {
+            if (p->hist[b] == 0) continue;
+            if (b == 0) {
+                len += snprintf(line + len, sizeof(line) - len, " <2us:%lu", (unsigned long)p->hist[b]);
+            } else {
+                len += snprintf(line + len, sizeof(line) - len, " %luus:%lu",
+                                1ul << b, (unsigned long)p->hist[b]);
+            }
+        }
+        len += snprintf(line + len, sizeof(line) - len, "\r\n");
+        console_info((uint8_t *)line, len);
+    }
+}
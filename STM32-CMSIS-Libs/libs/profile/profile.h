@@ -0,0 +1,84 @@
+#ifndef LIBS_PROFILE_H
+#define LIBS_PROFILE_H
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+#include <stdint.h>
+
+// Cycle profiler on the DWT cycle counter (72 MHz, wraps every ~59 s, so a
+// single probe may measure up to that).
+//
+//     PROFILE_BEGIN(lv_timer_handler);
+//     lv_timer_handler();
+//     PROFILE_END(lv_timer_handler);
+//
+// The identifier names the probe. Probes register themselves on their first
+// PROFILE_END; set PROFILE_ENABLE to 0 to compile every probe out.
+// Probes may be used in interrupt handlers: registration and recording mask
+// interrupts for the few instructions they take.
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 1
+#endif
+
+#define PROFILE_MAX_PROBES  16
+// Bin i counts durations in [2^i, 2^(i+1)) us; bin 0 takes everything below
+// 2 us and the last bin everything above.
+#define PROFILE_HIST_BINS   16
+#define PROFILE_CPU_MHZ     72
+
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t min;       // cycles
+    uint32_t max;       // cycles
+    uint64_t total;     // cycles
+    uint32_t hist[PROFILE_HIST_BINS];
+} profile_probe_t;
+
+/**
+ * @brief  Enable the DWT cycle counter.
+ * @return status code
+ *         - 0 success
+ *         - 1 the core has no cycle counter
+ */
+uint8_t profile_init(void);
+
+static inline uint32_t profile_cycles(void) {
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief  Find the probe called `name`, registering it on first use.
+ * @return probe, or NULL when all PROFILE_MAX_PROBES are taken
+ */
+profile_probe_t *profile_probe(const char *name);
+
+// Add one measurement of `cycles` to a probe (NULL is ignored).
+void profile_record(profile_probe_t *probe, uint32_t cycles);
+
+// Clear the statistics of every probe, keeping the registrations.
+void profile_reset(void);
+
+/**
+ * @brief Copy the registered probes.
+ * @return number of probes copied
+ */
+uint32_t profile_get_probes(profile_probe_t *dest, uint32_t max);
+
+// Print every probe (count, min/mean/max, histogram) with console_info().
+void profile_dump(void);
+
+#if PROFILE_ENABLE
+#define PROFILE_BEGIN(id) uint32_t profile_start_##id = profile_cycles()
+#define PROFILE_END(id) do { \
+    static profile_probe_t *profile_probe_##id; \
+    uint32_t profile_cycles_##id = profile_cycles() - profile_start_##id; \
+    if (profile_probe_##id == 0) profile_probe_##id = profile_probe(#id); \
+    profile_record(profile_probe_##id, profile_cycles_##id); \
+} while(0)
+#else
+#define PROFILE_BEGIN(id) do {} while(0)
+#define PROFILE_END(id)   do {} while(0)
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+#include "pwm_led.h"
+#include "../gpio/gpio_pin.h"
+#include "../bitband/bitband.h"
+#include <stddef.h>
+
+#define TIM_HZ  72000000u
+
+typedef struct {
+    gpio_pin_t pin;
+    uint8_t channel;            // 1 .. 4
+    bool active_low;            // on while the pin is low
+    uint16_t prescaler;         // PSC + 1
+    uint8_t repetition;         // periods per update (RCR + 1)
+} pwm_led_hw_t;
+
+static const pwm_led_hw_t outputs[PWM_LED_COUNT] = {
+    [PWM_LED_BACKLIGHT] = { GPIO_PIN_INIT('A', 8), 1, false, 1,
+                            TIM_HZ / PWM_LED_PERIOD / PWM_LED_STEP_HZ },
+    [PWM_LED_STATUS]    = { GPIO_PIN_INIT('D', 12), 1, true,
+                            TIM_HZ / PWM_LED_PERIOD / PWM_LED_STEP_HZ, 1 },
+};
+
+static bool inited[PWM_LED_COUNT];
+static uint8_t levels[PWM_LED_COUNT];
+
+// Register blocks are not constant expressions in the host build, so they
+// are picked here rather than kept in the table
+static TIM_TypeDef *led_timer(PWM_LED led) {
+    return led == PWM_LED_BACKLIGHT ? TIM1 : TIM4;
+}
+
+// DMA1 channel of the request that fires on the timer's update. TIM1's own
+// update request is on channel 5, the USART1 RX channel of Driver_USART1,
+// so the backlight takes the CC3 request with CR2.CCDS instead: channel 6,
+// sent on update events like UDE.
+static DMA_Channel_TypeDef *led_dma(PWM_LED led) {
+    return led == PWM_LED_BACKLIGHT ? DMA1_Channel6 : DMA1_Channel7;
+}
+
+// DIER bit of that request
+static uint16_t led_dma_request(PWM_LED led) {
+    return led == PWM_LED_BACKLIGHT ? TIM_DIER_CC3DE : TIM_DIER_UDE;
+}
+
+static volatile uint32_t *led_ccr(PWM_LED led) {
+    return &led_timer(led)->CCR1 + ( outputs[led].channel - 1 );
+}
+
+uint16_t pwm_led_duty(uint8_t level) {
+    uint32_t duty = (uint32_t)level * level * PWM_LED_PERIOD / ( 255u * 255u );
+    // The lowest levels stay distinct from off
+    return level != 0 && duty == 0 ? 1 : (uint16_t)duty;
+}
+
+uint8_t pwm_led_init(PWM_LED led) {
+    if ( led >= PWM_LED_COUNT ) return 1;
+    const pwm_led_hw_t *hw = &outputs[led];
+    TIM_TypeDef *tim = led_timer(led);
+
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+    if ( led == PWM_LED_BACKLIGHT ) {
+        RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+    } else {
+        // CH1..CH4 on PD12..PD15
+        RCC->APB2ENR |= RCC_APB2ENR_AFIOEN;
+        RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;
+        AFIO->MAPR |= AFIO_MAPR_TIM4_REMAP;
+    }
+
+    pwm_led_stop(led);
+    tim->CR1 = 0;
+    tim->PSC = hw->prescaler - 1;
+    tim->ARR = PWM_LED_PERIOD - 1;
+    tim->RCR = hw->repetition - 1;
+    *led_ccr(led) = 0;
+
+    // PWM mode 1 with CCR preload: a new compare value starts with the next
+    // period. An active-low LED takes the inverted output, so CCR is the on
+    // time either way.
+    uint32_t shift = ( ( hw->channel - 1 ) % 2 ) * 8;
+    volatile uint32_t *ccmr = hw->channel <= 2 ? &tim->CCMR1 : &tim->CCMR2;
+    *ccmr = ( *ccmr & ~( 0xFFu << shift ) ) |
+            ( ( TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE ) << shift );
+    uint32_t ccer = TIM_CCER_CC1E | ( hw->active_low ? TIM_CCER_CC1P : 0 );
+    tim->CCER = ( tim->CCER & ~( 0xFu << ( ( hw->channel - 1 ) * 4 ) ) ) |
+                ( ccer << ( ( hw->channel - 1 ) * 4 ) );
+    // Advanced timer outputs stay off until the main output enable
+    if ( led == PWM_LED_BACKLIGHT ) {
+        tim->BDTR = TIM_BDTR_MOE;
+        tim->CR2 = TIM_CR2_CCDS;
+    }
+
+    tim->CR1 = TIM_CR1_ARPE;
+    tim->EGR = TIM_EGR_UG;
+    tim->CR1 |= TIM_CR1_CEN;
+
+    gpio_pin_clock_enable(hw->pin);
+    gpio_pin_config(hw->pin, GPIO_CFG_AF_PP_50MHZ);
+
+    levels[led] = 0;
+    inited[led] = 1;
+    return 0;
+}
+
+void pwm_led_deinit(PWM_LED led) {
+    if ( led >= PWM_LED_COUNT || !inited[led] ) return;
+    const pwm_led_hw_t *hw = &outputs[led];
+
+    pwm_led_stop(led);
+    gpio_pin_write(hw->pin, hw->active_low);
+    gpio_pin_config(hw->pin, GPIO_CFG_OUT_PP_2MHZ);
+    TIM_TypeDef *tim = led_timer(led);
+    tim->CR1 = 0;
+    tim->CCER &= ~( 0xFu << ( ( hw->channel - 1 ) * 4 ) );
+    if ( led == PWM_LED_BACKLIGHT ) tim->BDTR = 0;
+
+    levels[led] = 0;
+    inited[led] = 0;
+}
+
+void pwm_led_set(PWM_LED led, uint8_t level) {
+    if ( led >= PWM_LED_COUNT || !inited[led] ) return;
+    pwm_led_stop(led);
+    *led_ccr(led) = pwm_led_duty(level);
+    levels[led] = level;
+}
+
+uint8_t pwm_led_level(PWM_LED led) {
+    return led < PWM_LED_COUNT ? levels[led] : 0;
+}
+
+void pwm_led_fill_fade(uint16_t *table, uint16_t steps, uint8_t from, uint8_t to) {
+    int32_t span = (int32_t)to - from;
+    for ( uint16_t i = 1; i <= steps; i++ ) {
+        table[i - 1] = pwm_led_duty((uint8_t)( from + span * i / steps ));
+    }
+}
+
+uint8_t pwm_led_play(PWM_LED led, const uint16_t *table, uint16_t steps, bool repeat) {
+    if ( led >= PWM_LED_COUNT || table == NULL || steps == 0 ) return 1;
+    if ( !inited[led] ) return 2;
+
+    pwm_led_stop(led);
+
+    // Memory to CCRx, 16 bit both sides, one entry per update request
+    DMA_Channel_TypeDef *dma = led_dma(led);
+    dma->CPAR = (uintptr_t)led_ccr(led);
+    dma->CMAR = (uintptr_t)table;
+    dma->CNDTR = steps;
+    dma->CCR = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_PSIZE_0 | DMA_CCR1_MSIZE_0 |
+               ( repeat ? DMA_CCR1_CIRC : 0 ) | DMA_CCR1_EN;
+    BITBAND_SET(led_timer(led)->DIER, led_dma_request(led));
+    return 0;
+}
+
+uint8_t pwm_led_fade(PWM_LED led, uint16_t *buffer, uint16_t steps, uint8_t to) {
+    if ( led >= PWM_LED_COUNT || buffer == NULL || steps == 0 ) return 1;
+    if ( !inited[led] ) return 2;
+
+    pwm_led_stop(led);
+    pwm_led_fill_fade(buffer, steps, levels[led], to);
+    levels[led] = to;
+    return pwm_led_play(led, buffer, steps, false);
+}
+
+bool pwm_led_playing(PWM_LED led) {
+    if ( led >= PWM_LED_COUNT || !inited[led] ) return 0;
+    DMA_Channel_TypeDef *dma = led_dma(led);
+    return ( dma->CCR & DMA_CCR1_EN ) && dma->CNDTR != 0;
+}
+
+void pwm_led_stop(PWM_LED led) {
+    if ( led >= PWM_LED_COUNT ) return;
+    BITBAND_CLEAR(led_timer(led)->DIER, led_dma_request(led));
+    led_dma(led)->CCR = 0;
+}
@@ -0,0 +1,89 @@
+#ifndef PWM_LED_H
+#define PWM_LED_H
+
+#include "RTE_Components.h"
+#include CMSIS_device_header
+#include <stdint.h>
+#include <stdbool.h>
+
+// Timer PWM brightness for the outputs of the board that sit on a timer
+// channel. Fades and patterns are tables of compare values that DMA copies
+// into CCRx on every update event of the timer, so once started they run
+// without an interrupt, a thread or any CPU time per step.
+//
+// Every output steps at PWM_LED_STEP_HZ:
+//  - PWM_LED_BACKLIGHT: ST7789 backlight PA8, TIM1_CH1. PWM at 20 kHz, the
+//    repetition counter makes every 100th period an update (DMA1 channel 6,
+//    the CC3 request sent on updates; channel 5 is left to USART1 RX).
+//  - PWM_LED_STATUS: LED 1 PD12 (common anode), TIM4_CH1 with the TIM4
+//    remap. TIM4 has no repetition counter, so its PWM runs at the step
+//    rate (DMA1 channel 7).
+// The other LEDs (PD11, PD9, PB8 with the remap) have no timer channel and
+// stay on led_gpio.h.
+
+typedef enum {
+    PWM_LED_BACKLIGHT = 0,
+    PWM_LED_STATUS,
+    PWM_LED_COUNT
+} PWM_LED;
+
+#define PWM_LED_STEP_HZ     200u
+// Compare value of full brightness (ARR + 1)
+#define PWM_LED_PERIOD      3600u
+// Table entries of a fade lasting `ms`
+#define PWM_LED_STEPS(ms)   ( (uint32_t)(ms) * PWM_LED_STEP_HZ / 1000u )
+
+/**
+ * @brief  Start the output's timer with the output off and switch its pin
+ *         to the timer.
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Unknown output.
+ */
+uint8_t pwm_led_init(PWM_LED led);
+
+// Stop the timer and return the pin to a GPIO output, off
+void pwm_led_deinit(PWM_LED led);
+
+// Compare value of perceived brightness `level` (0 off .. 255 full), gamma 2
+uint16_t pwm_led_duty(uint8_t level);
+
+// Set the brightness now, stopping a fade or pattern
+void pwm_led_set(PWM_LED led, uint8_t level);
+
+// Brightness last given to pwm_led_set() or pwm_led_fade()
+uint8_t pwm_led_level(PWM_LED led);
+
+/**
+ * @brief Fill `table` with a fade of `steps` entries from `from` to `to`
+ *        (the last entry is `to`, gamma corrected).
+ */
+void pwm_led_fill_fade(uint16_t *table, uint16_t steps, uint8_t from, uint8_t to);
+
+/**
+ * @brief  Play `table` of compare values (pwm_led_duty() or
+ *         pwm_led_fill_fade()), one entry per step. Once through, the output
+ *         keeps the last entry; with `repeat` the table loops until
+ *         pwm_led_set() or pwm_led_stop(). DMA reads the table while it
+ *         plays, so it must stay in place (flash or static RAM).
+ * @return status code
+ *         - 0 Success.
+ *         - 1 Unknown output or empty table.
+ *         - 2 Output not initialised.
+ */
+uint8_t pwm_led_play(PWM_LED led, const uint16_t *table, uint16_t steps, bool repeat);
+
+/**
+ * @brief  Fade from the current level to `to` in `steps` steps, using
+ *         `buffer` (`steps` entries, kept until the fade ends) as the table.
+ * @return status code, as pwm_led_play()
+ */
+uint8_t pwm_led_fade(PWM_LED led, uint16_t *buffer, uint16_t steps, uint8_t to);
+
+// A table is being played
+bool pwm_led_playing(PWM_LED led);
+
+// Stop a table where it is; the output keeps its current compare value
+void pwm_led_stop(PWM_LED led);
+
+#endif
@@ -0,0 +1,250 @@
+#include "sched.h"
+#include "../delay/delay.h"
+#include <stddef.h>
+
+#define SLOT_MASK   (SCHED_WHEEL_SLOTS - 1)
+#define LEVEL_SHIFT(level) ((level) * SCHED_WHEEL_BITS)
+// Longest delay the wheel can file exactly
+#define WHEEL_SPAN  ((1u << (SCHED_WHEEL_LEVELS * SCHED_WHEEL_BITS)) - 1)
+
+enum {
+    JOB_IDLE = 0,
+    JOB_QUEUED,
+    JOB_RUNNING,
+};
+
+// wheel[0] holds jobs due in the next 64 ticks, one slot per tick; each
+// further level is 64 times coarser and is cascaded into the level below
+// whenever that level wraps around.
+static sched_job_t *wheel[SCHED_WHEEL_LEVELS][SCHED_WHEEL_SLOTS];
+static uint64_t level0_used;        // bit i: wheel[0][i] is not empty
+static uint32_t wheel_time;         // next tick to be processed
+static uint32_t job_count = 0;
+static bool wheel_started = false;
+
+#if USE_CMSIS_OS
+#define SCHED_FLAG_WAKE 0x01
+static osMutexId_t sched_mutex = NULL;
+static osThreadId_t sched_thread = NULL;
+static const osMutexAttr_t sched_mutex_attr = { .name = "SchedMutex", .attr_bits = osMutexRecursive | osMutexPrioInherit };
+
+static void lock(void) {
+    if (sched_mutex != NULL) osMutexAcquire(sched_mutex, osWaitForever);
+}
+static void unlock(void) {
+    if (sched_mutex != NULL) osMutexRelease(sched_mutex);
+}
+static void wake_thread(void) {
+    if (sched_thread != NULL && osThreadGetId() != sched_thread) {
+        osThreadFlagsSet(sched_thread, SCHED_FLAG_WAKE);
+    }
+}
+#else
+#define lock()
+#define unlock()
+#define wake_thread()
+#endif
+
+static bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static void list_add(sched_job_t **head, sched_job_t *job) {
+    job->next = *head;
+    if (*head != NULL) (*head)->pprev = &job->next;
+    *head = job;
+    job->pprev = head;
+}
+
+static void list_del(sched_job_t *job) {
+    *job->pprev = job->next;
+    if (job->next != NULL) job->next->pprev = job->pprev;
+    job->next = NULL;
+    job->pprev = NULL;
+}
+
+// An empty wheel has nothing to cascade and simply follows the tick.
+static void wheel_sync(void) {
+    if (wheel_started && job_count > 0) return;
+    wheel_time = delay_get_tick();
+    level0_used = 0;
+    wheel_started = true;
+}
+
+// File a job by how far its deadline is from the wheel position.
+static void wheel_insert(sched_job_t *job) {
+    uint32_t delta = job->due - wheel_time;
+    uint32_t due = job->due;
+    uint32_t level;
+
+    if ((int32_t)delta < 0) {
+        // Already late: run on the next processed tick
+        delta = 0;
+        due = wheel_time;
+    } else if (delta > WHEEL_SPAN) {
+        // Too far: park it at the end of the wheel, it is re-filed on cascade
+        delta = WHEEL_SPAN;
+        due = wheel_time + WHEEL_SPAN;
+    }
+
+    for (level = 0; level < SCHED_WHEEL_LEVELS - 1; ++level) {
+        if (delta < (1u << LEVEL_SHIFT(level + 1))) break;
+    }
+    uint32_t slot = (due >> LEVEL_SHIFT(level)) & SLOT_MASK;
+    list_add(&wheel[level][slot], job);
+    if (level == 0) level0_used |= (uint64_t)1 << slot;
+}
+
+static void job_unlink(sched_job_t *job) {
+    // A level 0 slot may become empty; its bit is cleared when it is processed
+    list_del(job);
+    --job_count;
+}
+
+static void job_queue(sched_job_t *job) {
+    wheel_insert(job);
+    job->state = JOB_QUEUED;
+    ++job_count;
+}
+
+// Re-file every job of one slot of a coarser level.
+static void cascade(uint32_t level) {
+    uint32_t slot = (wheel_time >> LEVEL_SHIFT(level)) & SLOT_MASK;
+    sched_job_t *job = wheel[level][slot];
+
+    wheel[level][slot] = NULL;
+    while (job != NULL) {
+        sched_job_t *next = job->next;
+        wheel_insert(job);
+        job = next;
+    }
+}
+
+// Next tick at which the wheel has something to do: an occupied level 0
+// slot, or the end of the current level 0 round (cascade).
+static uint32_t next_wheel_tick(void) {
+    uint32_t idx = wheel_time & SLOT_MASK;
+    if (idx == 0) return wheel_time;
+
+    uint64_t ahead = level0_used >> idx;
+    if (ahead != 0) return wheel_time + __builtin_ctzll(ahead);
+    return wheel_time + (SCHED_WHEEL_SLOTS - idx);
+}
+
+void sched_add(sched_job_t *job, sched_fn_t fn, void *arg, uint32_t delay, uint32_t period) {
+    lock();
+    wheel_sync();
+    if (job->state == JOB_QUEUED) job_unlink(job);
+    job->fn = fn;
+    job->arg = arg;
+    job->period = period;
+    job->due = delay_get_tick() + delay;
+    job_queue(job);
+    unlock();
+    wake_thread();
+}
+
+void sched_remove(sched_job_t *job) {
+    lock();
+    if (job->state == JOB_QUEUED) job_unlink(job);
+    job->state = JOB_IDLE;
+    unlock();
+}
+
+void sched_set_next(sched_job_t *job, uint32_t delay) {
+    lock();
+    wheel_sync();
+    if (job->state == JOB_QUEUED) job_unlink(job);
+    job->due = delay_get_tick() + delay;
+    job_queue(job);
+    unlock();
+    wake_thread();
+}
+
+uint32_t sched_run(void) {
+    lock();
+    wheel_sync();
+    uint32_t now = delay_get_tick();
+
+    while (!before(now, wheel_time)) {
+        uint32_t idx = wheel_time & SLOT_MASK;
+
+        // Entering a new round of level 0: pull the next slot of each
+        // coarser level that wrapped as well
+        if (idx == 0) {
+            for (uint32_t level = 1; level < SCHED_WHEEL_LEVELS; ++level) {
+                cascade(level);
+                if ((wheel_time >> LEVEL_SHIFT(level)) & SLOT_MASK) break;
+            }
+        }
+
+        // Detach the slot before running anything, so jobs re-armed for
+        // "now" land in the next tick instead of this one
+        sched_job_t *pending = wheel[0][idx];
+        if (pending != NULL) pending->pprev = &pending;
+        wheel[0][idx] = NULL;
+        level0_used &= ~((uint64_t)1 << idx);
+        ++wheel_time;
+
+        while (pending != NULL) {
+            sched_job_t *job = pending;
+            job_unlink(job);
+            job->state = JOB_RUNNING;
+
+            unlock();
+            job->fn(job->arg);
+            lock();
+
+            if (job->state == JOB_RUNNING) {
+                if (job->period == 0) {
+                    job->state = JOB_IDLE;
+                } else {
+                    // Keep the phase, unless we fell more than a period behind
+                    uint32_t t = delay_get_tick();
+                    job->due += job->period;
+                    if (before(job->due, t)) job->due = t + job->period;
+                    job_queue(job);
+                }
+            }
+        }
+
+        // Skip the empty slots, but never past the present
+        now = delay_get_tick();
+        uint32_t next = next_wheel_tick();
+        wheel_time = before(now, next) ? now + 1 : next;
+    }
+
+    uint32_t wait = SCHED_NO_DEADLINE;
+    if (job_count > 0) {
+        uint32_t next = next_wheel_tick();
+        wait = before(now, next) ? next - now : 0;
+    }
+    unlock();
+    return wait;
+}
+
+void sched_poll(void) {
+    uint32_t next = sched_run();
+    if (next > DELAY_IDLE_MAX_MS) next = DELAY_IDLE_MAX_MS;
+    delay_idle(next);
+}
+
+#if USE_CMSIS_OS
+static void sched_thread_main(void *argument) {
+    (void)argument;
+    for (;;) {
+        uint32_t next = sched_run();
+        osThreadFlagsWait(SCHED_FLAG_WAKE, osFlagsWaitAny,
+                          next == SCHED_NO_DEADLINE ? osWaitForever : next);
+    }
+}
+
+osThreadId_t sched_start_thread(const osThreadAttr_t *attr) {
+    if (sched_mutex == NULL) {
+        sched_mutex = osMutexNew(&sched_mutex_attr);
+        if (sched_mutex == NULL) return NULL;
+    }
+    sched_thread = osThreadNew(sched_thread_main, NULL, attr);
+    return sched_thread;
+}
+#endif
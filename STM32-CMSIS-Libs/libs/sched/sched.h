@@ -0,0 +1,68 @@
+#ifndef LIBS_SCHED_H
+#define LIBS_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "libs_common.h"
+
+// Job scheduler on delay_get_tick() (1 ms). Jobs live in a hierarchical
+// timer wheel, 4 levels of 64 slots: adding, cancelling and expiring a job
+// are O(1), independent of how many jobs exist. Deadlines use wrap-safe
+// 32-bit arithmetic; delays longer than 2^24 ms (~4.6 h) are parked in the
+// last level and re-filed as they come closer.
+//
+// Jobs run from sched_run()/sched_poll() in the main loop, or from the
+// scheduler thread (sched_start_thread) with USE_CMSIS_OS. Do not call the
+// API from interrupt handlers. Jobs are owned by the caller (usually static).
+
+#define SCHED_NO_DEADLINE UINT32_MAX
+
+#define SCHED_WHEEL_BITS   6
+#define SCHED_WHEEL_SLOTS  (1u << SCHED_WHEEL_BITS)
+#define SCHED_WHEEL_LEVELS 4
+
+typedef void (*sched_fn_t)(void *arg);
+
+typedef struct sched_job {
+    sched_fn_t fn;
+    void *arg;
+    uint32_t period;            // ms, 0 for a one-shot job
+    uint32_t due;               // tick of the next run
+    uint8_t state;
+    struct sched_job *next;
+    struct sched_job **pprev;   // link pointing to this job, for O(1) unlink
+} sched_job_t;
+
+/**
+ * @brief Schedule `fn(arg)` to run after `delay` ms, then every `period` ms.
+ *        Adding a job that is already scheduled reschedules it.
+ */
+void sched_add(sched_job_t *job, sched_fn_t fn, void *arg, uint32_t delay, uint32_t period);
+
+// Cancel a job. Safe to call from the job itself.
+void sched_remove(sched_job_t *job);
+
+// Move the next run of a job to `delay` ms from now; from inside the job
+// this replaces the regular period once.
+void sched_set_next(sched_job_t *job, uint32_t delay);
+
+/**
+ * @brief  Run every job that is due.
+ * @return ms until the scheduler needs to run again, SCHED_NO_DEADLINE if
+ *         nothing is scheduled
+ */
+uint32_t sched_run(void);
+
+// sched_run(), then sleep until the next deadline or an interrupt.
+void sched_poll(void);
+
+#if USE_CMSIS_OS
+/**
+ * @brief  Run the jobs from a dedicated thread instead of the main loop.
+ *         The API may then be used from any thread.
+ * @return thread id, NULL on failure
+ */
+osThreadId_t sched_start_thread(const osThreadAttr_t *attr);
+#endif
+
+#endif
@@ -40,38 +40,17 @@
 #include CMSIS_device_header
 #include <stdint.h>
 #include "../delay/delay.h"
+#include "../gpio/gpio_pin.h"
+#include "../pwm/pwm_led.h"
+#include "st7789_spi_trace.h"
 
 extern ARM_DRIVER_SPI Driver_SPI1;
 
 // ST7789 GPIO引脚定义
-#define ST7789_CS_PORT   'E'    // 片选引脚 PE1
-#define ST7789_CS_PIN    1
-#define ST7789_DC_PORT   'E'    // 数据/命令引脚 PE0  
-#define ST7789_DC_PIN    0
-#define ST7789_RST_PORT  'E'    // 复位引脚 PE3
-#define ST7789_RST_PIN   3
-#define ST7789_BL_PORT   'A'    // 背光引脚 PA8
-#define ST7789_BL_PIN    8
-
-// GPIO操作宏定义
-#define GPIO_PORT(bank) ((GPIO_TypeDef *)(GPIOA_BASE + 0x400 * ((bank) - 'A')))
-#define GPIO_SET(port, pin) (port->BSRR = (1 << pin))
-#define GPIO_RESET(port, pin) (port->BSRR = (1 << (pin + 16)))
-
-// 初始化GPIO引脚为推挽输出模式
-static void gpio_init_output(char bank, uint8_t pin) {
-    GPIO_TypeDef *gpio = GPIO_PORT(bank);
-    
-    if (pin < 8) {
-        uint32_t pos = pin * 4;
-        gpio->CRL &= ~(0xF << pos);  // 清除配置位
-        gpio->CRL |= (0x2 << pos);   // 设置为2MHz输出，推挽模式
-    } else if (pin < 16) {
-        uint32_t pos = (pin - 8) * 4;
-        gpio->CRH &= ~(0xF << pos);  // 清除配置位
-        gpio->CRH |= (0x2 << pos);   // 设置为2MHz输出，推挽模式
-    }
-}
+#define ST7789_CS   GPIO_PIN('E', 1)    // 片选引脚 PE1
+#define ST7789_DC   GPIO_PIN('E', 0)    // 数据/命令引脚 PE0
+#define ST7789_RST  GPIO_PIN('E', 3)    // 复位引脚 PE3
+// 背光引脚 PA8 (TIM1_CH1)，由 pwm_led 的 PWM_LED_BACKLIGHT 调光
 
 // SPI事件回调函数
 static volatile uint8_t spi_transfer_complete = 0;
@@ -103,9 +82,8 @@ uint8_t st7789_interface_spi_init(void)
     int32_t status;
 
     // 初始化片选引脚
-    gpio_init_output(ST7789_CS_PORT, ST7789_CS_PIN);
-    GPIO_TypeDef *cs_port = GPIO_PORT(ST7789_CS_PORT);
-    GPIO_SET(cs_port, ST7789_CS_PIN); // 默认拉高片选
+    gpio_pin_config(ST7789_CS, GPIO_CFG_OUT_PP_2MHZ);
+    gpio_pin_high(ST7789_CS); // 默认拉高片选
 
     status = Driver_SPI1.Initialize(SPI1_Event_Callback);
     if (status != ARM_DRIVER_OK) {
@@ -152,15 +130,8 @@ uint8_t st7789_interface_spi_deinit(void)
         return 1;
     }
 
-    // 将片选引脚设置为输入模式
-    GPIO_TypeDef *gpio = GPIO_PORT(ST7789_CS_PORT);
-    if (ST7789_CS_PIN < 8) {
-        uint32_t pos = ST7789_CS_PIN * 4;
-        gpio->CRL &= ~(0xF << pos);  // 清除配置位，默认为浮空输入
-    } else if (ST7789_CS_PIN < 16) {
-        uint32_t pos = (ST7789_CS_PIN - 8) * 4;
-        gpio->CRH &= ~(0xF << pos);  // 清除配置位，默认为浮空输入
-    }
+    // 将片选引脚设置为输入模式（配置位清零）
+    gpio_pin_config(ST7789_CS, GPIO_CFG_ANALOG);
 
     return 0;
 }
@@ -177,10 +148,9 @@ uint8_t st7789_interface_spi_deinit(void)
 uint8_t st7789_interface_spi_write_cmd(uint8_t *buf, uint32_t len)
 {
     int32_t status;
-    GPIO_TypeDef *cs_port = GPIO_PORT(ST7789_CS_PORT);
-    
+
     // 拉低片选
-    GPIO_RESET(cs_port, ST7789_CS_PIN);
+    gpio_pin_low(ST7789_CS);
     
     uint32_t remaining = len;
     uint8_t *buf_ptr = buf;
@@ -189,9 +159,11 @@ uint8_t st7789_interface_spi_write_cmd(uint8_t *buf, uint32_t len)
         uint32_t to_send = ( remaining > 65535 ) ? 65535 : remaining;
 
         // 发送数据
+        st7789_spi_trace_begin();
         status = Driver_SPI1.Send(buf_ptr, to_send);
+        st7789_spi_trace_sent();
         if (status != ARM_DRIVER_OK) {
-            GPIO_SET(cs_port, ST7789_CS_PIN); // 失败时释放片选
+            gpio_pin_high(ST7789_CS); // 失败时释放片选
             return 1;
         }
 
@@ -201,13 +173,15 @@ uint8_t st7789_interface_spi_write_cmd(uint8_t *buf, uint32_t len)
             if (!Driver_SPI1.GetStatus().busy && spi_transfer_complete == 0) {
                 spi_transfer_complete = 1;
             }
+            HW_SPIN_HOOK();
         }
             
         // 检查是否有错误
         if (spi_transfer_complete == 2) {
-            GPIO_SET(cs_port, ST7789_CS_PIN); // 错误时释放片选
+            gpio_pin_high(ST7789_CS); // 错误时释放片选
             return 1;
         }
+        st7789_spi_trace_end(to_send, gpio_pin_output(ST7789_DC));
 
         buf_ptr += to_send;
         remaining -= to_send;
@@ -217,7 +191,7 @@ uint8_t st7789_interface_spi_write_cmd(uint8_t *buf, uint32_t len)
     }
 
     // 拉高片选
-    GPIO_SET(cs_port, ST7789_CS_PIN);
+    gpio_pin_high(ST7789_CS);
     
     return 0;
 }
@@ -254,11 +228,10 @@ void st7789_interface_debug_print(const char *const fmt, ...)
 uint8_t st7789_interface_cmd_data_gpio_init(void)
 {
     // 初始化DC引脚为输出模式
-    gpio_init_output(ST7789_DC_PORT, ST7789_DC_PIN);
-    
+    gpio_pin_config(ST7789_DC, GPIO_CFG_OUT_PP_2MHZ);
+
     // 设置默认状态为命令模式 (DC = 0)
-    GPIO_TypeDef *dc_port = GPIO_PORT(ST7789_DC_PORT);
-    GPIO_RESET(dc_port, ST7789_DC_PIN);
+    gpio_pin_low(ST7789_DC);
     
     return 0;
 }
@@ -272,17 +245,9 @@ uint8_t st7789_interface_cmd_data_gpio_init(void)
  */
 uint8_t st7789_interface_cmd_data_gpio_deinit(void)
 {
-    // 将DC引脚设置为输入模式（浮空输入）
-    GPIO_TypeDef *gpio = GPIO_PORT(ST7789_DC_PORT);
-    
-    if (ST7789_DC_PIN < 8) {
-        uint32_t pos = ST7789_DC_PIN * 4;
-        gpio->CRL &= ~(0xF << pos);  // 清除配置位，默认为浮空输入
-    } else if (ST7789_DC_PIN < 16) {
-        uint32_t pos = (ST7789_DC_PIN - 8) * 4;
-        gpio->CRH &= ~(0xF << pos);  // 清除配置位，默认为浮空输入
-    }
-    
+    // 将DC引脚设置为输入模式（配置位清零）
+    gpio_pin_config(ST7789_DC, GPIO_CFG_ANALOG);
+
     return 0;
 }
 
@@ -296,16 +261,9 @@ uint8_t st7789_interface_cmd_data_gpio_deinit(void)
  */
 uint8_t st7789_interface_cmd_data_gpio_write(uint8_t value)
 {
-    GPIO_TypeDef *dc_port = GPIO_PORT(ST7789_DC_PORT);
-    
-    if (value) {
-        // 数据模式 (DC = 1)
-        GPIO_SET(dc_port, ST7789_DC_PIN);
-    } else {
-        // 命令模式 (DC = 0)
-        GPIO_RESET(dc_port, ST7789_DC_PIN);
-    }
-    
+    // 数据模式 (DC = 1)，命令模式 (DC = 0)
+    gpio_pin_write(ST7789_DC, value != 0);
+
     return 0;
 }
 
@@ -319,11 +277,10 @@ uint8_t st7789_interface_cmd_data_gpio_write(uint8_t value)
 uint8_t st7789_interface_reset_gpio_init(void)
 {
     // 初始化RST引脚为输出模式
-    gpio_init_output(ST7789_RST_PORT, ST7789_RST_PIN);
-    
+    gpio_pin_config(ST7789_RST, GPIO_CFG_OUT_PP_2MHZ);
+
     // 设置默认状态为高电平（非复位状态）
-    GPIO_TypeDef *rst_port = GPIO_PORT(ST7789_RST_PORT);
-    GPIO_SET(rst_port, ST7789_RST_PIN);
+    gpio_pin_high(ST7789_RST);
     
     return 0;
 }
@@ -337,17 +294,9 @@ uint8_t st7789_interface_reset_gpio_init(void)
  */
 uint8_t st7789_interface_reset_gpio_deinit(void)
 {
-    // 将RST引脚设置为输入模式（浮空输入）
-    GPIO_TypeDef *gpio = GPIO_PORT(ST7789_RST_PORT);
-    
-    if (ST7789_RST_PIN < 8) {
-        uint32_t pos = ST7789_RST_PIN * 4;
-        gpio->CRL &= ~(0xF << pos);  // 清除配置位，默认为浮空输入
-    } else if (ST7789_RST_PIN < 16) {
-        uint32_t pos = (ST7789_RST_PIN - 8) * 4;
-        gpio->CRH &= ~(0xF << pos);  // 清除配置位，默认为浮空输入
-    }
-    
+    // 将RST引脚设置为输入模式（配置位清零）
+    gpio_pin_config(ST7789_RST, GPIO_CFG_ANALOG);
+
     return 0;
 }
 
@@ -361,16 +310,9 @@ uint8_t st7789_interface_reset_gpio_deinit(void)
  */
 uint8_t st7789_interface_reset_gpio_write(uint8_t value)
 {
-    GPIO_TypeDef *rst_port = GPIO_PORT(ST7789_RST_PORT);
-    
-    if (value) {
-        // 非复位状态 (RST = 1)
-        GPIO_SET(rst_port, ST7789_RST_PIN);
-    } else {
-        // 复位状态 (RST = 0)
-        GPIO_RESET(rst_port, ST7789_RST_PIN);
-    }
-    
+    // 非复位状态 (RST = 1)，复位状态 (RST = 0)
+    gpio_pin_write(ST7789_RST, value != 0);
+
     return 0;
 }
 
@@ -383,8 +325,8 @@ uint8_t st7789_interface_reset_gpio_write(uint8_t value)
  */
 uint8_t st7789_interface_backlight_gpio_init(void)
 {
-    // 初始化背光控制引脚为推挽输出模式
-    gpio_init_output(ST7789_BL_PORT, ST7789_BL_PIN);
+    // 背光引脚切换到 TIM1 PWM 输出，初始为关闭
+    if (pwm_led_init(PWM_LED_BACKLIGHT) != 0) return 1;
     
     return 0;
 }
@@ -398,8 +340,8 @@ uint8_t st7789_interface_backlight_gpio_init(void)
  */
 uint8_t st7789_interface_backlight_gpio_deinit(void)
 {
-    // 关闭背光
-    st7789_interface_backlight_gpio_write(0);
+    // 关闭背光，引脚恢复为推挽输出
+    pwm_led_deinit(PWM_LED_BACKLIGHT);
     
     return 0;
 }
@@ -414,15 +356,45 @@ uint8_t st7789_interface_backlight_gpio_deinit(void)
  */
 uint8_t st7789_interface_backlight_gpio_write(uint8_t value)
 {
-    GPIO_TypeDef *bl_port = GPIO_PORT(ST7789_BL_PORT);
-    
-    if (value) {
-        // 开启背光 (BL = 1)
-        GPIO_SET(bl_port, ST7789_BL_PIN);
-    } else {
-        // 关闭背光 (BL = 0)
-        GPIO_RESET(bl_port, ST7789_BL_PIN);
-    }
-    
+    // 开启背光 (全亮)，关闭背光 (占空比 0)
+    pwm_led_set(PWM_LED_BACKLIGHT, value != 0 ? 255 : 0);
+
+    return 0;
+}
+
+/**
+ * @brief     interface backlight brightness
+ * @param[in] level brightness (0=off, 255=full)
+ * @return    status code
+ *            - 0 success
+ * @note      stops a running fade
+ */
+uint8_t st7789_interface_backlight_level(uint8_t level)
+{
+    pwm_led_set(PWM_LED_BACKLIGHT, level);
+
+    return 0;
+}
+
+// 渐变表，DMA 在渐变期间读取
+static uint16_t backlight_fade[PWM_LED_STEPS(ST7789_BACKLIGHT_FADE_MAX_MS)];
+
+/**
+ * @brief     interface backlight fade
+ * @param[in] level brightness at the end (0=off, 255=full)
+ * @param[in] ms fade time, up to ST7789_BACKLIGHT_FADE_MAX_MS
+ * @return    status code
+ *            - 0 success
+ *            - 1 fade failed
+ * @note      returns at once, the timer and DMA run the fade
+ */
+uint8_t st7789_interface_backlight_fade(uint8_t level, uint32_t ms)
+{
+    uint32_t steps = PWM_LED_STEPS(ms);
+    if (steps > PWM_LED_STEPS(ST7789_BACKLIGHT_FADE_MAX_MS)) steps = PWM_LED_STEPS(ST7789_BACKLIGHT_FADE_MAX_MS);
+    if (steps == 0) return st7789_interface_backlight_level(level);
+
+    if (pwm_led_fade(PWM_LED_BACKLIGHT, backlight_fade, (uint16_t)steps, level) != 0) return 1;
+
     return 0;
 }
@@ -178,6 +178,31 @@ uint8_t st7789_interface_backlight_gpio_deinit(void);
  */
 uint8_t st7789_interface_backlight_gpio_write(uint8_t value);
 
+/**
+ * @brief Longest backlight fade; its table takes 2 bytes per 5 ms of RAM
+ */
+#define ST7789_BACKLIGHT_FADE_MAX_MS    1000
+
+/**
+ * @brief     interface backlight brightness
+ * @param[in] level brightness (0=off, 255=full)
+ * @return    status code
+ *            - 0 success
+ * @note      stops a running fade
+ */
+uint8_t st7789_interface_backlight_level(uint8_t level);
+
+/**
+ * @brief     interface backlight fade
+ * @param[in] level brightness at the end (0=off, 255=full)
+ * @param[in] ms fade time, up to ST7789_BACKLIGHT_FADE_MAX_MS
+ * @return    status code
+ *            - 0 success
+ *            - 1 fade failed
+ * @note      returns at once, the timer and DMA run the fade
+ */
+uint8_t st7789_interface_backlight_fade(uint8_t level, uint32_t ms);
+
 /**
  * @}
  */
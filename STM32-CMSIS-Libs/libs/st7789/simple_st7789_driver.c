@@ -629,3 +629,24 @@ uint8_t simple_st7789_draw_triangle_transparent(uint16_t x1, uint16_t y1, uint16
     
     return 0;
 }
+
+/**
+ * @brief 设置背光亮度
+ * @param level 亮度 (0=关闭, 255=全亮)
+ * @return 0=成功, 其他=失败
+ */
+uint8_t simple_st7789_set_backlight(uint8_t level)
+{
+    return st7789_interface_backlight_level(level);
+}
+
+/**
+ * @brief 背光渐变到指定亮度，由定时器和 DMA 完成，立即返回
+ * @param level 目标亮度 (0=关闭, 255=全亮)
+ * @param ms 渐变时间，最长 ST7789_BACKLIGHT_FADE_MAX_MS
+ * @return 0=成功, 其他=失败
+ */
+uint8_t simple_st7789_fade_backlight(uint8_t level, uint32_t ms)
+{
+    return st7789_interface_backlight_fade(level, ms);
+}
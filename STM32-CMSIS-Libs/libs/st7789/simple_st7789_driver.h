@@ -52,6 +52,10 @@ uint8_t simple_st7789_send_data(uint8_t data);
 uint8_t simple_st7789_send_data_16(uint16_t data);
 uint8_t simple_st7789_send_data_buf(uint8_t* buf, uint32_t len);
 
+// 背光调光 (0=关闭, 255=全亮)，渐变由定时器和 DMA 完成，立即返回
+uint8_t simple_st7789_set_backlight(uint8_t level);
+uint8_t simple_st7789_fade_backlight(uint8_t level, uint32_t ms);
+
 // 字符绘制函数
 uint8_t simple_st7789_draw_char(uint16_t x, uint16_t y, char c, uint16_t fg_color, uint16_t bg_color);
 uint8_t simple_st7789_draw_string(uint16_t x, uint16_t y, const char* str, uint16_t fg_color, uint16_t bg_color);
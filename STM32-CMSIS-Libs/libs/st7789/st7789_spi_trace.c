@@ -0,0 +1,130 @@
+#include "st7789_spi_trace.h"
+#include "../console/console.h"
+#include "../delay/delay.h"
+#include "RTE_Components.h"
+#include CMSIS_device_header
+#include <stdio.h>
+#include <string.h>
+
+// TIM6 is the free running 1 MHz counter started by delay_init(). Transfers
+// are split into 64 KiB chunks (< 15 ms at 36 MHz), so 16 bits are enough.
+#define TRACE_US() ((uint16_t)TIM6->CNT)
+
+static st7789_spi_trace_entry_t ring[ST7789_SPI_TRACE_DEPTH];
+static uint32_t ring_head;
+static uint32_t ring_count;
+
+static uint32_t window_start_ms;
+static uint32_t cmd_transactions;
+static uint32_t data_transactions;
+static uint64_t total_bytes;
+static uint64_t total_setup_us;
+static uint64_t total_wait_us;
+
+#if ST7789_SPI_TRACE
+static uint32_t begin_ms;
+static uint16_t begin_us;
+static uint16_t sent_us;
+
+void st7789_spi_trace_begin(void) {
+    begin_ms = delay_get_tick();
+    begin_us = TRACE_US();
+}
+
+void st7789_spi_trace_sent(void) {
+    sent_us = TRACE_US();
+}
+
+void st7789_spi_trace_end(uint32_t len, uint8_t is_data) {
+    uint16_t end_us = TRACE_US();
+    st7789_spi_trace_entry_t *e = &ring[ring_head];
+
+    e->timestamp_ms = begin_ms;
+    e->len = len;
+    e->setup_us = (uint16_t)(sent_us - begin_us);
+    e->wait_us = (uint16_t)(end_us - sent_us);
+    e->is_data = is_data;
+
+    ring_head = (ring_head + 1) % ST7789_SPI_TRACE_DEPTH;
+    if (ring_count < ST7789_SPI_TRACE_DEPTH) ++ring_count;
+
+    if (is_data) ++data_transactions;
+    else ++cmd_transactions;
+    total_bytes += len;
+    total_setup_us += e->setup_us;
+    total_wait_us += e->wait_us;
+}
+#endif
+
+void st7789_spi_trace_reset(void) {
+    ring_head = 0;
+    ring_count = 0;
+    cmd_transactions = 0;
+    data_transactions = 0;
+    total_bytes = 0;
+    total_setup_us = 0;
+    total_wait_us = 0;
+    window_start_ms = delay_get_tick();
+}
+
+void st7789_spi_trace_get_summary(st7789_spi_trace_summary_t *s) {
+    uint64_t busy_us = total_setup_us + total_wait_us;
+    uint64_t payload_us = total_bytes * 8 * 1000000 / ST7789_SPI_TRACE_BUS_HZ;
+
+    // Per-transaction times are rounded to whole microseconds, so very short
+    // transfers can look faster than the wire.
+    if (payload_us > busy_us) payload_us = busy_us;
+
+    memset(s, 0, sizeof(*s));
+    s->window_ms = delay_get_tick() - window_start_ms;
+    s->transactions = cmd_transactions + data_transactions;
+    s->cmd_transactions = cmd_transactions;
+    s->data_transactions = data_transactions;
+    s->bytes = total_bytes;
+    s->busy_us = busy_us;
+    s->payload_us = payload_us;
+    s->overhead_us = busy_us - payload_us;
+    if (s->window_ms) s->utilisation_pct = (uint32_t)(busy_us / 10 / s->window_ms);
+    if (s->transactions) s->avg_len = (uint32_t)(total_bytes / s->transactions);
+    if (busy_us) s->overhead_pct = (uint32_t)(s->overhead_us * 100 / busy_us);
+}
+
+uint32_t st7789_spi_trace_get_entries(st7789_spi_trace_entry_t *dest, uint32_t max) {
+    uint32_t n = ring_count < max ? ring_count : max;
+    uint32_t first = (ring_head + ST7789_SPI_TRACE_DEPTH - n) % ST7789_SPI_TRACE_DEPTH;
+    for (uint32_t i = 0; i < n; ++i) {
+        dest[i] = ring[(first + i) % ST7789_SPI_TRACE_DEPTH];
+    }
+    return n;
+}
+
+void st7789_spi_trace_dump(uint8_t entries) {
+    char line[128];
+    int len;
+    st7789_spi_trace_summary_t s;
+
+    st7789_spi_trace_get_summary(&s);
+    len = snprintf(line, sizeof(line),
+                   "spi: %lu ms, %lu tx (%lu cmd / %lu data), %lu bytes, avg %lu B\r\n",
+                   (unsigned long)s.window_ms, (unsigned long)s.transactions,
+                   (unsigned long)s.cmd_transactions, (unsigned long)s.data_transactions,
+                   (unsigned long)s.bytes, (unsigned long)s.avg_len);
+    console_debug((uint8_t *)line, len);
+    len = snprintf(line, sizeof(line),
+                   "spi: busy %lu us (%lu%%), payload %lu us, overhead %lu us (%lu%%)\r\n",
+                   (unsigned long)s.busy_us, (unsigned long)s.utilisation_pct,
+                   (unsigned long)s.payload_us, (unsigned long)s.overhead_us,
+                   (unsigned long)s.overhead_pct);
+    console_debug((uint8_t *)line, len);
+
+    if (!entries) return;
+
+    st7789_spi_trace_entry_t e[ST7789_SPI_TRACE_DEPTH];
+    uint32_t n = st7789_spi_trace_get_entries(e, ST7789_SPI_TRACE_DEPTH);
+    for (uint32_t i = 0; i < n; ++i) {
+        len = snprintf(line, sizeof(line), "%8lu ms %s %6lu B setup %5u us wait %5u us\r\n",
+                       (unsigned long)e[i].timestamp_ms, e[i].is_data ? "DATA" : "CMD ",
+                       (unsigned long)e[i].len, e[i].setup_us, e[i].wait_us);
+        console_debug((uint8_t *)line, len);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef ST7789_SPI_TRACE_H
+#define ST7789_SPI_TRACE_H
+
+#include <stdint.h>
+
+// Record every st7789_interface_spi_write_cmd() transaction. Costs a few
+// register reads per transfer, so it is off by default on the target.
+#ifndef ST7789_SPI_TRACE
+#define ST7789_SPI_TRACE 0
+#endif
+
+// Number of transactions kept in the ring buffer.
+#define ST7789_SPI_TRACE_DEPTH 64
+
+// SPI clock requested in st7789_interface_spi_init(), used to split the bus
+// time into payload (bits on the wire) and overhead (everything else).
+#define ST7789_SPI_TRACE_BUS_HZ 36000000
+
+typedef struct {
+    uint32_t timestamp_ms;  // delay_get_tick() when CS went low
+    uint32_t len;           // bytes sent
+    uint16_t setup_us;      // time spent inside Send()
+    uint16_t wait_us;       // Send() returned -> transfer complete
+    uint8_t  is_data;       // DC level: 1 data, 0 command
+} st7789_spi_trace_entry_t;
+
+typedef struct {
+    uint32_t window_ms;         // time since the last reset
+    uint32_t transactions;
+    uint32_t cmd_transactions;
+    uint32_t data_transactions;
+    uint64_t bytes;
+    uint64_t busy_us;           // Send() + completion wait, summed
+    uint64_t payload_us;        // bytes * 8 / ST7789_SPI_TRACE_BUS_HZ
+    uint64_t overhead_us;       // busy_us - payload_us: setup plus idle bus
+                                // time, not the entries' setup_us summed
+    uint32_t utilisation_pct;   // busy_us / window
+    uint32_t avg_len;           // bytes per transaction
+    uint32_t overhead_pct;      // overhead_us / busy_us
+} st7789_spi_trace_summary_t;
+
+#if ST7789_SPI_TRACE
+void st7789_spi_trace_begin(void);
+void st7789_spi_trace_sent(void);
+void st7789_spi_trace_end(uint32_t len, uint8_t is_data);
+#else
+#define st7789_spi_trace_begin()
+#define st7789_spi_trace_sent()
+#define st7789_spi_trace_end(len, is_data)
+#endif
+
+/**
+ * @brief Clear the ring buffer and counters and start a new window.
+ */
+void st7789_spi_trace_reset(void);
+
+/**
+ * @brief Compute the totals of the current window.
+ */
+void st7789_spi_trace_get_summary(st7789_spi_trace_summary_t *summary);
+
+/**
+ * @brief Copy up to `max` of the most recent transactions, oldest first.
+ * @return number of entries copied
+ */
+uint32_t st7789_spi_trace_get_entries(st7789_spi_trace_entry_t *dest, uint32_t max);
+
+/**
+ * @brief Print the summary and the recorded transactions with console_debug().
+ * @param entries also print the ring buffer, not only the summary
+ */
+void st7789_spi_trace_dump(uint8_t entries);
+
+#endif
@@ -1,6 +1,7 @@
 #include "simple_usart1.h"
 #include "stm32f10x.h"
 #include <stdint.h>
+#include "../bitband/bitband.h"
 
 #ifdef SIMPLE_USART_USES_INTERRUPT
 volatile uint8_t usart1_rx_buffer[256];
@@ -128,12 +129,12 @@ uint8_t usart1_send(void* buf, uint32_t len) {
     uint8_t* data = (uint8_t*)buf;
     
     for (uint32_t i = 0; i < len; i++) {
-        while (!(USART1->SR & USART_SR_TXE)) {}
+        while (!BITBAND_READ(USART1->SR, USART_SR_TXE)) {}
         
         USART1->DR = data[i];
     }
     
-    while (!(USART1->SR & USART_SR_TC)) {}
+    while (!BITBAND_READ(USART1->SR, USART_SR_TC)) {}
     
     return 0;
 }
@@ -143,10 +144,10 @@ uint8_t usart1_receive(void* buf, uint32_t len) {
     uint32_t _size = 0;
     volatile uint32_t timeout = 100;
     // 等待接收数据寄存器非空
-    while ( !(USART1->SR & USART_SR_RXNE) && timeout > 0 ) {
+    while ( !BITBAND_READ(USART1->SR, USART_SR_RXNE) && timeout > 0 ) {
         timeout--;
     }
-    if ( USART1->SR & USART_SR_RXNE )
+    if ( BITBAND_READ(USART1->SR, USART_SR_RXNE) )
         *data = (uint8_t)(USART1->DR & 0xFF);
     else
         return 1;
@@ -0,0 +1,129 @@
+/*
+ * Throughput of libs/dsp on the host: each stage and the chain sample 07
+ * runs (CIC by 16, then a biquad low-pass) over a noisy 12-bit ADC stream
+ * sampled at 1 kHz. Reports host samples per second and the noise left at
+ * the output, in ADC counts.
+ *
+ * Usage: bench_dsp [samples]
+ */
+#include "dsp/dsp.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FS_HZ       1000.0f
+#define BLOCK       64          // samples per call, like a DMA half-block
+#define LEVEL       2048        // DC level of the input
+#define FIR_TAPS    31
+
+static uint32_t rng_state = 12345;
+static uint32_t rng(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static double cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// LEVEL + 50 Hz hum + uniform noise, +-200 counts in total
+static void make_input(uint16_t *adc, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        float hum = 80.0f * sinf(2.0f * 3.14159265f * 50.0f * i / FS_HZ);
+        int32_t v = LEVEL + (int32_t)hum + (int32_t)(rng() % 241) - 120;
+        adc[i] = (uint16_t)(v < 0 ? 0 : v > 4095 ? 4095 : v);
+    }
+}
+
+// RMS distance from LEVEL in counts, skipping the first `settle` samples
+static double noise(const q15_t *q, uint32_t n, uint32_t settle) {
+    double sum = 0;
+    for (uint32_t i = settle; i < n; ++i) {
+        double d = q[i] / 8.0 - LEVEL;
+        sum += d * d;
+    }
+    return n > settle ? sqrt(sum / (n - settle)) : 0;
+}
+
+static void report(const char *name, double ns, uint32_t in, double rms) {
+    printf("%-18s %12.1f %10.2f %10.1f\n", name, in / ns * 1e3, ns / in, rms);
+}
+
+int main(int argc, char **argv) {
+    uint32_t n = argc > 1 ? (uint32_t)atoi(argv[1]) : 1u << 22;
+    n -= n % BLOCK;
+    if (n == 0) return 1;
+
+    uint16_t *adc = malloc(n * sizeof(uint16_t));
+    q15_t *q = malloc(n * sizeof(q15_t));
+    q15_t *out = malloc(n * sizeof(q15_t));
+    make_input(adc, n);
+    for (uint32_t i = 0; i < n; i += BLOCK) dsp_adc_to_q15(adc + i, 1, q + i, BLOCK);
+
+    printf("%u samples of 12-bit input at %.0f Hz, input noise %.1f counts rms\n",
+           n, FS_HZ, noise(q, n, 0));
+    printf("%-18s %12s %10s %10s\n", "stage", "Msamples/s", "ns/sample", "rms out");
+
+    double t0 = cpu_ns();
+    for (uint32_t i = 0; i < n; i += BLOCK) dsp_adc_to_q15(adc + i, 1, out + i, BLOCK);
+    report("adc_to_q15", cpu_ns() - t0, n, noise(out, n, 0));
+
+    dsp_cic_t cic;
+    dsp_cic_init(&cic, 3, 4);
+    uint32_t m = 0;
+    t0 = cpu_ns();
+    for (uint32_t i = 0; i < n; i += BLOCK) m += dsp_cic_decimate(&cic, adc + i, 1, out + m, BLOCK);
+    report("cic 3 x /16", cpu_ns() - t0, n, noise(out, m, 4));
+
+    // Windowed-sinc low-pass at fs / 10 (Hamming) for decimation by 4
+    q15_t coeffs[FIR_TAPS];
+    q15_t fir_state[2 * FIR_TAPS];
+    float h[FIR_TAPS], sum = 0;
+    for (int k = 0; k < FIR_TAPS; ++k) {
+        float x = k - (FIR_TAPS - 1) / 2.0f;
+        float sinc = x == 0 ? 0.2f : sinf(0.2f * 3.14159265f * x) / (3.14159265f * x);
+        h[k] = sinc * (0.54f - 0.46f * cosf(2.0f * 3.14159265f * k / (FIR_TAPS - 1)));
+        sum += h[k];
+    }
+    for (int k = 0; k < FIR_TAPS; ++k) coeffs[k] = (q15_t)lrintf(h[k] / sum * 32767.0f);
+    dsp_fir_t fir;
+    dsp_fir_init(&fir, coeffs, FIR_TAPS, fir_state, 4);
+    m = 0;
+    t0 = cpu_ns();
+    for (uint32_t i = 0; i < n; i += BLOCK) m += dsp_fir_decimate(&fir, q + i, 1, out + m, BLOCK);
+    report("fir 31 taps /4", cpu_ns() - t0, n, noise(out, m, FIR_TAPS));
+
+    dsp_biquad_t biquad;
+    dsp_biquad_lowpass(&biquad, 20.0f, FS_HZ);
+    t0 = cpu_ns();
+    for (uint32_t i = 0; i < n; i += BLOCK) dsp_biquad_process(&biquad, q + i, out + i, BLOCK);
+    report("biquad 20 Hz", cpu_ns() - t0, n, noise(out, n, 1000));
+
+    q15_t history[16];
+    dsp_mavg_t mavg;
+    dsp_mavg_init(&mavg, history, 16, (q15_t)(LEVEL << 3));
+    t0 = cpu_ns();
+    for (uint32_t i = 0; i < n; i += BLOCK) dsp_mavg_process(&mavg, q + i, out + i, BLOCK);
+    report("mavg 16", cpu_ns() - t0, n, noise(out, n, 16));
+
+    // Sample 07: CIC down to 62.5 Hz, then a 5 Hz low-pass on the few outputs
+    q15_t block[BLOCK];
+    dsp_cic_init(&cic, 3, 4);
+    dsp_biquad_lowpass(&biquad, 5.0f, FS_HZ / 16);
+    m = 0;
+    t0 = cpu_ns();
+    for (uint32_t i = 0; i < n; i += BLOCK) {
+        uint16_t k = dsp_cic_decimate(&cic, adc + i, 1, block, BLOCK);
+        dsp_biquad_process(&biquad, block, out + m, k);
+        m += k;
+    }
+    report("cic /16 + biquad", cpu_ns() - t0, n, noise(out, m, 100));
+
+    free(adc);
+    free(q);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * Benchmark of libs/sched against polling timer_expired() for every job.
+ * Thousands of periodic jobs run for a stretch of virtual time that crosses
+ * the 32-bit tick wrap; host CPU time per tick and deadline accuracy are
+ * reported for both.
+ *
+ * Usage: bench_sched [jobs] [virtual seconds]
+ */
+#include "sim.h"
+#include "delay/delay.h"
+#include "sched/sched.h"
+#include <stdlib.h>
+#include <time.h>
+
+extern volatile uint32_t systick_counter;
+
+typedef struct {
+    sched_job_t job;
+    uint32_t expected;      // tick the job should run at
+    uint32_t polled;        // timer_expired() state
+    uint32_t period;
+} bench_job_t;
+
+static bench_job_t *jobs;
+static uint32_t fired;
+static uint32_t max_late;
+static uint32_t early;
+
+static uint32_t rng_state = 12345;
+static uint32_t rng(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static double cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check(bench_job_t *b) {
+    uint32_t now = delay_get_tick();
+    int32_t late = (int32_t)(now - b->expected);
+    if (late < 0) ++early;
+    else if ((uint32_t)late > max_late) max_late = late;
+    b->expected += b->period;
+    ++fired;
+}
+
+static void job_fn(void *arg) {
+    check(arg);
+}
+
+static void reset_results(void) {
+    fired = 0;
+    max_late = 0;
+    early = 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t count = argc > 1 ? (uint32_t)atoi(argv[1]) : 4096;
+    uint32_t run_ms = (argc > 2 ? (uint32_t)atoi(argv[2]) : 60) * 1000;
+
+    sim_init();
+    delay_init();
+    // Start shortly before the tick counter wraps
+    systick_counter = 0xFFFFFFFFu - run_ms / 2;
+
+    jobs = calloc(count, sizeof(bench_job_t));
+    uint32_t start = delay_get_tick();
+    for (uint32_t i = 0; i < count; ++i) {
+        jobs[i].period = 1 + rng() % 5000;
+        jobs[i].expected = start + 1 + rng() % jobs[i].period;
+    }
+
+    printf("%u jobs, %u ms from tick 0x%08x\n", count, run_ms, start);
+    printf("%-16s %12s %10s %10s %8s\n", "method", "ns/tick", "runs", "max late", "early");
+
+    // Timer wheel
+    reset_results();
+    for (uint32_t i = 0; i < count; ++i) {
+        sched_add(&jobs[i].job, job_fn, &jobs[i], jobs[i].expected - start, jobs[i].period);
+    }
+    double spent = 0;
+    for (uint32_t t = 0; t < run_ms; ++t) {
+        sim_advance_ms(1);
+        double t0 = cpu_ns();
+        sched_run();
+        spent += cpu_ns() - t0;
+    }
+    printf("%-16s %12.0f %10u %10u %8u\n", "sched (wheel)", spent / run_ms, fired, max_late, early);
+
+    // Churn: rescheduling cost with every job queued
+    double t0 = cpu_ns();
+    for (uint32_t i = 0; i < 1000000; ++i) {
+        sched_set_next(&jobs[rng() % count].job, 1 + rng() % 100000);
+    }
+    printf("%-16s %12.1f ns per sched_set_next\n", "reschedule", (cpu_ns() - t0) / 1000000);
+    for (uint32_t i = 0; i < count; ++i) sched_remove(&jobs[i].job);
+
+    // The same jobs polled with timer_expired()
+    reset_results();
+    start = delay_get_tick();
+    for (uint32_t i = 0; i < count; ++i) {
+        jobs[i].expected = start + 1 + rng() % jobs[i].period;
+        jobs[i].polled = jobs[i].expected;
+    }
+    spent = 0;
+    for (uint32_t t = 0; t < run_ms; ++t) {
+        sim_advance_ms(1);
+        uint32_t now = delay_get_tick();
+        double t1 = cpu_ns();
+        for (uint32_t i = 0; i < count; ++i) {
+            if (timer_expired(&jobs[i].polled, jobs[i].period, now)) check(&jobs[i]);
+        }
+        spent += cpu_ns() - t1;
+    }
+    printf("%-16s %12.0f %10u %10u %8u\n", "timer_expired", spent / run_ms, fired, max_late, early);
+
+    free(jobs);
+    return 0;
+}
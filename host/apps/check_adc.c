@@ -0,0 +1,408 @@
+/*
+ * Checks the ADC scan against known waveforms. Every simulated channel
+ * returns its own number in the top four bits and the conversion time in
+ * microseconds in the low eight, so each sample in the ring shows which
+ * channel it came from and when it was converted:
+ * - blocks handed to the callback follow the scan order with one conversion
+ *   time step between samples, across half and lap boundaries;
+ * - adc_scan_latest() is never older than two frames;
+ * - masking the DMA interrupt for longer than a half counts an overrun;
+ * - adc_get_single() returns scan values while scanning and converts on
+ *   demand again after adc_scan_stop();
+ * - with a sample rate, TIM3 starts every frame exactly one period after the
+ *   previous one, while the CPU sleeps or not, and rates a frame cannot keep
+ *   up with are refused;
+ * - oversampled channels return the exact 12 + n bit mean of an input that
+ *   dithers by one LSB, without an on_block callback;
+ * - a fast adc_watch reports each crossing of its hysteresis band from the
+ *   analog watchdog on the conversion that crossed, and a noisy triangle
+ *   gives exactly two level events per period, hardware or software fed;
+ * - the injected group, on TIM2 or on demand, delivers its channels with a
+ *   timestamp of their last conversion while the regular scan goes on
+ *   without losing a frame.
+ *
+ * Usage: check_adc
+ * Exits with 1 on the first mismatch.
+ */
+#include "sim.h"
+#include "stm32f10x.h"
+#include "adc/adc.h"
+#include "adc/adc_scan.h"
+#include "adc/adc_watch.h"
+#include "adc/adc_injected.h"
+#include "delay/delay.h"
+#include <stdlib.h>
+
+#define FRAMES      16
+#define CONV_NS     21000u      // 239.5 + 12.5 cycles at 12 MHz
+
+static const ADC_CHANNEL channels[] = {
+    ADC_CH4_PA4, ADC_CH8_PB0, ADC_CH0_PA0, ADC_CH13_PC3,
+    ADC_CH1_PA1, ADC_CH9_PB1, ADC_CH15_PC5, ADC_CH2_PA2,   // SQ7, SQ8 in SQR2
+};
+#define COUNT (sizeof(channels) / sizeof(channels[0]))
+
+static uint16_t ring[2 * FRAMES * COUNT];
+static uint16_t last = 0xFFFF;
+static uint32_t samples;
+
+static void fail(const char *what, uint32_t got, uint32_t expected) {
+    printf("FAIL %s: got 0x%03x, expected 0x%03x (after %lu samples)\n", what,
+           (unsigned)got, (unsigned)expected, (unsigned long)samples);
+    exit(1);
+}
+
+static uint16_t source(uint8_t ch, uint64_t t_ns, void *ctx) {
+    (void)ctx;
+    return (uint16_t)((ch << 8) | ((t_ns / 1000) & 0xFF));
+}
+
+static void on_block(const uint16_t *block, uint16_t frames, void *arg) {
+    (void)arg;
+    if (frames != FRAMES) fail("frames", frames, FRAMES);
+    for (uint32_t i = 0; i < frames * COUNT; ++i) {
+        uint16_t v = block[i];
+        if ((v >> 8) != channels[i % COUNT]) fail("channel order", v >> 8, channels[i % COUNT]);
+        if (last != 0xFFFF && ((v - last) & 0xFF) != CONV_NS / 1000) {
+            fail("sample spacing", v & 0xFF, (last + CONV_NS / 1000) & 0xFF);
+        }
+        last = v & 0xFF;
+        ++samples;
+    }
+}
+
+// Fixed rate: frames of RATE_CHANNELS, PERIOD_US apart
+#define RATE_HZ         10000u
+#define PERIOD_US       (1000000u / RATE_HZ)
+static const ADC_CHANNEL rate_channels[] = { ADC_CH3_PA3, ADC_CH10_PC0, ADC_CH11_PC1 };
+#define RATE_CHANNELS (sizeof(rate_channels) / sizeof(rate_channels[0]))
+static uint32_t frames_seen;
+
+static void on_rate_block(const uint16_t *block, uint16_t frames, void *arg) {
+    (void)arg;
+    for (uint32_t f = 0; f < frames; ++f) {
+        const uint16_t *frame = block + f * RATE_CHANNELS;
+        for (uint32_t i = 0; i < RATE_CHANNELS; ++i) {
+            uint16_t v = frame[i];
+            if ((v >> 8) != rate_channels[i]) fail("rate channel order", v >> 8, rate_channels[i]);
+            // Conversions of a frame back to back, frames one period apart
+            uint16_t expected = i > 0 ? last + CONV_NS / 1000 : last + PERIOD_US - (RATE_CHANNELS - 1) * CONV_NS / 1000;
+            if (last != 0xFFFF && (v & 0xFF) != (expected & 0xFF)) fail("rate spacing", v & 0xFF, expected & 0xFF);
+            last = v & 0xFF;
+        }
+        ++frames_seen;
+    }
+}
+
+// Oversampling: the mean of these sources has a fraction of an LSB
+static const ADC_CHANNEL os_channels[] = { ADC_CH6_PA6, ADC_CH7_PA7, ADC_CH14_PC4 };
+static const uint8_t os_bits[] = { 2, 0, 4 };
+#define OS_CHANNELS (sizeof(os_channels) / sizeof(os_channels[0]))
+
+static uint16_t dither(uint8_t ch, uint64_t t_ns, void *ctx) {
+    (void)t_ns;
+    uint32_t n = (*(uint32_t *)ctx)++;
+    // 1000.25 (every fourth sample one higher) and 2000.1875 (3 of 16)
+    return ch == ADC_CH6_PA6 ? 1000 + (n % 4 == 0) : ch == ADC_CH7_PA7 ? 3000 : 2000 + (n % 16 < 3);
+}
+
+// Watch: a triangle of TRI_PERIOD_US from 0 to 4000 with +-40 counts of
+// alternating noise on PA3
+#define TRI_PERIOD_US   10000u
+static uint32_t tri_count;
+static uint64_t tri_last_ns;    // end of the latest conversion
+
+static uint16_t triangle(uint8_t ch, uint64_t t_ns, void *ctx) {
+    (void)ch;
+    (void)ctx;
+    tri_last_ns = t_ns;
+    uint32_t t = (uint32_t)(t_ns / 1000 % TRI_PERIOD_US);
+    int32_t v = (int32_t)(t < TRI_PERIOD_US / 2 ? t : TRI_PERIOD_US - t) * 8000 / TRI_PERIOD_US;
+    v += (tri_count++ & 1) ? 40 : -40;
+    return (uint16_t)(v < 0 ? 0 : v);
+}
+
+typedef struct {
+    uint32_t above, below;
+    int32_t late_ns;            // worst delay after the crossing conversion
+} watch_log_t;
+
+static void on_watch(adc_watch_t *w, ADC_WATCH_EVENT event, uint16_t value, void *arg) {
+    watch_log_t *log = arg;
+    if (event == ADC_WATCH_ABOVE) {
+        if (value <= w->high) fail("above value", value, w->high + 1);
+        ++log->above;
+    } else if (event == ADC_WATCH_BELOW) {
+        if (value >= w->low) fail("below value", value, w->low - 1);
+        ++log->below;
+    }
+    if (w->fast) {
+        // Taken as the conversion that crossed ends, before the next one
+        int32_t late = (int32_t)(sim_time_ns() - tri_last_ns);
+        if (late > log->late_ns) log->late_ns = late;
+    }
+}
+
+static adc_watch_t sw_watch;
+
+static void on_watch_block(const uint16_t *block, uint16_t frames, void *arg) {
+    (void)arg;
+    uint32_t sum = 0;
+    for (uint16_t f = 0; f < frames; ++f) sum += block[f];
+    adc_watch_feed(ADC_CH3_PA3, (uint16_t)(sum / frames));
+}
+
+// Injected: two short conversions into a fixed-rate regular scan
+#define INJ_RATE_HZ     1000u
+#define INJ_CONV_NS     3417u       // 28.5 + 12.5 cycles
+static const ADC_CHANNEL inj_channels[] = { ADC_CH12_PC2, ADC_CH5_PA5 };
+#define INJ_CHANNELS (sizeof(inj_channels) / sizeof(inj_channels[0]))
+
+typedef struct {
+    uint32_t groups;
+    uint64_t last_us;
+    uint32_t max_late_us;       // timestamp after the last conversion
+    uint32_t min_gap_us, max_gap_us;
+} inj_log_t;
+
+static void on_injected(const uint16_t *values, uint8_t count, uint64_t timestamp_us, void *arg) {
+    inj_log_t *log = arg;
+    if (count != INJ_CHANNELS) fail("injected count", count, INJ_CHANNELS);
+    for (uint8_t i = 0; i < count; ++i) {
+        if ((values[i] >> 8) != inj_channels[i]) fail("injected order", values[i] >> 8, inj_channels[i]);
+    }
+    uint32_t late = (uint32_t)((timestamp_us - values[count - 1]) & 0xFF);
+    if (late > log->max_late_us) log->max_late_us = late;
+    if (log->groups > 0) {
+        uint32_t gap = (uint32_t)(timestamp_us - log->last_us);
+        if (gap < log->min_gap_us) log->min_gap_us = gap;
+        if (gap > log->max_gap_us) log->max_gap_us = gap;
+    }
+    log->last_us = timestamp_us;
+    ++log->groups;
+}
+
+static void on_preempted_block(const uint16_t *block, uint16_t frames, void *arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < frames * RATE_CHANNELS; ++i) {
+        if ((block[i] >> 8) != rate_channels[i % RATE_CHANNELS]) {
+            fail("preempted order", block[i] >> 8, rate_channels[i % RATE_CHANNELS]);
+        }
+    }
+    frames_seen += frames;
+}
+
+static void check_latest(void) {
+    uint32_t now_us = (uint32_t)(sim_time_ns() / 1000);
+    for (uint8_t i = 0; i < COUNT; ++i) {
+        uint16_t v = adc_scan_latest(i);
+        uint32_t age = (now_us - v) & 0xFF;
+        if ((v >> 8) != channels[i]) fail("latest channel", v >> 8, channels[i]);
+        if (age > 2 * COUNT * CONV_NS / 1000) fail("latest age", age, 2 * COUNT * CONV_NS / 1000);
+    }
+}
+
+int main(void) {
+    sim_init();
+    delay_init();
+    for (uint8_t ch = 0; ch < 16; ++ch) sim_adc_set_source(ch, source, NULL);
+
+    adc_scan_config_t config = {
+        .channels = channels,
+        .count = COUNT,
+        .sample_time = ADC_SMP_239_5,
+        .buffer = ring,
+        .frames = FRAMES,
+        .on_block = on_block,
+    };
+    if (adc_scan_start(&config) != 0) fail("start", 1, 0);
+
+    // One second of blocks, polled at odd intervals in between
+    uint32_t polls = 0;
+    while (sim_time_ns() < 1000000000ull) {
+        sim_advance_ns(3700 + (polls * 7919) % 50000);
+        check_latest();
+        ++polls;
+    }
+    uint32_t expected = (uint32_t)(sim_time_ns() / ((uint64_t)FRAMES * COUNT * CONV_NS));
+    if (adc_scan_blocks() + 1 < expected || adc_scan_blocks() > expected) {
+        fail("block count", adc_scan_blocks(), expected);
+    }
+    if (adc_scan_overruns() != 0) fail("overruns", adc_scan_overruns(), 0);
+    printf("scan: %lu blocks, %lu samples, %lu polls ok\n", (unsigned long)adc_scan_blocks(),
+           (unsigned long)samples, (unsigned long)polls);
+
+    // Hold the interrupt off across two half boundaries: both flags pend
+    NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    sim_advance_ns(5ull * FRAMES * COUNT * CONV_NS / 2);
+    last = 0xFFFF;
+    NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    sim_advance_ns(1000);
+    if (adc_scan_overruns() == 0) fail("overrun not counted", 0, 1);
+    printf("masked: %lu overruns\n", (unsigned long)adc_scan_overruns());
+
+    // adc_get_single() reads the ring while scanning...
+    uint16_t v = adc_get_single(ADC_CH13_PC3);
+    if (v != adc_scan_get(ADC_CH13_PC3)) fail("single while scanning", v, adc_scan_get(ADC_CH13_PC3));
+    if (adc_get_single(ADC_CH5_PA5) != 0) fail("unscanned channel", adc_get_single(ADC_CH5_PA5), 0);
+
+    // ...and converts again once the scan is stopped
+    adc_scan_stop();
+    adc_init(ADC_CH5_PA5);
+    uint64_t start = sim_time_ns();
+    v = adc_get_single(ADC_CH5_PA5);
+    uint32_t took = (uint32_t)(sim_time_ns() - start);
+    if ((v >> 8) != ADC_CH5_PA5 || took < CONV_NS || took > CONV_NS + 1000) {
+        fail("single after stop", v, (ADC_CH5_PA5 << 8));
+    }
+    printf("single: 0x%03x in %lu ns\n", v, (unsigned long)took);
+
+    // A frame of 8 x 21 us does not fit in 100 us
+    config.sample_rate_hz = RATE_HZ;
+    if (adc_scan_start(&config) != 2) fail("too fast accepted", 0, 2);
+
+    adc_scan_config_t rate = {
+        .channels = rate_channels,
+        .count = RATE_CHANNELS,
+        .sample_time = ADC_SMP_239_5,
+        .buffer = ring,
+        .frames = FRAMES,
+        .on_block = on_rate_block,
+        .sample_rate_hz = RATE_HZ,
+    };
+    last = 0xFFFF;
+    if (adc_scan_start(&rate) != 0) fail("rate start", 1, 0);
+    if (adc_scan_period() != 72000000u / RATE_HZ) fail("period", adc_scan_period(), 72000000u / RATE_HZ);
+    start = sim_time_ns();
+    // Half the time in WFI, half polling
+    while (sim_time_ns() - start < 500000000ull) __WFI();
+    while (sim_time_ns() - start < 1000000000ull) sim_advance_ns(3700);
+    uint32_t expected_frames = (uint32_t)((sim_time_ns() - start) / (PERIOD_US * 1000ull));
+    if (frames_seen + 2 * FRAMES < expected_frames || frames_seen > expected_frames + 1) {
+        fail("rate frames", frames_seen, expected_frames);
+    }
+    if (adc_scan_overruns() != 0) fail("rate overruns", adc_scan_overruns(), 0);
+    printf("rate: %lu frames at %lu Hz\n", (unsigned long)frames_seen, (unsigned long)RATE_HZ);
+    adc_scan_stop();
+
+    static uint32_t counters[OS_CHANNELS];
+    for (uint8_t i = 0; i < OS_CHANNELS; ++i) sim_adc_set_source(os_channels[i], dither, &counters[i]);
+    static const uint8_t too_many[] = { 0, 0, ADC_SCAN_MAX_OVERSAMPLE + 1 };
+    adc_scan_config_t os = {
+        .channels = os_channels,
+        .count = OS_CHANNELS,
+        .sample_time = ADC_SMP_239_5,
+        .buffer = ring,
+        .frames = FRAMES,
+        .sample_rate_hz = RATE_HZ,
+        .oversample = too_many,
+    };
+    if (adc_scan_start(&os) != 1) fail("oversample limit", 0, 1);
+    os.oversample = os_bits;
+    if (adc_scan_start(&os) != 0) fail("oversample start", 1, 0);
+    start = sim_time_ns();
+    while (sim_time_ns() - start < 100000000ull) __WFI();
+    if (adc_scan_oversampled(0) != 4001) fail("14-bit mean", adc_scan_oversampled(0), 4001);
+    if (adc_scan_oversampled(1) != 3000) fail("not oversampled", adc_scan_oversampled(1), 3000);
+    if (adc_scan_oversampled(2) != 32003) fail("16-bit mean", adc_scan_oversampled(2), 32003);
+    printf("oversample: %u (14 bit), %u (16 bit)\n", adc_scan_oversampled(0), adc_scan_oversampled(2));
+    adc_scan_stop();
+
+    // Fast watch on every conversion, software watch on the block means
+    static const ADC_CHANNEL watch_channels[] = { ADC_CH3_PA3 };
+    sim_adc_set_source(ADC_CH3_PA3, triangle, NULL);
+    static watch_log_t hw_log, sw_log;
+    adc_watch_t hw_watch = {
+        .channel = ADC_CH3_PA3, .low = 1000, .high = 3000, .fast = 1,
+        .fn = on_watch, .arg = &hw_log,
+    };
+    sw_watch = (adc_watch_t){
+        .channel = ADC_CH3_PA3, .low = 1500, .high = 2500,
+        .fn = on_watch, .arg = &sw_log,
+    };
+    adc_scan_config_t watched = {
+        .channels = watch_channels,
+        .count = 1,
+        .sample_time = ADC_SMP_239_5,
+        .buffer = ring,
+        .frames = FRAMES,
+        .on_block = on_watch_block,
+        .sample_rate_hz = 20000,
+    };
+    if (adc_scan_start(&watched) != 0) fail("watch start", 1, 0);
+    if (adc_watch_add(&hw_watch) != 0 || adc_watch_add(&sw_watch) != 0) fail("watch add", 1, 0);
+    adc_watch_t second = hw_watch;
+    if (adc_watch_add(&second) != 2) fail("second fast watch", 0, 2);
+    // Whole periods, starting from the bottom of the triangle
+    sim_advance_ns(TRI_PERIOD_US * 1000ull - sim_time_ns() % (TRI_PERIOD_US * 1000ull));
+    hw_log = sw_log = (watch_log_t){ 0 };
+    start = sim_time_ns();
+    while (sim_time_ns() - start < 100ull * TRI_PERIOD_US * 1000) __WFI();
+    if (hw_log.above != 100 || hw_log.below != 100) fail("fast events", hw_log.above + hw_log.below, 200);
+    if (hw_log.late_ns != 0) fail("fast latency", hw_log.late_ns, 0);
+    if (sw_log.above != 100 || sw_log.below != 100) fail("fed events", sw_log.above + sw_log.below, 200);
+    printf("watch: %lu/%lu fast, %lu/%lu fed events, %lu total\n", (unsigned long)hw_log.above,
+           (unsigned long)hw_log.below, (unsigned long)sw_log.above, (unsigned long)sw_log.below,
+           (unsigned long)adc_watch_events());
+    adc_watch_remove(&hw_watch);
+    adc_watch_remove(&sw_watch);
+    adc_scan_stop();
+
+    // Injected groups on TIM2 into the 10 kHz scan
+    for (uint8_t ch = 0; ch < 16; ++ch) sim_adc_set_source(ch, source, NULL);
+    rate.on_block = on_preempted_block;
+    frames_seen = 0;
+    if (adc_scan_start(&rate) != 0) fail("scan under injected", 1, 0);
+    static inj_log_t timed_log = { .min_gap_us = 0xFFFFFFFF };
+    adc_injected_config_t inj = {
+        .channels = inj_channels,
+        .count = INJ_CHANNELS,
+        .sample_time = ADC_SMP_28_5,
+        .rate_hz = INJ_RATE_HZ,
+        .fn = on_injected,
+        .arg = &timed_log,
+    };
+    if (adc_injected_start(&inj) != 0) fail("injected start", 1, 0);
+    if (adc_injected_trigger() != 1) fail("trigger with a rate", 0, 1);
+    start = sim_time_ns();
+    while (sim_time_ns() - start < 100000000ull) __WFI();
+    expected_frames = (uint32_t)((sim_time_ns() - start) / (PERIOD_US * 1000ull));
+    if (frames_seen + 2 * FRAMES < expected_frames || frames_seen > expected_frames + 1) {
+        fail("preempted frames", frames_seen, expected_frames);
+    }
+    if (adc_scan_overruns() != 0) fail("preempted overruns", adc_scan_overruns(), 0);
+    if (timed_log.groups + 1 < 100 || timed_log.groups > 100) fail("injected groups", timed_log.groups, 100);
+    uint32_t period_us = 1000000u / INJ_RATE_HZ;
+    if (timed_log.min_gap_us + 1 < period_us || timed_log.max_gap_us > period_us + 1) {
+        fail("injected period", timed_log.max_gap_us, period_us);
+    }
+    if (timed_log.max_late_us > 1) fail("injected timestamp", timed_log.max_late_us, 0);
+    printf("injected: %lu groups every %lu us, %lu scan frames\n", (unsigned long)timed_log.groups,
+           (unsigned long)period_us, (unsigned long)frames_seen);
+
+    // On demand, at odd moments of the scan
+    static inj_log_t demand_log = { .min_gap_us = 0xFFFFFFFF };
+    inj.rate_hz = 0;
+    inj.arg = &demand_log;
+    if (adc_injected_start(&inj) != 0) fail("on-demand start", 1, 0);
+    uint32_t max_wait_ns = 0;
+    for (uint32_t i = 0; i < 50; ++i) {
+        sim_advance_ns(1000 + (i * 7919) % 300000);
+        uint32_t before = demand_log.groups;
+        uint64_t t = sim_time_ns();
+        if (adc_injected_trigger() != 0) fail("trigger", 1, 0);
+        if (adc_injected_trigger() != 2) fail("trigger while converting", 0, 2);
+        while (demand_log.groups == before) __WFI();
+        uint32_t wait = (uint32_t)(sim_time_ns() - t);
+        if (wait > max_wait_ns) max_wait_ns = wait;
+    }
+    if (max_wait_ns > INJ_CHANNELS * INJ_CONV_NS + 1000) fail("on-demand wait", max_wait_ns, INJ_CHANNELS * INJ_CONV_NS);
+    if (demand_log.max_late_us > 1) fail("on-demand timestamp", demand_log.max_late_us, 0);
+    if (adc_scan_overruns() != 0) fail("on-demand overruns", adc_scan_overruns(), 0);
+    printf("on demand: %lu groups, %lu ns at most\n", (unsigned long)demand_log.groups, (unsigned long)max_wait_ns);
+    adc_injected_stop();
+    adc_scan_stop();
+
+    printf("ok\n");
+    return 0;
+}
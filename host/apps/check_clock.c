@@ -0,0 +1,95 @@
+/*
+ * Checks delay_get_us() against the virtual clock. The 16-bit TIM6 counter
+ * wraps every 65.536 ms, so a few virtual hours give tens of thousands of
+ * wraps; reads are placed at random points, right on the wrap edges from
+ * interrupt context (TIM5 callbacks are serviced before the TIM6 update
+ * interrupt), and with the TIM6 interrupt masked across a wrap. The run
+ * crosses 2^32 us to catch 32-bit truncation.
+ *
+ * Usage: check_clock [virtual minutes]
+ * Exits with 1 on the first mismatch.
+ */
+#include "sim.h"
+#include "delay/delay.h"
+#include "delay/utimer.h"
+#include <stdlib.h>
+
+#define WRAP_US 65536u
+
+static uint64_t reads;
+static uint64_t last;
+
+static uint32_t rng_state = 12345;
+static uint32_t rng(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static void check(const char *where) {
+    uint64_t us = delay_get_us();
+    uint64_t expected = sim_time_ns() / 1000;
+    ++reads;
+    if (us != expected || us < last) {
+        printf("FAIL %s: delay_get_us() %llu, expected %llu, previous %llu\n", where,
+               (unsigned long long)us, (unsigned long long)expected,
+               (unsigned long long)last);
+        exit(1);
+    }
+    last = us;
+}
+
+// Reads from the TIM5 interrupt at wrap + offset, offset -2 .. 2 us
+static utimer_t edge_timer;
+static uint64_t next_wrap;
+static int32_t edge_offset;
+
+static void edge_fn(void *arg) {
+    (void)arg;
+    check("edge");
+    if (++edge_offset > 2) {
+        edge_offset = -2;
+        next_wrap += WRAP_US * (1 + rng() % 4);
+    }
+    utimer_start_at(&edge_timer, (uint32_t)(next_wrap + edge_offset), edge_fn, NULL);
+}
+
+int main(int argc, char **argv) {
+    uint64_t run_ns = (uint64_t)(argc > 1 ? atoi(argv[1]) : 75) * 60 * 1000000000ull;
+
+    sim_init();
+    delay_init();
+    utimer_init();
+
+    next_wrap = WRAP_US;
+    edge_offset = -2;
+    utimer_start_at(&edge_timer, (uint32_t)(next_wrap + edge_offset), edge_fn, NULL);
+
+    uint32_t masked = 0;
+    while (sim_time_ns() < run_ns) {
+        // Random steps, mostly short, now and then most of a wrap
+        uint32_t step = rng() % 8 == 0 ? rng() % 60000000 : rng() % 20000;
+        sim_advance_ns(step);
+        check("random");
+
+        // Mask the TIM6 interrupt for up to 50 ms around a wrap
+        if (rng() % 64 == 0) {
+            uint32_t to_wrap = WRAP_US - (uint32_t)(delay_get_us() % WRAP_US);
+            if (to_wrap < 20000) {
+                NVIC_DisableIRQ(TIM6_IRQn);
+                uint64_t end = sim_time_ns() + 50000000;
+                while (sim_time_ns() < end) {
+                    sim_advance_us(1000 + rng() % 3000);
+                    check("masked");
+                }
+                NVIC_EnableIRQ(TIM6_IRQn);
+                check("unmasked");
+                ++masked;
+            }
+        }
+    }
+
+    printf("ok: %llu reads over %llu wraps (%u with the interrupt masked), last %llu us\n",
+           (unsigned long long)reads, (unsigned long long)(last / WRAP_US), masked,
+           (unsigned long long)last);
+    return 0;
+}
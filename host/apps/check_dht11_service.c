@@ -0,0 +1,107 @@
+/*
+ * Checks the minimum interval of the DHT11 service on the simulated sensor,
+ * with a 5 s period. Every read start is watched at 1 ms resolution:
+ * - a request 50 ms before a periodic deadline starts a read at once, and the
+ *   periodic read waits DHT11_MIN_INTERVAL_MS after it instead of starting
+ *   50 ms later; the period then continues from that read;
+ * - a request less than DHT11_MIN_INTERVAL_MS after a read is refused;
+ * - restarting the service right after a read began delays its first read
+ *   to the end of the interval;
+ * - no two reads ever start less than DHT11_MIN_INTERVAL_MS apart, and the
+ *   readings keep arriving.
+ *
+ * Usage: check_dht11_service
+ * Exits with 1 on the first mismatch.
+ */
+#include "sim.h"
+#include "stm32f10x.h"
+#include "delay/delay.h"
+#include "delay/utimer.h"
+#include "dht11/dht11_service.h"
+#include <stdlib.h>
+
+#define PERIOD_MS   5000
+#define MIN_US      ( DHT11_MIN_INTERVAL_MS * 1000ULL )
+
+static dht11_service_t svc;
+static uint64_t last_seen;
+static uint32_t starts;
+static uint64_t closest = UINT64_MAX;
+
+static void fail(const char *what) {
+    printf("FAIL %s at %llu us\n", what, (unsigned long long)(sim_time_ns() / 1000));
+    exit(1);
+}
+
+// Advance `ms`, noting every read start
+static void run_ms(uint32_t ms) {
+    for ( uint32_t i = 0; i < ms; i++ ) {
+        sim_advance_ms(1);
+        if ( !svc.has_started || svc.last_start_us == last_seen ) continue;
+        if ( starts > 0 ) {
+            uint64_t gap = svc.last_start_us - last_seen;
+            if ( gap < MIN_US ) fail("two reads within the minimum interval");
+            if ( gap < closest ) closest = gap;
+        }
+        last_seen = svc.last_start_us;
+        starts++;
+    }
+}
+
+// Advance until the periodic timer is `before_ms` from its deadline
+static void run_until_due(uint32_t before_ms) {
+    while ( (int32_t)( svc.timer.due - utimer_now() ) > (int32_t)( before_ms * 1000 ) ) run_ms(1);
+}
+
+int main(void) {
+    sim_init();
+    delay_init();
+    utimer_init();
+    if ( dht11_sensor_init(&dht11_board) != 0 ) fail("sensor init");
+    dht11_service_start(&svc, &dht11_board, PERIOD_MS);
+    run_ms(PERIOD_MS + 100);
+    if ( starts != 2 ) fail("periodic reads");
+
+    // Request just before a periodic deadline
+    run_until_due(50);
+    uint32_t before = starts;
+    if ( dht11_service_request(&svc) != 0 ) fail("request refused");
+    run_ms(1);
+    if ( starts != before + 1 ) fail("request did not start a read");
+    uint64_t requested = svc.last_start_us;
+    run_ms(DHT11_MIN_INTERVAL_MS + 100);
+    if ( starts != before + 2 ) fail("periodic read not deferred");
+    uint64_t deferred = svc.last_start_us - requested;
+    if ( deferred > MIN_US + 2000 ) fail("periodic read deferred too long");
+    uint64_t rephased = svc.last_start_us;
+    run_ms(PERIOD_MS);
+    if ( svc.last_start_us - rephased < PERIOD_MS * 1000ULL - 2000 ||
+         svc.last_start_us - rephased > PERIOD_MS * 1000ULL + 2000 ) {
+        fail("period not continued from the deferred read");
+    }
+
+    // Too soon after a read
+    run_ms(100);
+    if ( dht11_service_request(&svc) != 1 ) fail("request within the interval accepted");
+
+    // Restart right after a read began
+    uint32_t n = starts;
+    while ( starts == n ) run_ms(1);
+    run_ms(50);
+    uint64_t last = svc.last_start_us;
+    dht11_service_stop(&svc);
+    dht11_service_start(&svc, &dht11_board, PERIOD_MS);
+    run_ms(DHT11_MIN_INTERVAL_MS + 100);
+    if ( svc.last_start_us - last < MIN_US ) fail("restart read too soon");
+    if ( svc.last_start_us == last ) fail("restart did not read");
+
+    run_ms(3 * PERIOD_MS);
+    dht11_sample_t sample;
+    dht11_service_get(&svc, &sample);
+    if ( !( sample.flags & DHT11_SAMPLE_VALID ) || sample.reads + 1 < starts ) fail("readings");
+
+    printf("%u reads started, closest %llu ms apart (periodic read deferred %llu ms after a request)\n",
+           starts, (unsigned long long)( closest / 1000 ), (unsigned long long)( deferred / 1000 ));
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Checks the widget update slots. A TIM5 interrupt (utimer) posts a ramp to
+ * a bar at 1 kHz and to a label at 250 Hz while the main loop applies the
+ * slots and runs LVGL every 30 ms:
+ * - every apply shows the latest value posted to its slot, and the widget
+ *   ends with the last value posted;
+ * - a slot is applied at most once per gui_process(), whatever the number
+ *   of posts, and the stats count the coalesced posts;
+ * - slots are applied in the order they first became pending;
+ * - a slot posted to before gui_slot_init() shows its latest value once
+ *   initialised.
+ *
+ * Usage: check_gui
+ * Exits with 1 on the first mismatch.
+ */
+#include "sim.h"
+#include "stm32f10x.h"
+#include "delay/delay.h"
+#include "delay/utimer.h"
+#include "gui/gui.h"
+#include "lv_port_disp.h"
+#include <stdlib.h>
+
+enum { BAR, LABEL, LED, SLOTS };
+
+static gui_slot_t slots[SLOTS];
+static volatile int32_t posted[SLOTS];
+static uint32_t applies[SLOTS];
+static char order[8];
+static uint8_t order_len;
+
+static utimer_t ramp_timer;
+static uint32_t ramp_due;
+static int32_t ramp;
+
+static void fail(const char *what)
+{
+    printf("FAIL %s at %u ms\n", what, delay_get_tick());
+    exit(1);
+}
+
+static void post(int slot, int32_t value)
+{
+    posted[slot] = value;
+    gui_post(&slots[slot], value);
+}
+
+// Appliers: check the value, then update the widget like the stock ones
+static void apply(lv_obj_t *obj, int32_t value, void *arg)
+{
+    int slot = (int)(intptr_t)arg;
+    if(value != posted[slot]) fail("applied value is not the latest posted");
+    applies[slot]++;
+    if(order_len < sizeof(order)) order[order_len++] = (char)('0' + slot);
+    if(slot == BAR) gui_apply_bar(obj, value, NULL);
+    if(slot == LABEL) gui_apply_label(obj, value, "%d");
+}
+
+// TIM5 interrupt: the "sensor"
+static void ramp_tick(void *arg)
+{
+    (void)arg;
+    ramp++;
+    post(BAR, ramp % 1000);
+    if(ramp % 4 == 0) post(LABEL, ramp);
+    ramp_due += 1000;
+    utimer_start_at(&ramp_timer, ramp_due, ramp_tick, NULL);
+}
+
+int main(void)
+{
+    sim_init();
+    delay_init();
+    utimer_init();
+    lv_init();
+    lv_port_disp_init();
+
+    lv_obj_t *bar = lv_bar_create(lv_scr_act());
+    lv_bar_set_range(bar, 0, 999);
+    lv_obj_t *label = lv_label_create(lv_scr_act());
+    lv_obj_t *led = lv_led_create(lv_scr_act());
+
+    // Posted to before it is initialised
+    post(LED, 7);
+    post(LED, 8);
+    gui_slot_init(&slots[BAR], bar, apply, (void *)BAR);
+    gui_slot_init(&slots[LABEL], label, apply, (void *)LABEL);
+    gui_slot_init(&slots[LED], led, apply, (void *)LED);
+    if(gui_process() != 1 || applies[LED] != 1) fail("slot posted before init");
+
+    // Order of first post, not of the latest
+    order_len = 0;
+    post(LABEL, 1);
+    post(LED, 2);
+    post(BAR, 3);
+    post(LABEL, 4);
+    if(gui_process() != 3 || order_len != 3 || order[0] != '1' || order[1] != '2' || order[2] != '0') {
+        fail("apply order");
+    }
+
+    // 10 s of the sensor against a 30 ms GUI loop
+    gui_stats_t before, after;
+    gui_get_stats(&before);
+    uint32_t bar_applies = applies[BAR], label_applies = applies[LABEL];
+    ramp_due = utimer_now() + 1000;
+    utimer_start_at(&ramp_timer, ramp_due, ramp_tick, NULL);
+    uint32_t passes = 0;
+    uint32_t end = delay_get_tick() + 10000;
+    while((int32_t)(end - delay_get_tick()) > 0) {
+        uint32_t n = gui_process();
+        if(n > SLOTS) fail("slot applied twice in one pass");
+        lv_timer_handler();
+        passes++;
+        // Posts wake the loop; it keeps its 30 ms period anyway
+        uint32_t next = delay_get_tick() + 30;
+        while((int32_t)(next - delay_get_tick()) > 0) delay_idle(next - delay_get_tick());
+    }
+    utimer_cancel(&ramp_timer);
+    gui_process();
+    gui_get_stats(&after);
+
+    uint32_t posts = after.posts - before.posts;
+    uint32_t applied = after.applied - before.applied;
+    bar_applies = applies[BAR] - bar_applies;
+    label_applies = applies[LABEL] - label_applies;
+    if(posts < 10000 + 2500 - 10 || applied != bar_applies + label_applies) fail("stats");
+    if(bar_applies > passes + 1 || label_applies > passes + 1) fail("more applies than GUI passes");
+    if(lv_bar_get_value(bar) != posted[BAR]) fail("bar does not show the last value");
+    if(atoi(lv_label_get_text(label)) != posted[LABEL]) fail("label does not show the last value");
+
+    printf("%u posts in 10 s, %u applied in %u GUI passes\n", posts, applied, passes);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Checks the LVGL keypad input device fed by key events. Three buttons are
+ * created in the default group; key 1 (PC1, LV_KEY_NEXT) is pressed with a
+ * bouncing contact while the LVGL loop runs:
+ * - a short press moves the focus once, its release does not;
+ * - a held key moves it once on the press and once per REPEAT event, at the
+ *   key driver's times;
+ * - LVGL reads the keypad once per key event and never otherwise: minutes of
+ *   idle loop with no key add no read.
+ *
+ * Usage: check_indev
+ * Exits with 1 on the first mismatch.
+ */
+#include "sim.h"
+#include "stm32f10x.h"
+#include "delay/delay.h"
+#include "key/key.h"
+#include "lv_port_disp.h"
+#include "lv_port_indev.h"
+#include <stdlib.h>
+
+extern lv_indev_t * indev_keypad;
+
+static lv_obj_t * buttons[3];
+static void (*keypad_read)(lv_indev_drv_t *, lv_indev_data_t *);
+static uint32_t reads;
+
+static void counted_read(lv_indev_drv_t * drv, lv_indev_data_t * data)
+{
+    reads++;
+    keypad_read(drv, data);
+}
+
+static void fail(const char * what)
+{
+    printf("FAIL %s at %u ms\n", what, delay_get_tick());
+    exit(1);
+}
+
+// The sample 07 loop in short: input, then LVGL's timers, for `ms`
+static uint32_t run(uint32_t ms)
+{
+    uint32_t events = 0;
+    uint32_t end = delay_get_tick() + ms;
+    while((int32_t)(end - delay_get_tick()) > 0) {
+        if(lv_port_indev_process()) events++;
+        lv_timer_handler();
+        delay_idle(5);
+    }
+    return events;
+}
+
+static int focused(void)
+{
+    lv_obj_t * obj = lv_group_get_focused(lv_port_indev_group());
+    for(int i = 0; i < 3; i++) {
+        if(obj == buttons[i]) return i;
+    }
+    return -1;
+}
+
+static void key1(bool pressed)
+{
+    for(int i = 0; i < 3; i++) {
+        sim_gpio_set_external('C', 1, !pressed);
+        sim_advance_us(400);
+        sim_gpio_set_external('C', 1, pressed);
+        sim_advance_us(400);
+    }
+    sim_gpio_set_external('C', 1, !pressed);
+}
+
+int main(void)
+{
+    sim_init();
+    delay_init();
+    lv_init();
+    lv_port_disp_init();
+    lv_port_indev_init();
+    keypad_read = indev_keypad->driver->read_cb;
+    indev_keypad->driver->read_cb = counted_read;
+
+    for(int i = 0; i < 3; i++) {
+        buttons[i] = lv_btn_create(lv_scr_act());
+        lv_obj_align(buttons[i], LV_ALIGN_TOP_LEFT, 10, 10 + 50 * i);
+    }
+    run(100);
+    if(focused() != 0 || reads != 0) fail("initial focus");
+
+    // Short press: NEXT on press only
+    key1(true);
+    run(100);
+    if(focused() != 1) fail("press did not move the focus");
+    key1(false);
+    run(100);
+    if(focused() != 1 || reads != 2) fail("release");
+
+    // Held for 1 s: press, LONG, REPEAT at 750 and 900 ms
+    key1(true);
+    run(1000);
+    key1(false);
+    run(100);
+    uint32_t repeats = (1000 - KEY_LONG_MS) / KEY_REPEAT_MS;
+    if(focused() != (int)((2 + repeats) % 3)) fail("hold");
+    if(reads != 2 + 3 + repeats) fail("reads per key event");
+
+    // Idle: the LVGL loop runs, the keypad is not read
+    uint32_t before = reads;
+    run(5 * 60 * 1000);
+    if(reads != before) fail("keypad read while idle");
+
+    printf("%u keypad reads, one per key event, none in 5 idle minutes\n", reads);
+    printf("ok\n");
+    return 0;
+}
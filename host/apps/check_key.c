@@ -0,0 +1,195 @@
+/*
+ * Checks the key driver with bouncing contacts driven on the pins. Three keys:
+ * the board key PC1 (EXTI1, handled by key.c), PA0 (EXTI0) and PB13 (EXTI15_10),
+ * whose handlers here hand the lines to key_exti_irq().
+ * - a press or release that bounces for a few ms gives one event,
+ *   KEY_DEBOUNCE_MS after its first edge;
+ * - a glitch shorter than the debounce time gives none;
+ * - a held key gives LONG after KEY_LONG_MS and REPEAT every KEY_REPEAT_MS,
+ *   and a bounce in the middle of a hold does not move that schedule;
+ * - events of several keys come out in time order; a full ring drops the
+ *   newest and counts them;
+ * - a key held at key_init() reports PRESS;
+ * - an idle keypad does not wake the core: sleeping for 10 s wakes it only
+ *   for the TIM5 overflow interrupts.
+ *
+ * Usage: check_key
+ * Exits with 1 on the first mismatch.
+ */
+#include "sim.h"
+#include "stm32f10x.h"
+#include "key/key.h"
+#include "delay/utimer.h"
+#include <stdlib.h>
+
+static const gpio_pin_t pins[] = {
+    GPIO_PIN_INIT('C', 1), GPIO_PIN_INIT('A', 0), GPIO_PIN_INIT('B', 13),
+};
+
+static uint32_t notified;
+
+void EXTI0_IRQHandler(void) {
+    key_exti_irq();
+}
+
+void EXTI15_10_IRQHandler(void) {
+    key_exti_irq();
+}
+
+static void on_key(void *arg) {
+    (void)arg;
+    notified++;
+}
+
+static void fail(const char *what) {
+    printf("FAIL %s at %llu us\n", what, (unsigned long long)(sim_time_ns() / 1000));
+    exit(1);
+}
+
+// Contact of key `k` closing (pressed) or opening, with `bounces` short
+// chatters of 300 us before it settles. Returns utimer_now() of the first edge.
+static uint32_t contact(uint8_t k, bool pressed, uint8_t bounces) {
+    char bank = (char)('A' + pins[k].port);
+    uint32_t first = utimer_now();
+    for ( uint8_t i = 0; i < bounces; i++ ) {
+        sim_gpio_set_external(bank, pins[k].pin, !pressed);
+        sim_advance_us(300);
+        sim_gpio_set_external(bank, pins[k].pin, pressed);
+        sim_advance_us(300);
+    }
+    sim_gpio_set_external(bank, pins[k].pin, !pressed);
+    return first;
+}
+
+// The next event must be `type` of key `k`, `after_ms` after `from`
+static void expect(uint8_t k, KEY_EVENT type, uint32_t from, uint32_t after_ms) {
+    key_event_t ev;
+    if ( !key_get(&ev) ) fail("missing event");
+    if ( ev.key != k || ev.type != type ) {
+        printf("FAIL key %u event %u, expected key %u event %u\n", ev.key, ev.type, k, type);
+        exit(1);
+    }
+    int32_t late = (int32_t)( ev.time_us - from - after_ms * 1000u );
+    if ( late < 0 || late > 50 ) {
+        printf("FAIL key %u event %u %ld us off its time\n", k, type, (long)late);
+        exit(1);
+    }
+}
+
+static void expect_none(void) {
+    key_event_t ev;
+    if ( key_get(&ev) ) {
+        printf("FAIL unexpected event %u of key %u\n", ev.type, ev.key);
+        exit(1);
+    }
+}
+
+int main(void) {
+    sim_init();
+
+    // Key 2 is held while the driver starts
+    sim_gpio_set_external('B', 13, 0);
+    utimer_init();
+    uint32_t t = utimer_now();
+    if ( key_init(pins, 3) != 0 ) fail("key_init");
+    key_set_notify(on_key, NULL);
+    sim_advance_ms(30);
+    expect(2, KEY_EVENT_PRESS, t, KEY_DEBOUNCE_MS);
+    expect_none();
+    t = contact(2, false, 0);
+    sim_advance_ms(30);
+    expect(2, KEY_EVENT_RELEASE, t, KEY_DEBOUNCE_MS);
+
+    // Bouncing press and release: one event each
+    t = contact(0, true, 5);
+    sim_advance_ms(100);
+    expect(0, KEY_EVENT_PRESS, t, KEY_DEBOUNCE_MS);
+    expect_none();
+    if ( !key_pressed(0) || key_pressed(1) ) fail("key_pressed");
+    t = contact(0, false, 8);
+    sim_advance_ms(100);
+    expect(0, KEY_EVENT_RELEASE, t, KEY_DEBOUNCE_MS);
+    expect_none();
+
+    // A 5 ms glitch is no press
+    contact(1, true, 0);
+    sim_advance_ms(5);
+    contact(1, false, 0);
+    sim_advance_ms(100);
+    expect_none();
+
+    // Hold 1 s, with a 2 ms bounce half-way
+    t = contact(0, true, 3);
+    sim_advance_ms(700);
+    contact(0, false, 0);
+    sim_advance_ms(2);
+    contact(0, true, 0);
+    sim_advance_ms(300);
+    uint32_t held = utimer_now() - t;
+    t += KEY_DEBOUNCE_MS * 1000u;
+    expect(0, KEY_EVENT_PRESS, t, 0);
+    expect(0, KEY_EVENT_LONG, t, KEY_LONG_MS);
+    uint32_t repeats = 0;
+    for ( uint32_t at = KEY_LONG_MS + KEY_REPEAT_MS; at * 1000u + KEY_DEBOUNCE_MS * 1000u <= held;
+          at += KEY_REPEAT_MS ) {
+        expect(0, KEY_EVENT_REPEAT, t, at);
+        repeats++;
+    }
+    expect_none();
+    t = contact(0, false, 2);
+    sim_advance_ms(50);
+    expect(0, KEY_EVENT_RELEASE, t, KEY_DEBOUNCE_MS);
+
+    // Overlapping presses of two keys come out in time order
+    uint32_t t1 = contact(1, true, 2);
+    sim_advance_ms(10);
+    uint32_t t2 = contact(2, true, 1);
+    sim_advance_ms(15);
+    uint32_t t3 = contact(1, false, 0);
+    sim_advance_ms(50);
+    uint32_t t4 = contact(2, false, 0);
+    sim_advance_ms(50);
+    expect(1, KEY_EVENT_PRESS, t1, KEY_DEBOUNCE_MS);
+    expect(2, KEY_EVENT_PRESS, t2, KEY_DEBOUNCE_MS);
+    expect(1, KEY_EVENT_RELEASE, t3, KEY_DEBOUNCE_MS);
+    expect(2, KEY_EVENT_RELEASE, t4, KEY_DEBOUNCE_MS);
+    expect_none();
+
+    // Nobody reads: the ring keeps the oldest KEY_QUEUE_LEN events
+    uint32_t first = 0;
+    for ( uint8_t i = 0; i < KEY_QUEUE_LEN; i++ ) {
+        uint32_t at = contact(1, i % 2 == 0, 0);
+        if ( i == 0 ) first = at;
+        sim_advance_ms(50);
+    }
+    contact(1, true, 0);
+    sim_advance_ms(50);
+    contact(1, false, 0);
+    sim_advance_ms(50);
+    if ( key_dropped() != 2 ) fail("dropped events not counted");
+    for ( uint8_t i = 0; i < KEY_QUEUE_LEN; i++ ) {
+        expect(1, i % 2 == 0 ? KEY_EVENT_PRESS : KEY_EVENT_RELEASE, first, i * 50 + KEY_DEBOUNCE_MS);
+    }
+    expect_none();
+    if ( notified != 7 + repeats + 4 + KEY_QUEUE_LEN ) fail("notify calls");
+
+    // Idle: only the TIM5 overflows wake the core (the last WFI may end past
+    // the 10 s)
+    uint64_t from = sim_time_ns();
+    sim_cpu_stats_t cpu;
+    sim_cpu_reset_stats();
+    while ( sim_time_ns() - from < 10000000000ull ) __WFI();
+    sim_cpu_get_stats(&cpu);
+    uint32_t overflows = 10000000 / 65536 + 2;
+    if ( cpu.wfi > overflows ) {
+        printf("FAIL %lu wake-ups in 10 idle s, at most %lu expected\n", (unsigned long)cpu.wfi,
+               (unsigned long)overflows);
+        return 1;
+    }
+    expect_none();
+
+    printf("3 keys, %lu repeats in a 1 s hold, %lu idle wake-ups in 10 s\n", (unsigned long)repeats,
+           (unsigned long)cpu.wfi);
+    printf("ok\n");
+    return 0;
+}
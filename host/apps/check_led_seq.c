@@ -0,0 +1,158 @@
+/*
+ * Checks the LED sequencer against the pattern tables it plays. Three tracks
+ * with unrelated periods share the four board LEDs (common anode, so lit is
+ * low); the port pins are compared with the tables every millisecond,
+ * clear of the step edges:
+ * - each track shows the step its own start time predicts, minutes in, so
+ *   sharing one utimer neither drifts nor delays a track;
+ * - a track with a lap count turns its LEDs off after the last lap;
+ * - restarting a track with a new pattern and stopping one leave the others
+ *   alone;
+ * - only step edges wake the core: the sleeping loop wakes no more often
+ *   than the tracks change step, plus the TIM5 overflow interrupts.
+ *
+ * Usage: check_led_seq
+ * Exits with 1 on the first mismatch.
+ */
+#include "sim.h"
+#include "stm32f10x.h"
+#include "led/led_seq.h"
+#include <stdlib.h>
+
+static const gpio_pin_t pins[] = {
+    GPIO_PIN_INIT('D', 12), GPIO_PIN_INIT('D', 11), GPIO_PIN_INIT('D', 9), GPIO_PIN_INIT('B', 8),
+};
+
+static const led_seq_step_t blink[] = { { 0x1, 100 }, { 0x0, 500 } };
+static const led_seq_step_t flash[] = { { 0x2, 100 }, { 0x0, 100 } };
+static const led_seq_step_t chase[] = { { 0x4, 30 }, { 0x8, 30 }, { 0x0, 47 } };
+static const led_seq_step_t pulse[] = { { 0x1, 7 }, { 0x0, 13 } };
+
+typedef struct {
+    led_seq_t seq;
+    const led_seq_step_t *steps;
+    uint8_t count;
+    uint16_t mask;
+    uint16_t loops;
+    uint64_t start_ns;
+} track_t;
+
+static track_t tracks[3];
+
+static void play(track_t *t, const led_seq_step_t *steps, uint8_t count, uint16_t mask, uint16_t loops) {
+    t->steps = steps;
+    t->count = count;
+    t->mask = mask;
+    t->loops = loops;
+    t->start_ns = sim_time_ns();
+    if ( led_seq_play(&t->seq, steps, count, mask, loops) != 0 ) {
+        printf("FAIL led_seq_play\n");
+        exit(1);
+    }
+}
+
+// LEDs the track should light now
+static uint16_t expected(const track_t *t) {
+    if ( t->steps == NULL ) return 0;
+    uint64_t period = 0;
+    for ( uint8_t i = 0; i < t->count; i++ ) period += t->steps[i].ms * 1000000ull;
+    uint64_t at = sim_time_ns() - t->start_ns;
+    if ( t->loops != LED_SEQ_FOREVER && at >= period * t->loops ) return 0;
+    at %= period;
+    for ( uint8_t i = 0; i < t->count; i++ ) {
+        if ( at < t->steps[i].ms * 1000000ull ) return t->steps[i].on & t->mask;
+        at -= t->steps[i].ms * 1000000ull;
+    }
+    return 0;
+}
+
+static uint16_t pins_lit(void) {
+    uint16_t lit = 0;
+    for ( uint8_t i = 0; i < 4; i++ ) {
+        if ( sim_gpio_driven_low((char)('A' + pins[i].port), pins[i].pin) ) lit |= 1u << i;
+    }
+    return lit;
+}
+
+// Move to the next time `us` into a millisecond. Steps last whole
+// milliseconds, so a track started at one offset changes step at that offset
+// only: tracks start at 100 .. 600 us and are checked at 900 us.
+static void align(uint32_t us) {
+    uint64_t now = sim_time_ns();
+    uint64_t t = now - now % 1000000 + us * 1000ull;
+    if ( t <= now ) t += 1000000;
+    sim_advance_ns(t - now);
+}
+
+static void check_for(uint32_t ms) {
+    align(900);
+    for ( uint32_t i = 0; i < ms; i++ ) {
+        if ( i != 0 ) sim_advance_ms(1);
+        uint16_t want = 0;
+        for ( uint8_t k = 0; k < 3; k++ ) want |= expected(&tracks[k]);
+        uint16_t got = pins_lit();
+        if ( got != want || led_seq_lit() != want ) {
+            printf("FAIL at %llu us: LEDs 0x%x (led_seq_lit 0x%x), expected 0x%x\n",
+                   (unsigned long long)(sim_time_ns() / 1000), got, led_seq_lit(), want);
+            exit(1);
+        }
+    }
+}
+
+int main(void) {
+    sim_init();
+    if ( led_seq_init(pins, 4, true) != 0 || pins_lit() != 0 ) {
+        printf("FAIL led_seq_init\n");
+        return 1;
+    }
+    if ( led_seq_play(&tracks[0].seq, blink, 2, 0, LED_SEQ_FOREVER) != 1 ) {
+        printf("FAIL empty mask accepted\n");
+        return 1;
+    }
+
+    align(100);
+    play(&tracks[0], blink, 2, 0x1, LED_SEQ_FOREVER);
+    align(200);
+    play(&tracks[1], flash, 2, 0x2, LED_SEQ_FOREVER);
+    align(300);
+    play(&tracks[2], chase, 3, 0xC, 5);
+    check_for(3000);
+    if ( led_seq_playing(&tracks[2].seq) ) {
+        printf("FAIL finite track still playing\n");
+        return 1;
+    }
+
+    align(400);
+    play(&tracks[2], chase, 3, 0xC, LED_SEQ_FOREVER);
+    check_for(2000);
+    align(500);
+    play(&tracks[0], pulse, 2, 0x1, LED_SEQ_FOREVER);
+    check_for(2000);
+    led_seq_stop(&tracks[1].seq);
+    tracks[1].steps = NULL;
+    check_for(1000);
+    align(600);
+    play(&tracks[1], flash, 2, 0x2, LED_SEQ_FOREVER);
+    check_for(5 * 60 * 1000);
+
+    // Wake-ups while sleeping: one per step edge of a track at most (edges
+    // that coincide share one), plus a TIM5 overflow every 65.536 ms
+    uint64_t from = sim_time_ns();
+    sim_cpu_stats_t cpu;
+    sim_cpu_reset_stats();
+    while ( sim_time_ns() - from < 10000000000ull ) __WFI();
+    sim_cpu_get_stats(&cpu);
+    uint32_t edges = 10000 / 20 * 2 + 10000 / 200 * 2 + (uint32_t)( 10000 / 107.0 * 3 ) + 3;
+    uint32_t overflows = 10000000 / 65536 + 1;
+    if ( cpu.wfi > edges + overflows ) {
+        printf("FAIL %lu wake-ups in 10 s, at most %lu expected\n", (unsigned long)cpu.wfi,
+               (unsigned long)( edges + overflows ));
+        return 1;
+    }
+    check_for(10);
+
+    printf("3 tracks, %lu wake-ups in 10 s for %lu step edges\n", (unsigned long)cpu.wfi,
+           (unsigned long)edges);
+    printf("ok\n");
+    return 0;
+}
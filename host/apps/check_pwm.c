@@ -0,0 +1,121 @@
+/*
+ * Checks the PWM brightness driver on the simulated timers and DMA:
+ * - both outputs are set up as the board needs them: TIM1_CH1 with the main
+ *   output enable and a repetition counter, TIM4_CH1 remapped to PD12 with
+ *   the output inverted for the common-anode LED;
+ * - pwm_led_set() writes the gamma-corrected compare value at once;
+ * - a backlight fade moves CCR1 one table entry per 5 ms step, never
+ *   backwards, and ends on the target within its duration plus one step;
+ * - a repeating pattern on the status LED is exactly at the entry the number
+ *   of TIM4 updates since it started predicts, several laps in;
+ * - neither needs an interrupt: the DMA channel plays with its interrupts
+ *   off, so no step wakes the core;
+ * - the backlight never touches DMA1 channel 5, the USART1 RX channel;
+ * - pwm_led_stop() keeps the level and pwm_led_deinit() turns the LED off on
+ *   a GPIO output.
+ *
+ * Usage: check_pwm
+ * Exits with 1 on the first mismatch.
+ */
+#include "sim.h"
+#include "stm32f10x.h"
+#include "pwm/pwm_led.h"
+#include <stdlib.h>
+
+#define STEP_NS     ( 1000000000ull / PWM_LED_STEP_HZ )
+
+static void expect(const char *what, uint32_t got, uint32_t expected) {
+    if ( got != expected ) {
+        printf("FAIL %s: got %lu, expected %lu (at %llu us)\n", what,
+               (unsigned long)got, (unsigned long)expected,
+               (unsigned long long)(sim_time_ns() / 1000));
+        exit(1);
+    }
+}
+
+static uint16_t pattern[PWM_LED_STEPS(1000)];
+
+int main(void) {
+    sim_init();
+    // Stands for a running USART1 receive
+    DMA1_Channel5->CCR = DMA_CCR1_MINC | DMA_CCR1_TCIE | DMA_CCR1_EN;
+
+    expect("init backlight", pwm_led_init(PWM_LED_BACKLIGHT), 0);
+    uint64_t tim4_start = sim_time_ns();
+    expect("init status", pwm_led_init(PWM_LED_STATUS), 0);
+    expect("init unknown", pwm_led_init(PWM_LED_COUNT), 1);
+
+    expect("TIM1 ARR", TIM1->ARR, PWM_LED_PERIOD - 1);
+    expect("TIM1 RCR", TIM1->RCR, 99);
+    expect("TIM1 MOE", TIM1->BDTR & TIM_BDTR_MOE, TIM_BDTR_MOE);
+    expect("TIM1 CCER", TIM1->CCER & 0xF, TIM_CCER_CC1E);
+    expect("TIM4 PSC", TIM4->PSC, 99);
+    expect("TIM4 CCER", TIM4->CCER & 0xF, TIM_CCER_CC1E | TIM_CCER_CC1P);
+    expect("TIM4 remap", AFIO->MAPR & AFIO_MAPR_TIM4_REMAP, AFIO_MAPR_TIM4_REMAP);
+    expect("PA8 AF", (GPIOA->CRH >> 0) & 0xF, 0xB);
+    expect("PD12 AF", (GPIOD->CRH >> 16) & 0xF, 0xB);
+
+    expect("duty 0", pwm_led_duty(0), 0);
+    expect("duty 1", pwm_led_duty(1), 1);
+    expect("duty 255", pwm_led_duty(255), PWM_LED_PERIOD);
+    pwm_led_set(PWM_LED_BACKLIGHT, 128);
+    expect("set", TIM1->CCR1, pwm_led_duty(128));
+    pwm_led_set(PWM_LED_BACKLIGHT, 0);
+
+    // Backlight fade 0 -> 255 in 500 ms
+    static uint16_t fade[PWM_LED_STEPS(500)];
+    uint64_t start = sim_time_ns();
+    expect("fade", pwm_led_fade(PWM_LED_BACKLIGHT, fade, PWM_LED_STEPS(500), 255), 0);
+    expect("level", pwm_led_level(PWM_LED_BACKLIGHT), 255);
+    uint32_t last = 0;
+    uint64_t done = 0;
+    for ( uint32_t ms = 1; ms <= 600; ms++ ) {
+        sim_advance_ms(1);
+        uint32_t ccr = TIM1->CCR1;
+        if ( ccr < last ) expect("fade monotonic", ccr, last);
+        if ( ccr == PWM_LED_PERIOD && done == 0 ) done = sim_time_ns() - start;
+        last = ccr;
+    }
+    if ( done == 0 || done > 500000000ull + STEP_NS ) {
+        printf("FAIL fade ended after %llu us\n", (unsigned long long)(done / 1000));
+        return 1;
+    }
+    expect("fade playing", pwm_led_playing(PWM_LED_BACKLIGHT), 0);
+    pwm_led_set(PWM_LED_BACKLIGHT, 10);
+    expect("USART1 RX DMA", DMA1_Channel5->CCR, DMA_CCR1_MINC | DMA_CCR1_TCIE | DMA_CCR1_EN);
+
+    // Breathing on the status LED, one second per lap
+    pwm_led_fill_fade(pattern, PWM_LED_STEPS(500), 0, 255);
+    pwm_led_fill_fade(pattern + PWM_LED_STEPS(500), PWM_LED_STEPS(500), 255, 0);
+    uint64_t played = sim_time_ns();
+    expect("play", pwm_led_play(PWM_LED_STATUS, pattern, PWM_LED_STEPS(1000), true), 0);
+    uint32_t before = (uint32_t)( ( played - tim4_start ) / STEP_NS );
+    for ( uint32_t i = 0; i < 700; i++ ) {
+        // Half way between two TIM4 updates
+        uint64_t t = tim4_start + ( before + 1 + i ) * STEP_NS + STEP_NS / 2;
+        sim_advance_ns(t - sim_time_ns());
+        uint32_t steps = i + 1;
+        expect("pattern", TIM4->CCR1, pattern[( steps - 1 ) % PWM_LED_STEPS(1000)]);
+    }
+    expect("pattern playing", pwm_led_playing(PWM_LED_STATUS), 1);
+    expect("DMA interrupts", DMA1_Channel7->CCR & ( DMA_CCR1_TCIE | DMA_CCR1_HTIE | DMA_CCR1_TEIE ), 0);
+    expect("wakes", sim_timer_next_event(sim_time_ns()) == SIM_NO_EVENT, 1);
+
+    uint32_t held = TIM4->CCR1;
+    pwm_led_stop(PWM_LED_STATUS);
+    sim_advance_ms(50);
+    expect("stop", TIM4->CCR1, held);
+    expect("stopped", pwm_led_playing(PWM_LED_STATUS), 0);
+    expect("play no table", pwm_led_play(PWM_LED_STATUS, NULL, 1, false), 1);
+
+    pwm_led_deinit(PWM_LED_STATUS);
+    expect("PD12 GPIO", (GPIOD->CRH >> 16) & 0xF, 0x2);
+    expect("PD12 off", (GPIOD->ODR >> 12) & 1, 1);
+    expect("play after deinit", pwm_led_play(PWM_LED_STATUS, pattern, 1, false), 2);
+
+    printf("fade: %u steps, done after %llu us\n", PWM_LED_STEPS(500),
+           (unsigned long long)(done / 1000));
+    printf("pattern: %u laps checked\n", 700 / PWM_LED_STEPS(1000));
+    printf("ok\n");
+    return 0;
+}
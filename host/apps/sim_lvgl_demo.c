@@ -0,0 +1,70 @@
+/*
+ * Runs samples/07-LVGL-Demo.c unchanged on the host simulation, stops it after
+ * a number of virtual seconds and dumps the panel contents to a PNG.
+ *
+ * Usage: sim_lvgl_demo [out.png] [virtual seconds]
+ */
+#include "sim.h"
+#include <stdlib.h>
+
+#define main sample_main
+#include "07-LVGL-Demo.c"
+#undef main
+
+static const char *png_path;
+
+static void print_profile(void) {
+    profile_probe_t probes[PROFILE_MAX_PROBES];
+    uint32_t n = profile_get_probes(probes, PROFILE_MAX_PROBES);
+
+    printf("%-20s %8s %10s %10s %10s [us]\n", "probe", "count", "min", "mean", "max");
+    for (uint32_t i = 0; i < n; ++i) {
+        if (probes[i].count == 0) continue;
+        printf("%-20s %8u %10u %10llu %10u\n", probes[i].name, probes[i].count,
+               probes[i].min / PROFILE_CPU_MHZ,
+               (unsigned long long)(probes[i].total / probes[i].count / PROFILE_CPU_MHZ),
+               probes[i].max / PROFILE_CPU_MHZ);
+    }
+}
+
+// Called by the simulation once the time limit is reached.
+static void finish(void) {
+    sim_spi_stats_t spi;
+    sim_st7789_stats_t panel;
+    sim_cpu_stats_t cpu;
+    sim_spi_get_stats(&spi);
+    sim_st7789_get_stats(&panel);
+    sim_cpu_get_stats(&cpu);
+    uint64_t run_ns = sim_time_ns();
+
+    printf("\nrun: %llu ms, SPI %u transfers, %llu bytes, busy %.2f%%\n",
+           (unsigned long long)(run_ns / 1000000), spi.transfers,
+           (unsigned long long)spi.bytes, 100.0 * spi.busy_ns / run_ns);
+    printf("tick: %u ms\n", delay_get_tick());
+    printf("cpu: asleep %.2f%% in %u WFI\n", 100.0 * cpu.sleep_ns / run_ns, cpu.wfi);
+    printf("panel: %u commands, %u RAMWR, %llu pixels\n",
+           panel.commands, panel.ramwr, (unsigned long long)panel.pixels);
+    print_profile();
+
+    if (sim_st7789_dump_png(png_path) != 0) {
+        fprintf(stderr, "failed to write %s\n", png_path);
+        exit(1);
+    }
+    printf("wrote %s\n", png_path);
+    exit(0);
+}
+
+int main(int argc, char **argv) {
+    png_path = argc > 1 ? argv[1] : "sim_lvgl_demo.png";
+    uint32_t run_s = argc > 2 ? (uint32_t)atoi(argv[2]) : 5;
+
+    sim_init();
+    sim_usart_set_output(stdout);
+    sim_dht11_set(55, 24, 3);
+    sim_adc_set_value(ADC_CH8_PB0, 1024);
+    sim_adc_set_value(ADC_CH13_PC3, 3071);
+    sim_set_time_limit((uint64_t)run_s * 1000000000ull, finish);
+
+    sample_main();
+    return 1;
+}
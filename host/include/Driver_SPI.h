@@ -0,0 +1,74 @@
+/*
+ * Host stand-in for the CMSIS-Driver SPI interface.
+ * Names and values follow CMSIS-Driver SPI 2.x.
+ */
+
+#ifndef DRIVER_SPI_H_
+#define DRIVER_SPI_H_
+
+#include "Driver_Common.h"
+
+#define ARM_SPI_CONTROL_Pos              0
+#define ARM_SPI_CONTROL_Msk             (0xFFUL << ARM_SPI_CONTROL_Pos)
+
+#define ARM_SPI_MODE_INACTIVE           (0x00UL << ARM_SPI_CONTROL_Pos)
+#define ARM_SPI_MODE_MASTER             (0x01UL << ARM_SPI_CONTROL_Pos)
+#define ARM_SPI_MODE_SLAVE              (0x02UL << ARM_SPI_CONTROL_Pos)
+#define ARM_SPI_SET_BUS_SPEED           (0x10UL << ARM_SPI_CONTROL_Pos)
+#define ARM_SPI_GET_BUS_SPEED           (0x11UL << ARM_SPI_CONTROL_Pos)
+#define ARM_SPI_CONTROL_SS              (0x13UL << ARM_SPI_CONTROL_Pos)
+#define ARM_SPI_ABORT_TRANSFER          (0x14UL << ARM_SPI_CONTROL_Pos)
+
+#define ARM_SPI_FRAME_FORMAT_Pos         8
+#define ARM_SPI_CPOL0_CPHA0             (0UL << ARM_SPI_FRAME_FORMAT_Pos)
+#define ARM_SPI_CPOL0_CPHA1             (1UL << ARM_SPI_FRAME_FORMAT_Pos)
+#define ARM_SPI_CPOL1_CPHA0             (2UL << ARM_SPI_FRAME_FORMAT_Pos)
+#define ARM_SPI_CPOL1_CPHA1             (3UL << ARM_SPI_FRAME_FORMAT_Pos)
+
+#define ARM_SPI_DATA_BITS_Pos            12
+#define ARM_SPI_DATA_BITS(n)            (((n) & 0x3FUL) << ARM_SPI_DATA_BITS_Pos)
+
+#define ARM_SPI_SS_MASTER_MODE_Pos       19
+#define ARM_SPI_SS_MASTER_UNUSED        (0UL << ARM_SPI_SS_MASTER_MODE_Pos)
+#define ARM_SPI_SS_MASTER_SW            (1UL << ARM_SPI_SS_MASTER_MODE_Pos)
+#define ARM_SPI_SS_MASTER_HW_OUTPUT     (2UL << ARM_SPI_SS_MASTER_MODE_Pos)
+
+#define ARM_SPI_SS_INACTIVE              0UL
+#define ARM_SPI_SS_ACTIVE                1UL
+
+typedef struct _ARM_SPI_STATUS {
+    uint32_t busy       : 1;
+    uint32_t data_lost  : 1;
+    uint32_t mode_fault : 1;
+    uint32_t reserved   : 29;
+} ARM_SPI_STATUS;
+
+#define ARM_SPI_EVENT_TRANSFER_COMPLETE (1UL << 0)
+#define ARM_SPI_EVENT_DATA_LOST         (1UL << 1)
+#define ARM_SPI_EVENT_MODE_FAULT        (1UL << 2)
+
+typedef void (*ARM_SPI_SignalEvent_t) (uint32_t event);
+
+typedef struct _ARM_SPI_CAPABILITIES {
+    uint32_t simplex          : 1;
+    uint32_t ti_ssi           : 1;
+    uint32_t microwire        : 1;
+    uint32_t event_mode_fault : 1;
+    uint32_t reserved         : 28;
+} ARM_SPI_CAPABILITIES;
+
+typedef struct _ARM_DRIVER_SPI {
+    ARM_DRIVER_VERSION   (*GetVersion)      (void);
+    ARM_SPI_CAPABILITIES (*GetCapabilities) (void);
+    int32_t              (*Initialize)      (ARM_SPI_SignalEvent_t cb_event);
+    int32_t              (*Uninitialize)    (void);
+    int32_t              (*PowerControl)    (ARM_POWER_STATE state);
+    int32_t              (*Send)            (const void *data, uint32_t num);
+    int32_t              (*Receive)         (      void *data, uint32_t num);
+    int32_t              (*Transfer)        (const void *data_out, void *data_in, uint32_t num);
+    uint32_t             (*GetDataCount)    (void);
+    int32_t              (*Control)         (uint32_t control, uint32_t arg);
+    ARM_SPI_STATUS       (*GetStatus)       (void);
+} const ARM_DRIVER_SPI;
+
+#endif /* DRIVER_SPI_H_ */
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the csolution generated RTE_Components.h.
+ */
+
+#ifndef RTE_COMPONENTS_H
+#define RTE_COMPONENTS_H
+
+#define CMSIS_device_header "stm32f10x.h"
+
+#define RTE_Drivers_SPI1                /* Driver SPI1 (host simulation) */
+#define RTE_Drivers_USART1              /* Driver USART1 (host simulation) */
+
+#endif /* RTE_COMPONENTS_H */
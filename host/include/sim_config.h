@@ -0,0 +1,18 @@
+/*
+ * Force-included into every translation unit of the host build.
+ * Overrides the switches in libs_common.h for the simulation.
+ */
+
+#ifndef HOST_SIM_CONFIG_H
+#define HOST_SIM_CONFIG_H
+
+// RTX is not simulated; the libraries use their bare-metal SysTick paths.
+#define USE_CMSIS_OS 0
+
+// Driver instrumentation is always on in the simulation.
+#define ST7789_SPI_TRACE 1
+
+void sim_spin(void);
+#define HW_SPIN_HOOK() sim_spin()
+
+#endif /* HOST_SIM_CONFIG_H */
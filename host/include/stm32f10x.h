@@ -0,0 +1,454 @@
+#ifndef HOST_STM32F10X_H
+#define HOST_STM32F10X_H
+
+/*
+ * Host stand-in for the STM32F10x device header.
+ *
+ * Only the registers and bit definitions used by the libraries are provided.
+ * Register blocks live in memory owned by the simulation; the models in
+ * host/sim react to them whenever the virtual clock advances.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __I  volatile const
+#define __O  volatile
+#define __IO volatile
+
+/* ---------------------------------------------------------------------------
+ * Simulation entry points the libraries reach through HW_SPIN_HOOK().
+ * ------------------------------------------------------------------------- */
+void sim_spin(void);
+void sim_wfi(void);
+
+/* ---------------------------------------------------------------------------
+ * Core
+ * ------------------------------------------------------------------------- */
+typedef enum IRQn {
+    SysTick_IRQn        = -1,
+    EXTI0_IRQn          = 6,
+    EXTI1_IRQn          = 7,
+    EXTI2_IRQn          = 8,
+    EXTI3_IRQn          = 9,
+    EXTI4_IRQn          = 10,
+    DMA1_Channel1_IRQn  = 11,
+    DMA1_Channel2_IRQn  = 12,
+    DMA1_Channel3_IRQn  = 13,
+    DMA1_Channel4_IRQn  = 14,
+    DMA1_Channel5_IRQn  = 15,
+    DMA1_Channel6_IRQn  = 16,
+    DMA1_Channel7_IRQn  = 17,
+    ADC1_2_IRQn         = 18,
+    EXTI9_5_IRQn        = 23,
+    TIM1_UP_IRQn        = 25,
+    TIM2_IRQn           = 28,
+    TIM3_IRQn           = 29,
+    TIM4_IRQn           = 30,
+    SPI1_IRQn           = 35,
+    USART1_IRQn         = 37,
+    EXTI15_10_IRQn      = 40,
+    TIM5_IRQn           = 50,
+    TIM6_IRQn           = 54,
+    TIM7_IRQn           = 55,
+} IRQn_Type;
+
+typedef struct {
+    __IO uint32_t CTRL;
+    __IO uint32_t LOAD;
+    __IO uint32_t VAL;
+    __I  uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_ENABLE     ((uint32_t)0x00000001)
+#define SysTick_CTRL_TICKINT    ((uint32_t)0x00000002)
+#define SysTick_CTRL_CLKSOURCE  ((uint32_t)0x00000004)
+#define SysTick_CTRL_COUNTFLAG  ((uint32_t)0x00010000)
+
+typedef struct {
+    __I  uint32_t CPUID;
+    __IO uint32_t ICSR;
+    __IO uint32_t VTOR;
+    __IO uint32_t AIRCR;
+    __IO uint32_t SCR;
+} SCB_Type;
+
+#define SCB_ICSR_PENDSTSET_Msk      (1UL << 26)
+#define SCB_ICSR_PENDSTCLR_Msk      (1UL << 25)
+#define SCB_SCR_SLEEPDEEP_Msk       (1UL << 2)
+
+typedef struct {
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+#define DWT_CTRL_NOCYCCNT_Msk       (1UL << 25)
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+
+typedef struct {
+    __IO uint32_t DHCSR;
+    __O  uint32_t DCRSR;
+    __IO uint32_t DCRDR;
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+
+void NVIC_EnableIRQ(IRQn_Type irqn);
+void NVIC_DisableIRQ(IRQn_Type irqn);
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority);
+void NVIC_SetPendingIRQ(IRQn_Type irqn);
+void NVIC_ClearPendingIRQ(IRQn_Type irqn);
+
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __DSB(void) {}
+static inline void __ISB(void) {}
+static inline void __NOP(void) {}
+#define __COMPILER_BARRIER() __asm__ volatile("" ::: "memory")
+static inline void __WFI(void) { sim_wfi(); }
+
+/* ---------------------------------------------------------------------------
+ * Peripherals
+ * ------------------------------------------------------------------------- */
+typedef struct {
+    __IO uint32_t CRL;
+    __IO uint32_t CRH;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;
+    __IO uint32_t BRR;
+    __IO uint32_t LCKR;
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR;
+    __IO uint32_t CFGR;
+    __IO uint32_t CIR;
+    __IO uint32_t APB2RSTR;
+    __IO uint32_t APB1RSTR;
+    __IO uint32_t AHBENR;
+    __IO uint32_t APB2ENR;
+    __IO uint32_t APB1ENR;
+    __IO uint32_t BDCR;
+    __IO uint32_t CSR;
+} RCC_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+    __IO uint32_t BDTR;
+    __IO uint32_t DCR;
+    __IO uint32_t DMAR;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMPR1;
+    __IO uint32_t SMPR2;
+    __IO uint32_t JOFR1;
+    __IO uint32_t JOFR2;
+    __IO uint32_t JOFR3;
+    __IO uint32_t JOFR4;
+    __IO uint32_t HTR;
+    __IO uint32_t LTR;
+    __IO uint32_t SQR1;
+    __IO uint32_t SQR2;
+    __IO uint32_t SQR3;
+    __IO uint32_t JSQR;
+    __IO uint32_t JDR1;
+    __IO uint32_t JDR2;
+    __IO uint32_t JDR3;
+    __IO uint32_t JDR4;
+    __IO uint32_t DR;
+} ADC_TypeDef;
+
+/* CPAR/CMAR hold host pointers here; the libraries store `(uintptr_t)addr`,
+ * which is the 32-bit register value on the device. */
+typedef struct {
+    __IO uint32_t CCR;
+    __IO uint32_t CNDTR;
+    __IO uintptr_t CPAR;
+    __IO uintptr_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct {
+    __IO uint32_t ISR;
+    __IO uint32_t IFCR;
+} DMA_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t BRR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t CR3;
+    __IO uint32_t GTPR;
+} USART_TypeDef;
+
+typedef struct {
+    __IO uint32_t EVCR;
+    __IO uint32_t MAPR;
+    __IO uint32_t EXTICR[4];
+    uint32_t RESERVED0;
+    __IO uint32_t MAPR2;
+} AFIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t IMR;
+    __IO uint32_t EMR;
+    __IO uint32_t RTSR;
+    __IO uint32_t FTSR;
+    __IO uint32_t SWIER;
+    __IO uint32_t PR;
+} EXTI_TypeDef;
+
+/* The GPIO banks are laid out 0x400 apart like on the device, because the
+ * libraries compute `GPIOA_BASE + 0x400 * (bank - 'A')`. Stores to them are
+ * trapped so BSRR/BRR act per write (see host/sim/sim_mmio.c). */
+#define SIM_GPIO_STRIDE 0x400
+#define SIM_GPIO_BANKS  7
+
+/* TIM2..TIM7 and TIM1 (after TIM7 here, it sits on APB2 on the device) are
+ * trapped the same way, so SR flags clear on a written 0 and CNT/EGR writes
+ * take effect immediately. */
+#define SIM_TIM_STRIDE  0x400
+
+/* AFIO and EXTI share one trapped block, 0x400 apart as on the device, so
+ * PR bits clear on a written 1 and SWIER raises its lines. */
+#define SIM_EXTI_OFFSET 0x400
+
+extern uint8_t *sim_gpio_mem;
+extern uint8_t *sim_afio_mem;
+extern RCC_TypeDef sim_rcc;
+/* ADC1 and DMA1 are trapped too: SR/ISR flags clear per write and a store of
+ * ADON or a channel enable bit takes effect immediately. */
+#define SIM_DMA_CHANNELS 7
+
+extern uint8_t *sim_tim_mem;
+extern uint8_t *sim_adc_mem;
+extern uint8_t *sim_dma_mem;
+extern USART_TypeDef sim_usart1;
+extern SysTick_Type sim_systick;
+extern SCB_Type sim_scb;
+extern DWT_Type sim_dwt;
+extern CoreDebug_Type sim_coredebug;
+
+#define GPIOA_BASE  ((uintptr_t)sim_gpio_mem)
+#define GPIOB_BASE  (GPIOA_BASE + 1 * SIM_GPIO_STRIDE)
+#define GPIOC_BASE  (GPIOA_BASE + 2 * SIM_GPIO_STRIDE)
+#define GPIOD_BASE  (GPIOA_BASE + 3 * SIM_GPIO_STRIDE)
+#define GPIOE_BASE  (GPIOA_BASE + 4 * SIM_GPIO_STRIDE)
+#define GPIOF_BASE  (GPIOA_BASE + 5 * SIM_GPIO_STRIDE)
+#define GPIOG_BASE  (GPIOA_BASE + 6 * SIM_GPIO_STRIDE)
+
+#define GPIOA   ((GPIO_TypeDef *) GPIOA_BASE)
+#define GPIOB   ((GPIO_TypeDef *) GPIOB_BASE)
+#define GPIOC   ((GPIO_TypeDef *) GPIOC_BASE)
+#define GPIOD   ((GPIO_TypeDef *) GPIOD_BASE)
+#define GPIOE   ((GPIO_TypeDef *) GPIOE_BASE)
+#define GPIOF   ((GPIO_TypeDef *) GPIOF_BASE)
+#define GPIOG   ((GPIO_TypeDef *) GPIOG_BASE)
+#define RCC     (&sim_rcc)
+#define AFIO    ((AFIO_TypeDef *)sim_afio_mem)
+#define EXTI    ((EXTI_TypeDef *)(sim_afio_mem + SIM_EXTI_OFFSET))
+#define TIM2    ((TIM_TypeDef *)(sim_tim_mem + 0 * SIM_TIM_STRIDE))
+#define TIM3    ((TIM_TypeDef *)(sim_tim_mem + 1 * SIM_TIM_STRIDE))
+#define TIM4    ((TIM_TypeDef *)(sim_tim_mem + 2 * SIM_TIM_STRIDE))
+#define TIM5    ((TIM_TypeDef *)(sim_tim_mem + 3 * SIM_TIM_STRIDE))
+#define TIM6    ((TIM_TypeDef *)(sim_tim_mem + 4 * SIM_TIM_STRIDE))
+#define TIM7    ((TIM_TypeDef *)(sim_tim_mem + 5 * SIM_TIM_STRIDE))
+#define TIM1    ((TIM_TypeDef *)(sim_tim_mem + 6 * SIM_TIM_STRIDE))
+#define ADC1    ((ADC_TypeDef *)sim_adc_mem)
+#define DMA1    ((DMA_TypeDef *)sim_dma_mem)
+#define DMA1_Channel1 ((DMA_Channel_TypeDef *)(sim_dma_mem + sizeof(DMA_TypeDef)) + 0)
+#define DMA1_Channel2 ((DMA_Channel_TypeDef *)(sim_dma_mem + sizeof(DMA_TypeDef)) + 1)
+#define DMA1_Channel3 ((DMA_Channel_TypeDef *)(sim_dma_mem + sizeof(DMA_TypeDef)) + 2)
+#define DMA1_Channel4 ((DMA_Channel_TypeDef *)(sim_dma_mem + sizeof(DMA_TypeDef)) + 3)
+#define DMA1_Channel5 ((DMA_Channel_TypeDef *)(sim_dma_mem + sizeof(DMA_TypeDef)) + 4)
+#define DMA1_Channel6 ((DMA_Channel_TypeDef *)(sim_dma_mem + sizeof(DMA_TypeDef)) + 5)
+#define DMA1_Channel7 ((DMA_Channel_TypeDef *)(sim_dma_mem + sizeof(DMA_TypeDef)) + 6)
+#define USART1  (&sim_usart1)
+#define SysTick (&sim_systick)
+#define SCB     (&sim_scb)
+#define DWT     (&sim_dwt)
+#define CoreDebug (&sim_coredebug)
+
+/* ---------------------------------------------------------------------------
+ * RCC bits
+ * ------------------------------------------------------------------------- */
+#define RCC_CFGR_ADCPRE         ((uint32_t)0x0000C000)
+#define RCC_CFGR_ADCPRE_DIV2    ((uint32_t)0x00000000)
+#define RCC_CFGR_ADCPRE_DIV4    ((uint32_t)0x00004000)
+#define RCC_CFGR_ADCPRE_DIV6    ((uint32_t)0x00008000)
+#define RCC_CFGR_ADCPRE_DIV8    ((uint32_t)0x0000C000)
+
+#define RCC_AHBENR_DMA1EN       ((uint32_t)0x00000001)
+
+#define RCC_APB2ENR_AFIOEN      ((uint32_t)0x00000001)
+#define RCC_APB2ENR_IOPAEN      ((uint32_t)0x00000004)
+#define RCC_APB2ENR_IOPBEN      ((uint32_t)0x00000008)
+#define RCC_APB2ENR_IOPCEN      ((uint32_t)0x00000010)
+#define RCC_APB2ENR_IOPDEN      ((uint32_t)0x00000020)
+#define RCC_APB2ENR_IOPEEN      ((uint32_t)0x00000040)
+#define RCC_APB2ENR_ADC1EN      ((uint32_t)0x00000200)
+#define RCC_APB2ENR_TIM1EN      ((uint32_t)0x00000800)
+#define RCC_APB2ENR_SPI1EN      ((uint32_t)0x00001000)
+#define RCC_APB2ENR_USART1EN    ((uint32_t)0x00004000)
+
+#define RCC_APB1ENR_TIM2EN      ((uint32_t)0x00000001)
+#define RCC_APB1ENR_TIM3EN      ((uint32_t)0x00000002)
+#define RCC_APB1ENR_TIM4EN      ((uint32_t)0x00000004)
+#define RCC_APB1ENR_TIM5EN      ((uint32_t)0x00000008)
+#define RCC_APB1ENR_TIM6EN      ((uint32_t)0x00000010)
+#define RCC_APB1ENR_TIM7EN      ((uint32_t)0x00000020)
+#define RCC_APB1RSTR_TIM6RST    ((uint32_t)0x00000010)
+#define RCC_APB1RSTR_TIM7RST    ((uint32_t)0x00000020)
+
+/* ---------------------------------------------------------------------------
+ * TIM bits
+ * ------------------------------------------------------------------------- */
+#define TIM_CR1_CEN             ((uint16_t)0x0001)
+#define TIM_CR1_URS             ((uint16_t)0x0004)
+#define TIM_CR1_OPM             ((uint16_t)0x0008)
+#define TIM_CR1_ARPE            ((uint16_t)0x0080)
+#define TIM_CR2_CCDS            ((uint16_t)0x0008)
+#define TIM_CR2_MMS             ((uint16_t)0x0070)
+#define TIM_CR2_MMS_0           ((uint16_t)0x0010)
+#define TIM_CR2_MMS_1           ((uint16_t)0x0020)
+#define TIM_CR2_MMS_2           ((uint16_t)0x0040)
+#define TIM_DIER_UIE            ((uint16_t)0x0001)
+#define TIM_DIER_CC1IE          ((uint16_t)0x0002)
+#define TIM_DIER_CC2IE          ((uint16_t)0x0004)
+#define TIM_DIER_CC3IE          ((uint16_t)0x0008)
+#define TIM_DIER_CC4IE          ((uint16_t)0x0010)
+#define TIM_DIER_UDE            ((uint16_t)0x0100)
+#define TIM_DIER_CC3DE          ((uint16_t)0x0800)
+#define TIM_SR_UIF              ((uint16_t)0x0001)
+#define TIM_SR_CC1IF            ((uint16_t)0x0002)
+#define TIM_SR_CC2IF            ((uint16_t)0x0004)
+#define TIM_SR_CC3IF            ((uint16_t)0x0008)
+#define TIM_SR_CC4IF            ((uint16_t)0x0010)
+#define TIM_EGR_UG              ((uint8_t)0x01)
+#define TIM_CCMR1_OC1PE         ((uint16_t)0x0008)
+#define TIM_CCMR1_OC1M          ((uint16_t)0x0070)
+#define TIM_CCMR1_OC1M_0        ((uint16_t)0x0010)
+#define TIM_CCMR1_OC1M_1        ((uint16_t)0x0020)
+#define TIM_CCMR1_OC1M_2        ((uint16_t)0x0040)
+#define TIM_CCER_CC1E           ((uint16_t)0x0001)
+#define TIM_CCER_CC1P           ((uint16_t)0x0002)
+#define TIM_BDTR_MOE            ((uint16_t)0x8000)
+
+/* ---------------------------------------------------------------------------
+ * AFIO bits
+ * ------------------------------------------------------------------------- */
+#define AFIO_MAPR_TIM4_REMAP    ((uint32_t)0x00001000)
+
+/* ---------------------------------------------------------------------------
+ * ADC bits
+ * ------------------------------------------------------------------------- */
+#define ADC_SR_AWD              ((uint8_t)0x01)
+#define ADC_SR_EOC              ((uint8_t)0x02)
+#define ADC_SR_JEOC             ((uint8_t)0x04)
+#define ADC_SR_JSTRT            ((uint8_t)0x08)
+#define ADC_SR_STRT             ((uint8_t)0x10)
+
+#define ADC_CR1_AWDCH           ((uint32_t)0x0000001F)
+#define ADC_CR1_EOCIE           ((uint32_t)0x00000020)
+#define ADC_CR1_AWDIE           ((uint32_t)0x00000040)
+#define ADC_CR1_JEOCIE          ((uint32_t)0x00000080)
+#define ADC_CR1_SCAN            ((uint32_t)0x00000100)
+#define ADC_CR1_AWDSGL          ((uint32_t)0x00000200)
+#define ADC_CR1_DUALMOD         ((uint32_t)0x000F0000)
+#define ADC_CR1_AWDEN           ((uint32_t)0x00800000)
+
+#define ADC_CR2_ADON            ((uint32_t)0x00000001)
+#define ADC_CR2_CONT            ((uint32_t)0x00000002)
+#define ADC_CR2_CAL             ((uint32_t)0x00000004)
+#define ADC_CR2_RSTCAL          ((uint32_t)0x00000008)
+#define ADC_CR2_DMA             ((uint32_t)0x00000100)
+#define ADC_CR2_ALIGN           ((uint32_t)0x00000800)
+#define ADC_CR2_JEXTSEL         ((uint32_t)0x00007000)
+#define ADC_CR2_JEXTSEL_0       ((uint32_t)0x00001000)
+#define ADC_CR2_JEXTSEL_1       ((uint32_t)0x00002000)
+#define ADC_CR2_JEXTSEL_2       ((uint32_t)0x00004000)
+#define ADC_CR2_JEXTTRIG        ((uint32_t)0x00008000)
+#define ADC_CR2_EXTSEL          ((uint32_t)0x000E0000)
+#define ADC_CR2_EXTSEL_0        ((uint32_t)0x00020000)
+#define ADC_CR2_EXTSEL_1        ((uint32_t)0x00040000)
+#define ADC_CR2_EXTSEL_2        ((uint32_t)0x00080000)
+#define ADC_CR2_EXTTRIG         ((uint32_t)0x00100000)
+#define ADC_CR2_JSWSTART        ((uint32_t)0x00200000)
+#define ADC_CR2_SWSTART         ((uint32_t)0x00400000)
+
+#define ADC_SQR1_L              ((uint32_t)0x00F00000)
+#define ADC_JSQR_JL             ((uint32_t)0x00300000)
+
+/* ---------------------------------------------------------------------------
+ * DMA bits (channel 1; channel n is shifted by 4 * (n - 1) in ISR/IFCR)
+ * ------------------------------------------------------------------------- */
+#define DMA_ISR_GIF1            ((uint32_t)0x00000001)
+#define DMA_ISR_TCIF1           ((uint32_t)0x00000002)
+#define DMA_ISR_HTIF1           ((uint32_t)0x00000004)
+#define DMA_ISR_TEIF1           ((uint32_t)0x00000008)
+#define DMA_IFCR_CGIF1          ((uint32_t)0x00000001)
+#define DMA_IFCR_CTCIF1         ((uint32_t)0x00000002)
+#define DMA_IFCR_CHTIF1         ((uint32_t)0x00000004)
+#define DMA_IFCR_CTEIF1         ((uint32_t)0x00000008)
+
+#define DMA_CCR1_EN             ((uint16_t)0x0001)
+#define DMA_CCR1_TCIE           ((uint16_t)0x0002)
+#define DMA_CCR1_HTIE           ((uint16_t)0x0004)
+#define DMA_CCR1_TEIE           ((uint16_t)0x0008)
+#define DMA_CCR1_DIR            ((uint16_t)0x0010)
+#define DMA_CCR1_CIRC           ((uint16_t)0x0020)
+#define DMA_CCR1_PINC           ((uint16_t)0x0040)
+#define DMA_CCR1_MINC           ((uint16_t)0x0080)
+#define DMA_CCR1_PSIZE          ((uint16_t)0x0300)
+#define DMA_CCR1_PSIZE_0        ((uint16_t)0x0100)
+#define DMA_CCR1_PSIZE_1        ((uint16_t)0x0200)
+#define DMA_CCR1_MSIZE          ((uint16_t)0x0C00)
+#define DMA_CCR1_MSIZE_0        ((uint16_t)0x0400)
+#define DMA_CCR1_MSIZE_1        ((uint16_t)0x0800)
+#define DMA_CCR1_PL             ((uint16_t)0x3000)
+#define DMA_CCR1_PL_0           ((uint16_t)0x1000)
+#define DMA_CCR1_PL_1           ((uint16_t)0x2000)
+
+/* ---------------------------------------------------------------------------
+ * USART bits
+ * ------------------------------------------------------------------------- */
+#define USART_SR_PE             ((uint16_t)0x0001)
+#define USART_SR_FE             ((uint16_t)0x0002)
+#define USART_SR_ORE            ((uint16_t)0x0008)
+#define USART_SR_IDLE           ((uint16_t)0x0010)
+#define USART_SR_RXNE           ((uint16_t)0x0020)
+#define USART_SR_TC             ((uint16_t)0x0040)
+#define USART_SR_TXE            ((uint16_t)0x0080)
+
+#define USART_CR1_RE            ((uint16_t)0x0004)
+#define USART_CR1_TE            ((uint16_t)0x0008)
+#define USART_CR1_IDLEIE        ((uint16_t)0x0010)
+#define USART_CR1_RXNEIE        ((uint16_t)0x0020)
+#define USART_CR1_UE            ((uint16_t)0x2000)
+
+#endif /* HOST_STM32F10X_H */
@@ -0,0 +1,174 @@
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+/*
+ * Deterministic host simulation of the STM32F103 board.
+ *
+ * Time only moves when the firmware waits (HW_SPIN_HOOK, __WFI) or when a host
+ * program calls sim_advance_*(). CPU execution itself is free, so every
+ * number reported by the simulation is bus/peripheral time: SPI and USART
+ * transfers, ADC conversions, DHT11 waveforms and delays.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define SIM_CPU_HZ      72000000u
+#define SIM_CPU_MHZ     72u
+// Virtual time consumed by one iteration of a busy-wait loop (~9 cycles).
+#define SIM_SPIN_NS     125u
+
+/* ---------------------------------------------------------------------------
+ * Virtual clock
+ * ------------------------------------------------------------------------- */
+void sim_init(void);
+uint64_t sim_time_ns(void);
+void sim_advance_ns(uint64_t ns);
+void sim_advance_us(uint32_t us);
+void sim_advance_ms(uint32_t ms);
+// Advance to the next scheduled peripheral event or interrupt.
+void sim_idle(void);
+// __WFI(): sim_idle() and account the time as CPU sleep.
+void sim_wfi(void);
+
+typedef struct {
+    uint32_t wfi;            // Number of __WFI() calls.
+    uint64_t sleep_ns;       // Time spent sleeping in them.
+} sim_cpu_stats_t;
+void sim_cpu_get_stats(sim_cpu_stats_t *stats);
+void sim_cpu_reset_stats(void);
+
+/**
+ * @brief Run `fn` once virtual time reaches `ns`. Typically dumps results and
+ *        exits, which lets a firmware main loop that never returns be bounded.
+ */
+void sim_set_time_limit(uint64_t ns, void (*fn)(void));
+
+/* ---------------------------------------------------------------------------
+ * GPIO: line levels seen by external models.
+ * ------------------------------------------------------------------------- */
+bool sim_gpio_is_output(char bank, uint8_t pin);
+// The MCU itself pulls the pin low (output mode, ODR bit clear).
+bool sim_gpio_driven_low(char bank, uint8_t pin);
+// Level of the wire: MCU output (wired-AND with external pull-down) or external drive.
+bool sim_gpio_line(char bank, uint8_t pin);
+// External device drives (or releases, level = 1 with pull-up) the pin.
+void sim_gpio_set_external(char bank, uint8_t pin, bool level);
+
+/* ---------------------------------------------------------------------------
+ * SPI1 (CMSIS Driver_SPI1 stand-in)
+ * ------------------------------------------------------------------------- */
+// Fixed cost of starting one Send() (driver + DMA setup), default 2 us.
+void sim_spi_set_setup_ns(uint32_t ns);
+uint32_t sim_spi_get_bus_hz(void);
+
+typedef struct {
+    uint32_t transfers;
+    uint64_t bytes;
+    uint64_t busy_ns;        // Time the bus was shifting or being set up.
+} sim_spi_stats_t;
+void sim_spi_get_stats(sim_spi_stats_t *stats);
+void sim_spi_reset_stats(void);
+
+/* ---------------------------------------------------------------------------
+ * USART1 (CMSIS Driver_USART1 stand-in)
+ * ------------------------------------------------------------------------- */
+// Where transmitted bytes go, stdout by default, NULL to discard.
+void sim_usart_set_output(FILE *out);
+// Bytes arriving on RX; delivered at the configured baud rate.
+void sim_usart_inject(const void *data, uint32_t len);
+
+/* ---------------------------------------------------------------------------
+ * ADC1
+ * ------------------------------------------------------------------------- */
+typedef uint16_t (*sim_adc_source_t)(uint8_t ch, uint64_t t_ns, void *ctx);
+void sim_adc_set_value(uint8_t ch, uint16_t value);
+void sim_adc_set_source(uint8_t ch, sim_adc_source_t source, void *ctx);
+
+/* ---------------------------------------------------------------------------
+ * DHT11 on PC4 (sensor 0) and further DHT11/DHT22 sensors
+ * ------------------------------------------------------------------------- */
+void sim_dht11_set(uint8_t humidity, uint8_t temp, uint8_t temp_dec);
+// Make the next `count` transfers fail: no response or a corrupted checksum.
+void sim_dht11_fail_response(uint32_t count);
+void sim_dht11_fail_checksum(uint32_t count);
+
+// Add a sensor on another pin; returns its id, -1 if there are too many.
+int sim_dht_attach(char bank, uint8_t pin, bool dht22);
+void sim_dht_set(int id, int16_t humidity_x10, int16_t temp_x10);
+void sim_dht_fail_response(int id, uint32_t count);
+void sim_dht_fail_checksum(int id, uint32_t count);
+
+/* ---------------------------------------------------------------------------
+ * ST7789 panel on SPI1 (CS PE1, DC PE0, RST PE3)
+ * ------------------------------------------------------------------------- */
+#define SIM_ST7789_WIDTH   240
+#define SIM_ST7789_HEIGHT  320
+
+typedef struct {
+    uint32_t commands;
+    uint32_t ramwr;
+    uint64_t pixels;
+    uint32_t unknown_commands;
+} sim_st7789_stats_t;
+
+const uint16_t *sim_st7789_framebuffer(void);
+void sim_st7789_get_stats(sim_st7789_stats_t *stats);
+void sim_st7789_reset_stats(void);
+bool sim_st7789_display_on(void);
+// Dump the panel GRAM as an 8-bit RGB PNG. Return 0 on success.
+int sim_st7789_dump_png(const char *path);
+
+/* ---------------------------------------------------------------------------
+ * PNG writer
+ * ------------------------------------------------------------------------- */
+int sim_png_write_rgb565(const char *path, const uint16_t *pixels,
+                         uint32_t width, uint32_t height);
+
+/* ---------------------------------------------------------------------------
+ * Internal: model hooks driven by the clock.
+ * ------------------------------------------------------------------------- */
+#define SIM_NO_EVENT UINT64_MAX
+
+bool sim_nvic_enabled(int irqn);
+// Enabled and pended by NVIC_SetPendingIRQ(); take clears it for delivery.
+bool sim_nvic_any_pending(void);
+bool sim_nvic_pending(int irqn);
+bool sim_nvic_take_pending(int irqn);
+void sim_timer_reset(void);
+void sim_timer_service(uint64_t now);
+uint64_t sim_timer_next_event(uint64_t now);
+void sim_spi_service(uint64_t now);
+uint64_t sim_spi_next_event(void);
+void sim_usart_service(uint64_t now);
+uint64_t sim_usart_next_event(void);
+void sim_adc_reset(void);
+// External trigger `extsel` (ADC_CR2_EXTSEL code) fired at `at_ns`.
+void sim_adc_ext_trigger(uint8_t extsel, uint64_t at_ns);
+// The trigger is selected and the group it starts next raises an interrupt.
+bool sim_adc_ext_trigger_wakes(uint8_t extsel);
+// Same for the injected group (ADC_CR2_JEXTSEL code).
+void sim_adc_jext_trigger(uint8_t jextsel, uint64_t at_ns);
+bool sim_adc_jext_trigger_wakes(uint8_t jextsel);
+void sim_adc_service(uint64_t now);
+uint64_t sim_adc_next_event(uint64_t now);
+void sim_dma_reset(void);
+// A peripheral asks DMA1 `channel` (1..7) for one transfer; false if it is off.
+bool sim_dma_request(uint8_t channel);
+// Transfers until the channel raises a flag whose interrupt can reach the
+// core (this transfer counts as 1), 0 if it never will.
+uint32_t sim_dma_requests_to_irq(uint8_t channel);
+void sim_dma_service(void);
+uint64_t sim_dma_next_event(uint64_t now);
+void sim_exti_reset(void);
+// GPIO input levels of bank `bank` (0 = A) changed from `before` to `after`.
+void sim_exti_gpio_changed(uint8_t bank, uint16_t before, uint16_t after);
+void sim_exti_service(void);
+uint64_t sim_exti_next_event(uint64_t now);
+void sim_dht11_service(uint64_t now);
+uint64_t sim_dht11_next_event(void);
+void sim_st7789_receive(const uint8_t *data, uint32_t len, bool dc);
+void sim_st7789_service(void);
+
+#endif /* HOST_SIM_H */
@@ -0,0 +1,366 @@
+#include "sim.h"
+#include "sim_mmio.h"
+#include "stm32f10x.h"
+#include <stddef.h>
+#include <string.h>
+
+/* ADC1 regular group. Writing ADON while it is already set (and nothing else
+ * in CR2 changes), SWSTART with EXTSEL = SWSTART, or the selected external
+ * trigger with EXTTRIG starts the group; a trigger that arrives while the
+ * group is still being converted is ignored, like on the device. Each
+ * conversion takes (sample time + 12.5) ADC clocks, loads DR and, with
+ * CR2.DMA, asks DMA1 channel 1 to move it. The group is SQR3..SQR1 with SCAN,
+ * otherwise only its first channel; EOC is set when the group is done, and
+ * CONT starts it again right away. The analog watchdog (AWDEN, one channel
+ * with AWDSGL) sets AWD when a conversion leaves [LTR, HTR]; AWD with AWDIE
+ * and EOC with EOCIE raise ADC1_2_IRQn while set. Calibration completes
+ * immediately.
+ *
+ * The injected group is the last JL + 1 channels of JSQR (all of them only
+ * with SCAN, like the regular group), results in JDR1..; JSWSTART with
+ * JEXTSEL = JSWSTART or the selected external trigger with JEXTTRIG starts
+ * it. It preempts the regular conversion in progress, which is converted
+ * again from its start once the injected group is done. JEOC with JEOCIE
+ * raises ADC1_2_IRQn. */
+
+#define ADC_CHANNELS 18
+
+uint8_t *sim_adc_mem;
+static uint8_t *adc_view;
+static uint32_t sr;             // flags raised and not yet cleared
+static uint32_t cr2;            // CR2 as of the previous store
+
+static const uint16_t sample_cycles_x2[8] = { 3, 15, 27, 57, 83, 111, 143, 479 };
+
+static uint16_t values[ADC_CHANNELS];
+static sim_adc_source_t sources[ADC_CHANNELS];
+static void *source_ctx[ADC_CHANNELS];
+
+static bool running;            // a regular group is being converted
+static uint8_t seq_pos;         // its conversion in progress
+static uint64_t done_at = SIM_NO_EVENT;
+
+static bool jrunning;           // the injected group is being converted
+static uint8_t jpos;
+static uint64_t jdone_at = SIM_NO_EVENT;
+
+__attribute__((weak)) void ADC1_2_IRQHandler(void) {}
+
+static ADC_TypeDef *adc(void) {
+    return (ADC_TypeDef *)adc_view;
+}
+
+void sim_adc_set_value(uint8_t ch, uint16_t value) {
+    if (ch >= ADC_CHANNELS) return;
+    values[ch] = value & 0xFFF;
+    sources[ch] = NULL;
+}
+
+void sim_adc_set_source(uint8_t ch, sim_adc_source_t source, void *ctx) {
+    if (ch >= ADC_CHANNELS) return;
+    sources[ch] = source;
+    source_ctx[ch] = ctx;
+}
+
+static uint16_t sample(uint8_t ch, uint64_t now) {
+    if (sources[ch]) return sources[ch](ch, now, source_ctx[ch]) & 0xFFF;
+    return values[ch];
+}
+
+static void set_sr(uint32_t flags) {
+    sr |= flags;
+    adc()->SR = sr;
+}
+
+static uint8_t group_length(void) {
+    if (!(adc()->CR1 & ADC_CR1_SCAN)) return 1;
+    return ((adc()->SQR1 & ADC_SQR1_L) >> 20) + 1;
+}
+
+// Channel of the regular group at `pos`: SQ1..SQ6 in SQR3, SQ7..SQ12 in SQR2,
+// SQ13..SQ16 in SQR1, five bits each
+static uint8_t group_channel(uint8_t pos) {
+    const volatile uint32_t *sqr = pos < 6 ? &adc()->SQR3 : pos < 12 ? &adc()->SQR2 : &adc()->SQR1;
+    uint8_t ch = (*sqr >> ((pos % 6) * 5)) & 0x1F;
+    return ch < ADC_CHANNELS ? ch : 0;
+}
+
+static uint64_t conversion_ns(uint8_t ch) {
+    uint32_t smp = ch < 10 ? (adc()->SMPR2 >> (ch * 3)) & 0x7 : (adc()->SMPR1 >> ((ch - 10) * 3)) & 0x7;
+    uint32_t prescaler = 2 + 2 * ((RCC->CFGR & RCC_CFGR_ADCPRE) >> 14);
+    uint32_t adc_hz = SIM_CPU_HZ / prescaler;
+    // (sample time + 12.5 cycles) * 2 to stay in integers
+    return (uint64_t)(sample_cycles_x2[smp] + 25) * 1000000000ull / adc_hz / 2;
+}
+
+
+static uint8_t jgroup_length(void) {
+    if (!(adc()->CR1 & ADC_CR1_SCAN)) return 1;
+    return ((adc()->JSQR & ADC_JSQR_JL) >> 20) + 1;
+}
+
+// JL + 1 conversions take JSQ(4 - JL)..JSQ4
+static uint8_t jgroup_channel(uint8_t pos) {
+    uint8_t slot = 4 - (((adc()->JSQR & ADC_JSQR_JL) >> 20) + 1) + pos;
+    uint8_t ch = (adc()->JSQR >> (slot * 5)) & 0x1F;
+    return ch < ADC_CHANNELS ? ch : 0;
+}
+
+// End of the injected group in progress
+static uint64_t jgroup_end(void) {
+    uint64_t at = jdone_at;
+    for (uint8_t pos = jpos + 1; pos < jgroup_length(); ++pos) at += conversion_ns(jgroup_channel(pos));
+    return at;
+}
+
+static void convert(uint64_t now);
+
+static void start_group(uint64_t now) {
+    running = true;
+    seq_pos = 0;
+    set_sr(ADC_SR_STRT);
+    // Waits for the injected group in progress
+    done_at = (jrunning ? jgroup_end() : now) + conversion_ns(group_channel(0));
+}
+
+static void start_injected(uint64_t now) {
+    convert(now);
+    if (jrunning) return;
+    jrunning = true;
+    jpos = 0;
+    set_sr(ADC_SR_JSTRT);
+    jdone_at = now + conversion_ns(jgroup_channel(0));
+    // The regular conversion in progress starts over afterwards
+    if (running) done_at = jgroup_end() + conversion_ns(group_channel(seq_pos));
+}
+
+// Firmware stores: SR bits are cleared by writing 0 (rc_w0); CR2 starts,
+// stops and triggers conversions.
+static void on_adc_write(size_t offset) {
+    ADC_TypeDef *a = adc();
+    if (offset == offsetof(ADC_TypeDef, SR)) {
+        sr &= a->SR;
+        a->SR = sr;
+    } else if (offset == offsetof(ADC_TypeDef, CR2)) {
+        uint32_t prev = cr2;
+        cr2 = a->CR2;
+        if (!(cr2 & ADC_CR2_ADON)) {
+            running = false;
+            done_at = SIM_NO_EVENT;
+            jrunning = false;
+            jdone_at = SIM_NO_EVENT;
+            return;
+        }
+        if ((cr2 & ADC_CR2_JSWSTART) && (cr2 & ADC_CR2_JEXTTRIG) &&
+            (cr2 & ADC_CR2_JEXTSEL) == ADC_CR2_JEXTSEL) {
+            a->CR2 = cr2 &= ~ADC_CR2_JSWSTART;
+            start_injected(sim_time_ns());
+        } else if ((prev & ADC_CR2_ADON) && prev == cr2) {
+            start_group(sim_time_ns());
+        } else if ((cr2 & ADC_CR2_SWSTART) && (cr2 & ADC_CR2_EXTTRIG) &&
+                   (cr2 & ADC_CR2_EXTSEL) == ADC_CR2_EXTSEL) {
+            a->CR2 = cr2 &= ~ADC_CR2_SWSTART;
+            start_group(sim_time_ns());
+        }
+    }
+}
+
+__attribute__((constructor)) static void adc_create(void) {
+    void *view;
+    sim_adc_mem = sim_mmio_create(sizeof(ADC_TypeDef), &view, on_adc_write);
+    adc_view = view;
+}
+
+void sim_adc_reset(void) {
+    memset(adc_view, 0, sizeof(ADC_TypeDef));
+    sr = 0;
+    cr2 = 0;
+    running = false;
+    done_at = SIM_NO_EVENT;
+    jrunning = false;
+    jdone_at = SIM_NO_EVENT;
+}
+
+static bool awd_guards(uint8_t ch) {
+    uint32_t cr1 = adc()->CR1;
+    return (cr1 & ADC_CR1_AWDEN) && (!(cr1 & ADC_CR1_AWDSGL) || (cr1 & ADC_CR1_AWDCH) == ch);
+}
+
+static bool awd_outside(uint16_t value) {
+    return value > (adc()->HTR & 0xFFF) || value < (adc()->LTR & 0xFFF);
+}
+
+// The watchdog interrupt can fire: a guarded channel of the group has a
+// waveform, or a fixed value outside the window
+static bool awd_may_fire(void) {
+    if (!(adc()->CR1 & ADC_CR1_AWDIE) || !sim_nvic_enabled(ADC1_2_IRQn)) return false;
+    for (uint8_t pos = 0; pos < group_length(); ++pos) {
+        uint8_t ch = group_channel(pos);
+        if (awd_guards(ch) && (sources[ch] != NULL || awd_outside(values[ch]))) return true;
+    }
+    return false;
+}
+
+static bool irq_asserted(void) {
+    uint32_t cr1 = adc()->CR1;
+    return (((sr & ADC_SR_AWD) && (cr1 & ADC_CR1_AWDIE)) ||
+            ((sr & ADC_SR_EOC) && (cr1 & ADC_CR1_EOCIE)) ||
+            ((sr & ADC_SR_JEOC) && (cr1 & ADC_CR1_JEOCIE))) &&
+           sim_nvic_enabled(ADC1_2_IRQn);
+}
+
+// Conversions until one raises an interrupt, the one in progress (or the
+// first of the next group when idle) counting as 1; 0 if none will
+static uint32_t conversions_to_irq(void) {
+    uint32_t n = 0;
+    if (awd_may_fire()) return 1;
+    if (adc()->CR1 & ADC_CR1_EOCIE) n = group_length() - (running ? seq_pos : 0);
+    if (adc()->CR2 & ADC_CR2_DMA) {
+        uint32_t d = sim_dma_requests_to_irq(1);
+        if (d != 0 && (n == 0 || d < n)) n = d;
+    }
+    return n;
+}
+
+static bool ext_selected(uint8_t extsel) {
+    uint32_t cr = adc()->CR2;
+    return (cr & ADC_CR2_ADON) && (cr & ADC_CR2_EXTTRIG) &&
+           ((cr & ADC_CR2_EXTSEL) >> 17) == extsel;
+}
+
+void sim_adc_ext_trigger(uint8_t extsel, uint64_t at_ns) {
+    if (!ext_selected(extsel)) return;
+    // Finish what was due before the trigger (the clock may be catching up)
+    sim_adc_service(at_ns);
+    if (!running) start_group(at_ns);
+}
+
+static bool jext_selected(uint8_t jextsel) {
+    uint32_t cr = adc()->CR2;
+    return (cr & ADC_CR2_ADON) && (cr & ADC_CR2_JEXTTRIG) &&
+           ((cr & ADC_CR2_JEXTSEL) >> 12) == jextsel;
+}
+
+static bool jext_timed(void) {
+    for (uint8_t code = 0; code < 7; ++code) {
+        if (jext_selected(code)) return true;
+    }
+    return false;
+}
+
+bool sim_adc_ext_trigger_wakes(uint8_t extsel) {
+    if (!ext_selected(extsel)) return false;
+    // With a second timer on the injected group, both have to come in order
+    // or a late regular trigger would miss the preemption
+    if (jext_timed()) return true;
+    uint32_t k = conversions_to_irq();
+    uint32_t length = group_length();
+    if (running) {
+        // Raised by the group in progress: sim_adc_next_event() has it
+        uint32_t rest = length - seq_pos;
+        if (k <= rest) return false;
+        k -= rest;
+    }
+    return k != 0 && k <= length;
+}
+
+void sim_adc_jext_trigger(uint8_t jextsel, uint64_t at_ns) {
+    if (!jext_selected(jextsel)) return;
+    start_injected(at_ns);
+}
+
+bool sim_adc_jext_trigger_wakes(uint8_t jextsel) {
+    return jext_selected(jextsel) && (adc()->CR1 & ADC_CR1_JEOCIE) && sim_nvic_enabled(ADC1_2_IRQn);
+}
+
+// Regular conversion that raises an interrupt, see sim_adc_next_event()
+static uint64_t regular_next_event(void) {
+    if (!running) return SIM_NO_EVENT;
+    uint32_t k = conversions_to_irq();
+    if (k == 0) return SIM_NO_EVENT;
+
+    uint8_t length = group_length();
+    bool cont = (adc()->CR2 & ADC_CR2_CONT) != 0;
+    uint8_t pos = seq_pos;
+    uint64_t at = done_at;
+    while (--k > 0) {
+        if (++pos == length) {
+            if (!cont) return SIM_NO_EVENT;
+            pos = 0;
+            if (k > length) {
+                // Skip whole groups at once
+                uint64_t group = 0;
+                for (uint8_t i = 0; i < length; ++i) group += conversion_ns(group_channel(i));
+                uint32_t groups = (k - 1) / length;
+                at += groups * group;
+                k -= groups * length;
+            }
+        }
+        at += conversion_ns(group_channel(pos));
+    }
+    return at;
+}
+
+// Only the conversion that raises an interrupt is a clock event; the others
+// are caught up, each with its own sample time, whenever the clock next
+// moves. So DMA into memory neither wakes a sleeping core nor slows the
+// simulation, and an external trigger only wakes it for the group that ends
+// in an interrupt.
+uint64_t sim_adc_next_event(uint64_t now) {
+    if (irq_asserted()) return now;
+    uint64_t at = regular_next_event();
+    if (jrunning && (adc()->CR1 & ADC_CR1_JEOCIE) && sim_nvic_enabled(ADC1_2_IRQn)) {
+        uint64_t end = jgroup_end();
+        if (end < at) at = end;
+    }
+    return at;
+}
+
+static void convert_injected(void) {
+    ADC_TypeDef *a = adc();
+    volatile uint32_t *jdr = &a->JDR1;
+    jdr[jpos] = sample(jgroup_channel(jpos), jdone_at);
+    if (++jpos >= jgroup_length()) {
+        jrunning = false;
+        jdone_at = SIM_NO_EVENT;
+        set_sr(ADC_SR_JEOC);
+    } else {
+        jdone_at += conversion_ns(jgroup_channel(jpos));
+    }
+}
+
+// Conversions due by `now`, in order
+static void convert(uint64_t now) {
+    ADC_TypeDef *a = adc();
+    for (;;) {
+        if (jrunning && jdone_at <= now && jdone_at <= done_at) {
+            convert_injected();
+            continue;
+        }
+        if (!running || now < done_at) break;
+        uint8_t length = group_length();
+        uint8_t ch = group_channel(seq_pos);
+        a->DR = sample(ch, done_at);
+        if (awd_guards(ch) && awd_outside(a->DR)) set_sr(ADC_SR_AWD);
+        // The DMA read of DR is what clears EOC on the device
+        bool moved = (a->CR2 & ADC_CR2_DMA) && sim_dma_request(1);
+
+        if (++seq_pos >= length) {
+            seq_pos = 0;
+            if (!moved) set_sr(ADC_SR_EOC);
+            if (!(a->CR2 & ADC_CR2_CONT)) {
+                running = false;
+                done_at = SIM_NO_EVENT;
+                continue;
+            }
+        }
+        done_at += conversion_ns(group_channel(seq_pos));
+    }
+}
+
+void sim_adc_service(uint64_t now) {
+    ADC_TypeDef *a = adc();
+    if (a->CR2 & ADC_CR2_CAL) a->CR2 = cr2 = a->CR2 & ~(ADC_CR2_CAL | ADC_CR2_RSTCAL);
+    convert(now);
+    if (irq_asserted()) ADC1_2_IRQHandler();
+}
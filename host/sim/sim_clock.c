@@ -0,0 +1,192 @@
+#include "sim.h"
+#include "stm32f10x.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Virtual clock: every model is serviced in time order. */
+
+#define NS_PER_MS 1000000ull
+
+RCC_TypeDef sim_rcc;
+// Interrupts are taken as soon as they are raised, so ICSR never shows one pending.
+SCB_Type sim_scb;
+DWT_Type sim_dwt;
+CoreDebug_Type sim_coredebug;
+
+static uint64_t now_ns;
+static sim_cpu_stats_t cpu_stats;
+
+static uint64_t cyccnt_base_ns;
+static uint32_t cyccnt_base;
+static bool cyccnt_running;
+
+static uint64_t limit_ns = SIM_NO_EVENT;
+static void (*limit_fn)(void);
+
+static uint32_t nvic_enabled[2];
+static uint32_t nvic_pending[2];
+static uint8_t nvic_priority[64];
+
+void NVIC_EnableIRQ(IRQn_Type irqn) {
+    if (irqn >= 0) nvic_enabled[irqn >> 5] |= 1u << (irqn & 31);
+}
+
+void NVIC_DisableIRQ(IRQn_Type irqn) {
+    if (irqn >= 0) nvic_enabled[irqn >> 5] &= ~(1u << (irqn & 31));
+}
+
+void NVIC_SetPriority(IRQn_Type irqn, uint32_t priority) {
+    if (irqn >= 0) nvic_priority[irqn] = (uint8_t)priority;
+}
+
+// Peripheral interrupts are delivered as soon as they are raised; only a
+// software-pended one waits for the owning model to take it.
+void NVIC_SetPendingIRQ(IRQn_Type irqn) {
+    if (irqn >= 0) nvic_pending[irqn >> 5] |= 1u << (irqn & 31);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irqn) {
+    if (irqn >= 0) nvic_pending[irqn >> 5] &= ~(1u << (irqn & 31));
+}
+
+bool sim_nvic_enabled(int irqn) {
+    return irqn < 0 || (nvic_enabled[irqn >> 5] & (1u << (irqn & 31)));
+}
+
+bool sim_nvic_any_pending(void) {
+    return (nvic_pending[0] | nvic_pending[1]) != 0;
+}
+
+bool sim_nvic_pending(int irqn) {
+    return irqn >= 0 && sim_nvic_enabled(irqn) &&
+           (nvic_pending[irqn >> 5] & (1u << (irqn & 31)));
+}
+
+bool sim_nvic_take_pending(int irqn) {
+    if (!sim_nvic_pending(irqn)) return false;
+    NVIC_ClearPendingIRQ((IRQn_Type)irqn);
+    return true;
+}
+
+void sim_init(void) {
+    now_ns = 0;
+    memset(&cpu_stats, 0, sizeof(cpu_stats));
+    limit_ns = SIM_NO_EVENT;
+    limit_fn = NULL;
+    sim_timer_reset();
+    sim_exti_reset();
+    sim_adc_reset();
+    sim_dma_reset();
+    memset(&sim_rcc, 0, sizeof(sim_rcc));
+    memset(&sim_dwt, 0, sizeof(sim_dwt));
+    memset(&sim_coredebug, 0, sizeof(sim_coredebug));
+    cyccnt_running = false;
+    memset(nvic_enabled, 0, sizeof(nvic_enabled));
+    memset(nvic_pending, 0, sizeof(nvic_pending));
+}
+
+uint64_t sim_time_ns(void) {
+    return now_ns;
+}
+
+void sim_set_time_limit(uint64_t ns, void (*fn)(void)) {
+    limit_ns = ns;
+    limit_fn = fn;
+}
+
+// DWT->CYCCNT follows the virtual clock at the core frequency. CPU work itself
+// takes no virtual time, so profiles show where the firmware waits.
+static void dwt_service(uint64_t now) {
+    bool enabled = (CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) &&
+                   (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk);
+    if (!enabled) {
+        cyccnt_running = false;
+        return;
+    }
+    if (!cyccnt_running) {
+        cyccnt_running = true;
+        cyccnt_base_ns = now;
+        cyccnt_base = DWT->CYCCNT;
+    }
+    DWT->CYCCNT = cyccnt_base + (uint32_t)((now - cyccnt_base_ns) * SIM_CPU_MHZ / 1000);
+}
+
+static void service_all(void) {
+    dwt_service(now_ns);
+    sim_timer_service(now_ns);
+    sim_dht11_service(now_ns);
+    sim_adc_service(now_ns);
+    sim_dma_service();
+    sim_spi_service(now_ns);
+    sim_usart_service(now_ns);
+    sim_st7789_service();
+    sim_exti_service();
+}
+
+static uint64_t next_event(void) {
+    uint64_t next = sim_timer_next_event(now_ns);
+    uint64_t e;
+    if ((e = sim_spi_next_event()) < next) next = e;
+    if ((e = sim_usart_next_event()) < next) next = e;
+    if ((e = sim_adc_next_event(now_ns)) < next) next = e;
+    if ((e = sim_dma_next_event(now_ns)) < next) next = e;
+    if ((e = sim_dht11_next_event()) < next) next = e;
+    if ((e = sim_exti_next_event(now_ns)) < next) next = e;
+    if (limit_ns < next) next = limit_ns;
+    return next;
+}
+
+void sim_advance_ns(uint64_t ns) {
+    uint64_t target = now_ns + ns;
+
+    do {
+        uint64_t next = next_event();
+        if (next > target) next = target;
+        if (next > now_ns) now_ns = next;
+        service_all();
+
+        if (now_ns >= limit_ns && limit_fn != NULL) {
+            void (*fn)(void) = limit_fn;
+            limit_fn = NULL;
+            limit_ns = SIM_NO_EVENT;
+            fn();
+        }
+    } while (now_ns < target);
+}
+
+void sim_advance_us(uint32_t us) {
+    sim_advance_ns((uint64_t)us * 1000);
+}
+
+void sim_advance_ms(uint32_t ms) {
+    sim_advance_ns((uint64_t)ms * NS_PER_MS);
+}
+
+void sim_spin(void) {
+    sim_advance_ns(SIM_SPIN_NS);
+}
+
+void sim_idle(void) {
+    uint64_t next = next_event();
+    if (next == SIM_NO_EVENT) {
+        fprintf(stderr, "sim: idle at %llu ns with no wakeup source\n",
+                (unsigned long long)now_ns);
+        abort();
+    }
+    sim_advance_ns(next > now_ns ? next - now_ns : SIM_SPIN_NS);
+}
+
+void sim_wfi(void) {
+    uint64_t start = now_ns;
+    sim_idle();
+    cpu_stats.wfi += 1;
+    cpu_stats.sleep_ns += now_ns - start;
+}
+
+void sim_cpu_get_stats(sim_cpu_stats_t *stats) {
+    *stats = cpu_stats;
+}
+
+void sim_cpu_reset_stats(void) {
+    memset(&cpu_stats, 0, sizeof(cpu_stats));
+}
@@ -0,0 +1,147 @@
+#include "sim.h"
+
+/* DHT11 / DHT22 sensors; sensor 0 is the DHT11 on PC4. The host pulls the
+ * line low (>= 18 ms for a DHT11, >= 1 ms for a DHT22) and releases it; the
+ * sensor answers 30 us later with 80 us low / 80 us high, then 40 bits of
+ * 50 us low followed by 26 us (0) or 70 us (1) high, then a 50 us low stop.
+ * The answer is precomputed as a list of edges and replayed on the wire. */
+
+#define MAX_SENSORS         4
+#define DHT11_START_MIN_NS  18000000ull
+#define DHT22_START_MIN_NS  1000000ull
+#define MAX_EDGES           (2 + 2 + 80 + 2)
+
+typedef struct {
+    char bank;
+    uint8_t pin;
+    bool dht22;
+    int16_t humidity_x10;
+    int16_t temp_x10;
+    uint32_t fail_response;
+    uint32_t fail_checksum;
+
+    bool host_low;
+    uint64_t host_low_since;
+
+    uint64_t edge_at[MAX_EDGES];
+    bool edge_level[MAX_EDGES];
+    uint32_t edge_count;
+    uint32_t edge_pos;
+} sim_dht_t;
+
+static sim_dht_t sensors[MAX_SENSORS] = {
+    { .bank = 'C', .pin = 4, .humidity_x10 = 550, .temp_x10 = 243 },
+};
+static uint32_t sensor_count = 1;
+
+int sim_dht_attach(char bank, uint8_t pin, bool dht22) {
+    if (sensor_count == MAX_SENSORS) return -1;
+    sim_dht_t *s = &sensors[sensor_count];
+    *s = (sim_dht_t){ .bank = bank, .pin = pin, .dht22 = dht22, .humidity_x10 = 500, .temp_x10 = 200 };
+    return (int)sensor_count++;
+}
+
+void sim_dht_set(int id, int16_t humidity_x10, int16_t temp_x10) {
+    sensors[id].humidity_x10 = humidity_x10;
+    sensors[id].temp_x10 = temp_x10;
+}
+
+void sim_dht_fail_response(int id, uint32_t count) {
+    sensors[id].fail_response = count;
+}
+
+void sim_dht_fail_checksum(int id, uint32_t count) {
+    sensors[id].fail_checksum = count;
+}
+
+void sim_dht11_set(uint8_t h, uint8_t t, uint8_t t_dec) {
+    sim_dht_set(0, h * 10, t * 10 + t_dec);
+}
+
+void sim_dht11_fail_response(uint32_t count) {
+    sim_dht_fail_response(0, count);
+}
+
+void sim_dht11_fail_checksum(uint32_t count) {
+    sim_dht_fail_checksum(0, count);
+}
+
+static void push_edge(sim_dht_t *s, uint64_t *t, uint32_t duration_us, bool level) {
+    s->edge_at[s->edge_count] = *t;
+    s->edge_level[s->edge_count] = level;
+    ++s->edge_count;
+    *t += (uint64_t)duration_us * 1000;
+}
+
+static void start_response(sim_dht_t *s, uint64_t now) {
+    uint8_t frame[5];
+    uint16_t t = s->temp_x10 < 0 ? -s->temp_x10 : s->temp_x10;
+    if (s->dht22) {
+        frame[0] = (uint8_t)(s->humidity_x10 >> 8);
+        frame[1] = (uint8_t)s->humidity_x10;
+        frame[2] = (uint8_t)(t >> 8) | (s->temp_x10 < 0 ? 0x80 : 0);
+        frame[3] = (uint8_t)t;
+    } else {
+        frame[0] = (uint8_t)(s->humidity_x10 / 10);
+        frame[1] = 0;
+        frame[2] = (uint8_t)(t / 10);
+        frame[3] = (uint8_t)(t % 10) | (s->temp_x10 < 0 ? 0x80 : 0);
+    }
+    frame[4] = frame[0] + frame[1] + frame[2] + frame[3];
+    if (s->fail_checksum) {
+        --s->fail_checksum;
+        frame[4] ^= 0x01;
+    }
+
+    uint64_t at = now + 30000;
+    s->edge_count = 0;
+    s->edge_pos = 0;
+    push_edge(s, &at, 80, false);
+    push_edge(s, &at, 80, true);
+    for (uint8_t i = 0; i < 40; ++i) {
+        bool bit = (frame[i / 8] >> (7 - (i % 8))) & 1;
+        push_edge(s, &at, 50, false);
+        push_edge(s, &at, bit ? 70 : 26, true);
+    }
+    push_edge(s, &at, 50, false);
+    push_edge(s, &at, 0, true);
+}
+
+uint64_t sim_dht11_next_event(void) {
+    uint64_t next = SIM_NO_EVENT;
+    for (uint32_t i = 0; i < sensor_count; ++i) {
+        sim_dht_t *s = &sensors[i];
+        if (s->edge_pos < s->edge_count && s->edge_at[s->edge_pos] < next) {
+            next = s->edge_at[s->edge_pos];
+        }
+    }
+    return next;
+}
+
+static void service_one(sim_dht_t *s, uint64_t now) {
+    bool mcu_low = sim_gpio_driven_low(s->bank, s->pin);
+
+    if (mcu_low && !s->host_low) {
+        s->host_low = true;
+        s->host_low_since = now;
+        // A new start signal aborts any answer in flight.
+        s->edge_pos = s->edge_count = 0;
+        sim_gpio_set_external(s->bank, s->pin, true);
+    } else if (!mcu_low && s->host_low) {
+        s->host_low = false;
+        uint64_t start_min = s->dht22 ? DHT22_START_MIN_NS : DHT11_START_MIN_NS;
+        if (now - s->host_low_since >= start_min) {
+            if (s->fail_response) --s->fail_response;
+            else start_response(s, now);
+        }
+    }
+
+    while (s->edge_pos < s->edge_count && s->edge_at[s->edge_pos] <= now) {
+        sim_gpio_set_external(s->bank, s->pin, s->edge_level[s->edge_pos]);
+        ++s->edge_pos;
+    }
+}
+
+void sim_dht11_service(uint64_t now) {
+    for (uint32_t i = 0; i < sensor_count; ++i) service_one(&sensors[i], now);
+}
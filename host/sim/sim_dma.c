@@ -0,0 +1,201 @@
+#include "sim.h"
+#include "sim_mmio.h"
+#include "stm32f10x.h"
+#include <stddef.h>
+#include <string.h>
+
+/* DMA1 channels 1..7. A peripheral model asks for one transfer with
+ * sim_dma_request(); an enabled channel with CNDTR > 0 then moves one item
+ * between CPAR and CMAR (host pointers), counts CNDTR down, raises HTIF at
+ * the half and TCIF at the end, and reloads in circular mode. Like on the
+ * device, the channel's interrupt stays asserted while a flag and its enable
+ * bit are both set. */
+
+uint8_t *sim_dma_mem;
+static uint8_t *dma_view;
+static uint32_t isr;        // flags raised and not yet cleared
+static uint32_t ie;         // TCIE/HTIE/TEIE of every channel, laid out like ISR
+
+typedef struct {
+    bool enabled;
+    uint32_t reload;        // CNDTR when the channel was enabled
+    uint32_t remaining;
+    uint32_t index;         // items moved since the (re)load
+} sim_dma_ch_t;
+
+static sim_dma_ch_t channels[SIM_DMA_CHANNELS];
+
+__attribute__((weak)) void DMA1_Channel1_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Channel2_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Channel3_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Channel4_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Channel5_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Channel6_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Channel7_IRQHandler(void) {}
+
+static void (*const handlers[SIM_DMA_CHANNELS])(void) = {
+    DMA1_Channel1_IRQHandler, DMA1_Channel2_IRQHandler, DMA1_Channel3_IRQHandler,
+    DMA1_Channel4_IRQHandler, DMA1_Channel5_IRQHandler, DMA1_Channel6_IRQHandler,
+    DMA1_Channel7_IRQHandler,
+};
+
+static DMA_TypeDef *dma(void) {
+    return (DMA_TypeDef *)dma_view;
+}
+
+static DMA_Channel_TypeDef *regs(uint8_t i) {
+    return (DMA_Channel_TypeDef *)(dma_view + sizeof(DMA_TypeDef)) + i;
+}
+
+static void set_isr(uint32_t value) {
+    // GIFx is the OR of the other three flags of the channel
+    for (uint8_t i = 0; i < SIM_DMA_CHANNELS; ++i) {
+        uint32_t shift = i * 4;
+        if ((value >> shift) & 0xE) value |= 1u << shift;
+        else value &= ~(1u << shift);
+    }
+    isr = value;
+    dma()->ISR = isr;
+}
+
+// Firmware stores: IFCR bits clear their ISR flags (CGIFx all four), CNDTR
+// is read-only while the channel is enabled, and EN 0 -> 1 loads the counter.
+static void on_dma_write(size_t offset) {
+    if (offset == offsetof(DMA_TypeDef, IFCR)) {
+        uint32_t clear = dma()->IFCR;
+        for (uint8_t i = 0; i < SIM_DMA_CHANNELS; ++i) {
+            if (clear & (1u << (i * 4))) clear |= 0xFu << (i * 4);
+        }
+        dma()->IFCR = 0;
+        set_isr(isr & ~clear);
+        return;
+    }
+    if (offset == offsetof(DMA_TypeDef, ISR)) {
+        dma()->ISR = isr;
+        return;
+    }
+
+    size_t rel = offset - sizeof(DMA_TypeDef);
+    uint8_t i = rel / sizeof(DMA_Channel_TypeDef);
+    if (i >= SIM_DMA_CHANNELS) return;
+    sim_dma_ch_t *ch = &channels[i];
+    DMA_Channel_TypeDef *r = regs(i);
+
+    switch (rel % sizeof(DMA_Channel_TypeDef)) {
+    case offsetof(DMA_Channel_TypeDef, CCR):
+        ie &= ~(0xEu << (i * 4));
+        ie |= (r->CCR & (DMA_CCR1_TCIE | DMA_CCR1_HTIE | DMA_CCR1_TEIE)) << (i * 4);
+        if ((r->CCR & DMA_CCR1_EN) && !ch->enabled) {
+            ch->enabled = true;
+            ch->reload = ch->remaining = r->CNDTR & 0xFFFF;
+            ch->index = 0;
+        } else if (!(r->CCR & DMA_CCR1_EN)) {
+            ch->enabled = false;
+        }
+        break;
+    case offsetof(DMA_Channel_TypeDef, CNDTR):
+        if (ch->enabled) r->CNDTR = ch->remaining;
+        break;
+    }
+}
+
+__attribute__((constructor)) static void dma_create(void) {
+    void *view;
+    sim_dma_mem = sim_mmio_create(sizeof(DMA_TypeDef) +
+                                  SIM_DMA_CHANNELS * sizeof(DMA_Channel_TypeDef),
+                                  &view, on_dma_write);
+    dma_view = view;
+}
+
+void sim_dma_reset(void) {
+    memset(dma_view, 0, sizeof(DMA_TypeDef) + SIM_DMA_CHANNELS * sizeof(DMA_Channel_TypeDef));
+    memset(channels, 0, sizeof(channels));
+    isr = 0;
+    ie = 0;
+}
+
+static uint32_t read_item(uintptr_t addr, uint32_t size) {
+    switch (size) {
+    case 1: return *(volatile uint8_t *)addr;
+    case 2: return *(volatile uint16_t *)addr;
+    default: return *(volatile uint32_t *)addr;
+    }
+}
+
+static void write_item(uintptr_t addr, uint32_t size, uint32_t value) {
+    switch (size) {
+    case 1: *(volatile uint8_t *)addr = (uint8_t)value; break;
+    case 2: *(volatile uint16_t *)addr = (uint16_t)value; break;
+    default: *(volatile uint32_t *)addr = value; break;
+    }
+}
+
+bool sim_dma_request(uint8_t channel) {
+    uint8_t i = channel - 1;
+    sim_dma_ch_t *ch = &channels[i];
+    if (!ch->enabled || ch->remaining == 0) return false;
+
+    DMA_Channel_TypeDef *r = regs(i);
+    uint32_t ccr = r->CCR;
+    uint32_t psize = 1u << ((ccr & DMA_CCR1_PSIZE) >> 8);
+    uint32_t msize = 1u << ((ccr & DMA_CCR1_MSIZE) >> 10);
+    uintptr_t per = r->CPAR + ((ccr & DMA_CCR1_PINC) ? ch->index * psize : 0);
+    uintptr_t mem = r->CMAR + ((ccr & DMA_CCR1_MINC) ? ch->index * msize : 0);
+
+    if (ccr & DMA_CCR1_DIR) write_item(per, psize, read_item(mem, msize));
+    else write_item(mem, msize, read_item(per, psize));
+
+    ++ch->index;
+    --ch->remaining;
+    uint32_t flags = 0;
+    if (ch->remaining == ch->reload / 2) flags |= DMA_ISR_HTIF1;
+    if (ch->remaining == 0) {
+        flags |= DMA_ISR_TCIF1;
+        if (ccr & DMA_CCR1_CIRC) {
+            ch->remaining = ch->reload;
+            ch->index = 0;
+        }
+    }
+    r->CNDTR = ch->remaining;
+    if (flags) set_isr(isr | (flags << (i * 4)));
+    return true;
+}
+
+uint32_t sim_dma_requests_to_irq(uint8_t channel) {
+    uint8_t i = channel - 1;
+    const sim_dma_ch_t *ch = &channels[i];
+    uint32_t enabled = (ie >> (i * 4)) & 0xF;
+    if (!ch->enabled || ch->remaining == 0 || !enabled ||
+        !sim_nvic_enabled(DMA1_Channel1_IRQn + i)) {
+        return 0;
+    }
+
+    uint32_t half = ch->reload / 2;
+    uint32_t next = 0;
+    if (enabled & DMA_ISR_TCIF1) next = ch->remaining;
+    if (enabled & DMA_ISR_HTIF1) {
+        uint32_t ht = 0;
+        if (ch->remaining > half) ht = ch->remaining - half;
+        else if (regs(i)->CCR & DMA_CCR1_CIRC) ht = ch->remaining + ch->reload - half;
+        if (ht != 0 && (next == 0 || ht < next)) next = ht;
+    }
+    return next;
+}
+
+static bool asserted(uint8_t i) {
+    return (((isr & ie) >> (i * 4)) & 0xF) && sim_nvic_enabled(DMA1_Channel1_IRQn + i);
+}
+
+uint64_t sim_dma_next_event(uint64_t now) {
+    if ((isr & ie) == 0) return SIM_NO_EVENT;
+    for (uint8_t i = 0; i < SIM_DMA_CHANNELS; ++i) {
+        if (asserted(i)) return now;
+    }
+    return SIM_NO_EVENT;
+}
+
+void sim_dma_service(void) {
+    for (uint8_t i = 0; (isr & ie) != 0 && i < SIM_DMA_CHANNELS; ++i) {
+        if (asserted(i)) handlers[i]();
+    }
+}
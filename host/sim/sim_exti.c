@@ -0,0 +1,114 @@
+#include "sim.h"
+#include "sim_mmio.h"
+#include "stm32f10x.h"
+#include <stddef.h>
+#include <string.h>
+
+/* EXTI lines 0..15. Every change of a GPIO input level is reported here; the
+ * bank routed to the line by AFIO->EXTICR decides whether it counts. A rising
+ * or falling edge enabled in RTSR/FTSR sets PR, and the interrupt of the line
+ * stays asserted while PR & IMR is set, like the level on the device. */
+
+uint8_t *sim_afio_mem;
+static uint8_t *afio_view;
+static uint16_t pr;         // pending lines not yet cleared by the firmware
+static uint16_t swier;
+
+__attribute__((weak)) void EXTI0_IRQHandler(void) {}
+__attribute__((weak)) void EXTI1_IRQHandler(void) {}
+__attribute__((weak)) void EXTI2_IRQHandler(void) {}
+__attribute__((weak)) void EXTI3_IRQHandler(void) {}
+__attribute__((weak)) void EXTI4_IRQHandler(void) {}
+__attribute__((weak)) void EXTI9_5_IRQHandler(void) {}
+__attribute__((weak)) void EXTI15_10_IRQHandler(void) {}
+
+static const struct {
+    IRQn_Type irq;
+    void (*handler)(void);
+    uint16_t lines;
+} vectors[] = {
+    { EXTI0_IRQn, EXTI0_IRQHandler, 0x0001 },
+    { EXTI1_IRQn, EXTI1_IRQHandler, 0x0002 },
+    { EXTI2_IRQn, EXTI2_IRQHandler, 0x0004 },
+    { EXTI3_IRQn, EXTI3_IRQHandler, 0x0008 },
+    { EXTI4_IRQn, EXTI4_IRQHandler, 0x0010 },
+    { EXTI9_5_IRQn, EXTI9_5_IRQHandler, 0x03E0 },
+    { EXTI15_10_IRQn, EXTI15_10_IRQHandler, 0xFC00 },
+};
+
+#define VECTOR_COUNT (sizeof(vectors) / sizeof(vectors[0]))
+
+static AFIO_TypeDef *afio(void) {
+    return (AFIO_TypeDef *)afio_view;
+}
+
+static EXTI_TypeDef *exti(void) {
+    return (EXTI_TypeDef *)(afio_view + SIM_EXTI_OFFSET);
+}
+
+static void on_exti_write(size_t offset) {
+    EXTI_TypeDef *e = exti();
+    if (offset == SIM_EXTI_OFFSET + offsetof(EXTI_TypeDef, PR)) {
+        // rc_w1: a written 1 clears the pending bit, and SWIER with it
+        uint16_t cleared = pr & (uint16_t)e->PR;
+        pr &= ~cleared;
+        swier &= ~cleared;
+        e->PR = pr;
+        e->SWIER = swier;
+    } else if (offset == SIM_EXTI_OFFSET + offsetof(EXTI_TypeDef, SWIER)) {
+        // A 0 -> 1 transition raises the line; the bit clears with PR
+        uint16_t raised = (uint16_t)e->SWIER & ~swier;
+        pr |= raised & e->IMR;
+        swier = (uint16_t)e->SWIER;
+        e->PR = pr;
+    }
+}
+
+__attribute__((constructor)) static void exti_create(void) {
+    void *view;
+    sim_afio_mem = sim_mmio_create(SIM_EXTI_OFFSET + sizeof(EXTI_TypeDef), &view, on_exti_write);
+    afio_view = view;
+}
+
+void sim_exti_reset(void) {
+    memset(afio(), 0, sizeof(AFIO_TypeDef));
+    memset(exti(), 0, sizeof(EXTI_TypeDef));
+    pr = 0;
+    swier = 0;
+}
+
+void sim_exti_gpio_changed(uint8_t bank, uint16_t before, uint16_t after) {
+    if (afio_view == NULL) return;     // GPIO set up before EXTI exists
+    EXTI_TypeDef *e = exti();
+    uint16_t changed = before ^ after;
+
+    for (uint8_t line = 0; changed != 0; ++line, changed >>= 1) {
+        if (!(changed & 1)) continue;
+        uint32_t port = (afio()->EXTICR[line / 4] >> ((line % 4) * 4)) & 0xF;
+        if (port != bank) continue;
+        bool rising = (after >> line) & 1;
+        if ((rising ? e->RTSR : e->FTSR) & (1u << line)) pr |= 1u << line;
+    }
+    e->PR = pr;
+}
+
+static uint16_t asserted(void) {
+    return pr & (uint16_t)exti()->IMR;
+}
+
+uint64_t sim_exti_next_event(uint64_t now) {
+    uint16_t lines = asserted();
+    for (size_t i = 0; lines != 0 && i < VECTOR_COUNT; ++i) {
+        if ((lines & vectors[i].lines) && sim_nvic_enabled(vectors[i].irq)) return now;
+    }
+    return SIM_NO_EVENT;
+}
+
+void sim_exti_service(void) {
+    uint16_t lines = asserted();
+    for (size_t i = 0; lines != 0 && i < VECTOR_COUNT; ++i) {
+        if ((lines & vectors[i].lines) && sim_nvic_enabled(vectors[i].irq)) {
+            vectors[i].handler();
+        }
+    }
+}
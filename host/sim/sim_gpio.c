@@ -0,0 +1,84 @@
+#include "sim.h"
+#include "sim_mmio.h"
+#include "stm32f10x.h"
+
+/* GPIO banks: every firmware store is observed (sim_mmio), so BSRR/BRR are
+ * applied to ODR at the moment they are written, and IDR is recomputed from
+ * the pin mode, the output latch and whatever the external models drive. */
+
+uint8_t *sim_gpio_mem;
+static uint8_t *gpio_view;
+
+// Idle lines read high: every input on the board has a pull-up.
+static uint16_t ext_level[SIM_GPIO_BANKS] = {
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF
+};
+
+// Pins in an output mode, refreshed whenever CRL/CRH may have changed.
+static uint16_t out_mask[SIM_GPIO_BANKS];
+
+static GPIO_TypeDef *bank_view(uint8_t i) {
+    return (GPIO_TypeDef *)(gpio_view + SIM_GPIO_STRIDE * i);
+}
+
+static uint16_t output_mask(GPIO_TypeDef *gpio) {
+    uint16_t mask = 0;
+    for (uint8_t pin = 0; pin < 16; ++pin) {
+        uint32_t cr = pin < 8 ? gpio->CRL : gpio->CRH;
+        // MODE[1:0] != 00 -> output (general purpose or alternate function)
+        if ((cr >> ((pin & 7) * 4)) & 0x3) mask |= 1u << pin;
+    }
+    return mask;
+}
+
+static void update_idr(uint8_t i) {
+    GPIO_TypeDef *gpio = bank_view(i);
+    uint16_t out = out_mask[i];
+    uint16_t before = (uint16_t)gpio->IDR;
+    uint16_t after = ((gpio->ODR & out) | (uint16_t)~out) & ext_level[i];
+    gpio->IDR = after;
+    if (before != after) sim_exti_gpio_changed(i, before, after);
+}
+
+static void on_gpio_write(size_t offset) {
+    uint8_t i = offset / SIM_GPIO_STRIDE;
+    GPIO_TypeDef *gpio = bank_view(i);
+    uint32_t bsrr = gpio->BSRR;
+    uint32_t brr = gpio->BRR;
+
+    // BSx has priority over BRx when both are set
+    if (bsrr) gpio->ODR = (gpio->ODR & ~(bsrr >> 16)) | (bsrr & 0xFFFF);
+    if (brr) gpio->ODR &= ~(brr & 0xFFFF);
+    gpio->BSRR = 0;
+    gpio->BRR = 0;
+    gpio->ODR &= 0xFFFF;
+    out_mask[i] = output_mask(gpio);
+    update_idr(i);
+}
+
+__attribute__((constructor)) static void gpio_create(void) {
+    void *view;
+    sim_gpio_mem = sim_mmio_create(SIM_GPIO_BANKS * SIM_GPIO_STRIDE, &view, on_gpio_write);
+    gpio_view = view;
+    for (uint8_t i = 0; i < SIM_GPIO_BANKS; ++i) update_idr(i);
+}
+
+bool sim_gpio_is_output(char bank, uint8_t pin) {
+    return (out_mask[bank - 'A'] >> pin) & 1;
+}
+
+bool sim_gpio_driven_low(char bank, uint8_t pin) {
+    uint8_t i = bank - 'A';
+    return ((out_mask[i] & ~bank_view(i)->ODR) >> pin) & 1;
+}
+
+bool sim_gpio_line(char bank, uint8_t pin) {
+    return (bank_view(bank - 'A')->IDR >> pin) & 1;
+}
+
+void sim_gpio_set_external(char bank, uint8_t pin, bool level) {
+    uint8_t i = bank - 'A';
+    if (level) ext_level[i] |= 1u << pin;
+    else ext_level[i] &= ~(1u << pin);
+    update_idr(i);
+}
@@ -0,0 +1,91 @@
+#define _GNU_SOURCE
+#include "sim_mmio.h"
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+/* Registers such as GPIO BSRR act on every store, so plain memory is not
+ * enough: two stores between clock steps would overwrite each other. The
+ * firmware gets a read-only mapping of the register block; a store faults,
+ * the page is opened, the instruction is single-stepped, and after the trap
+ * the owning model is told which offset was written. The model itself works
+ * on a second, always-writable mapping of the same memory. */
+
+#if !defined(__linux__) || !defined(__x86_64__)
+#error "sim_mmio needs Linux on x86-64 (single-step via EFLAGS.TF)"
+#endif
+
+#define MAX_REGIONS 8
+#define EFLAGS_TF   0x100
+
+typedef struct {
+    uint8_t *fw;
+    uint8_t *sim;
+    size_t size;
+    sim_mmio_write_fn on_write;
+} region_t;
+
+static region_t regions[MAX_REGIONS];
+static uint32_t region_count;
+static region_t *pending;
+static size_t pending_off;
+
+static void on_segv(int sig, siginfo_t *si, void *ctx) {
+    uint8_t *addr = si->si_addr;
+    for (uint32_t i = 0; i < region_count; ++i) {
+        region_t *r = &regions[i];
+        if (addr >= r->fw && addr < r->fw + r->size) {
+            pending = r;
+            pending_off = (size_t)(addr - r->fw);
+            mprotect(r->fw, r->size, PROT_READ | PROT_WRITE);
+            ((ucontext_t *)ctx)->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+            return;
+        }
+    }
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void on_trap(int sig, siginfo_t *si, void *ctx) {
+    (void)si;
+    if (pending == NULL) {
+        signal(sig, SIG_DFL);
+        raise(sig);
+        return;
+    }
+    ((ucontext_t *)ctx)->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+    region_t *r = pending;
+    pending = NULL;
+    mprotect(r->fw, r->size, PROT_READ);
+    r->on_write(pending_off);
+}
+
+void *sim_mmio_create(size_t size, void **sim_view, sim_mmio_write_fn on_write) {
+    if (region_count == 0) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+        sa.sa_sigaction = on_segv;
+        sigaction(SIGSEGV, &sa, NULL);
+        sa.sa_sigaction = on_trap;
+        sigaction(SIGTRAP, &sa, NULL);
+    }
+    if (region_count == MAX_REGIONS) abort();
+
+    long page = sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) / page * page;
+    int fd = memfd_create("sim_mmio", 0);
+    if (fd < 0 || ftruncate(fd, size) != 0) abort();
+    void *fw = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    void *sim = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (fw == MAP_FAILED || sim == MAP_FAILED) abort();
+
+    regions[region_count++] = (region_t){ fw, sim, size, on_write };
+    *sim_view = sim;
+    return fw;
+}
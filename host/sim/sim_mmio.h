@@ -0,0 +1,17 @@
+#ifndef HOST_SIM_MMIO_H
+#define HOST_SIM_MMIO_H
+
+#include <stddef.h>
+
+typedef void (*sim_mmio_write_fn)(size_t offset);
+
+/**
+ * @brief Create a register block whose firmware stores are observed one by one.
+ * @param size      bytes, rounded up to whole pages
+ * @param sim_view  receives a writable alias used by the model
+ * @param on_write  called after every firmware store with its byte offset
+ * @return the address the firmware uses (read-only, stores trap)
+ */
+void *sim_mmio_create(size_t size, void **sim_view, sim_mmio_write_fn on_write);
+
+#endif /* HOST_SIM_MMIO_H */
@@ -0,0 +1,114 @@
+#include "sim.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Minimal PNG encoder: 8-bit RGB, no filtering, zlib "stored" blocks. Large
+ * files, but no dependency on zlib and byte-identical output for CI diffs. */
+
+static uint32_t crc_table[256];
+
+static void crc_init(void) {
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; ++i) crc = crc_table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void write_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len) {
+    uint8_t hdr[8];
+    put_be32(hdr, len);
+    memcpy(hdr + 4, type, 4);
+    fwrite(hdr, 1, 8, f);
+    if (len) fwrite(data, 1, len, f);
+    uint32_t crc = crc_update(0xFFFFFFFFu, (const uint8_t *)type, 4);
+    crc = crc_update(crc, data, len) ^ 0xFFFFFFFFu;
+    uint8_t tail[4];
+    put_be32(tail, crc);
+    fwrite(tail, 1, 4, f);
+}
+
+int sim_png_write_rgb565(const char *path, const uint16_t *pixels,
+                         uint32_t width, uint32_t height) {
+    crc_init();
+
+    size_t row_len = 1 + (size_t)width * 3;
+    size_t raw_len = row_len * height;
+    uint8_t *raw = malloc(raw_len);
+    if (raw == NULL) return 1;
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t *row = raw + y * row_len;
+        row[0] = 0;    // filter: none
+        for (uint32_t x = 0; x < width; ++x) {
+            uint16_t c = pixels[y * width + x];
+            uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            row[1 + x * 3 + 0] = (r << 3) | (r >> 2);
+            row[1 + x * 3 + 1] = (g << 2) | (g >> 4);
+            row[1 + x * 3 + 2] = (b << 3) | (b >> 2);
+        }
+    }
+
+    size_t blocks = (raw_len + 65534) / 65535;
+    size_t z_len = 2 + raw_len + blocks * 5 + 4;
+    uint8_t *z = malloc(z_len);
+    if (z == NULL) {
+        free(raw);
+        return 1;
+    }
+    uint8_t *p = z;
+    *p++ = 0x78;
+    *p++ = 0x01;
+    uint32_t a = 1, b = 0;
+    for (size_t off = 0; off < raw_len; off += 65535) {
+        uint16_t n = (raw_len - off > 65535) ? 65535 : (uint16_t)(raw_len - off);
+        *p++ = (off + n == raw_len) ? 1 : 0;
+        *p++ = n & 0xFF;
+        *p++ = n >> 8;
+        *p++ = ~n & 0xFF;
+        *p++ = (~n >> 8) & 0xFF;
+        memcpy(p, raw + off, n);
+        p += n;
+        for (uint16_t i = 0; i < n; ++i) {
+            a = (a + raw[off + i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    put_be32(p, (b << 16) | a);
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        free(raw);
+        free(z);
+        return 1;
+    }
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(signature, 1, 8, f);
+    uint8_t ihdr[13];
+    put_be32(ihdr, width);
+    put_be32(ihdr + 4, height);
+    ihdr[8] = 8;     // bit depth
+    ihdr[9] = 2;     // colour type: truecolour
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+    write_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    write_chunk(f, "IDAT", z, (uint32_t)z_len);
+    write_chunk(f, "IEND", NULL, 0);
+    int err = ferror(f);
+    fclose(f);
+    free(raw);
+    free(z);
+    return err ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+#include "sim.h"
+#include "stm32f10x.h"
+#include "Driver_SPI.h"
+
+/* Driver_SPI1 stand-in. Send() is asynchronous like the DMA based Keil driver:
+ * the bus stays busy for setup + 8 bits per byte at the configured bus speed,
+ * then the bytes reach the panel and ARM_SPI_EVENT_TRANSFER_COMPLETE fires. */
+
+// Board wiring of the ST7789 (see driver_st7789_interface.c).
+#define PANEL_CS_BANK   'E'
+#define PANEL_CS_PIN    1
+#define PANEL_DC_BANK   'E'
+#define PANEL_DC_PIN    0
+
+static ARM_SPI_SignalEvent_t cb_event;
+static bool powered;
+static uint32_t bus_hz = 18000000;
+static uint32_t setup_ns = 2000;
+
+static bool busy;
+static uint64_t done_at = SIM_NO_EVENT;
+static const uint8_t *tx_data;
+static uint32_t tx_num;
+static bool tx_selected;
+static bool tx_dc;
+static uint32_t data_count;
+
+static sim_spi_stats_t stats;
+
+void sim_spi_set_setup_ns(uint32_t ns) {
+    setup_ns = ns;
+}
+
+uint32_t sim_spi_get_bus_hz(void) {
+    return bus_hz;
+}
+
+void sim_spi_get_stats(sim_spi_stats_t *out) {
+    *out = stats;
+}
+
+void sim_spi_reset_stats(void) {
+    stats = (sim_spi_stats_t){ 0 };
+}
+
+uint64_t sim_spi_next_event(void) {
+    return busy ? done_at : SIM_NO_EVENT;
+}
+
+void sim_spi_service(uint64_t now) {
+    if (!busy || now < done_at) return;
+    busy = false;
+    done_at = SIM_NO_EVENT;
+    data_count = tx_num;
+    if (tx_selected) sim_st7789_receive(tx_data, tx_num, tx_dc);
+    if (cb_event) cb_event(ARM_SPI_EVENT_TRANSFER_COMPLETE);
+}
+
+static ARM_DRIVER_VERSION spi_get_version(void) {
+    return (ARM_DRIVER_VERSION){ 0x0202, 0x0100 };
+}
+
+static ARM_SPI_CAPABILITIES spi_get_capabilities(void) {
+    return (ARM_SPI_CAPABILITIES){ 0 };
+}
+
+static int32_t spi_initialize(ARM_SPI_SignalEvent_t cb) {
+    cb_event = cb;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t spi_uninitialize(void) {
+    cb_event = NULL;
+    powered = false;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t spi_power_control(ARM_POWER_STATE state) {
+    powered = (state == ARM_POWER_FULL);
+    return ARM_DRIVER_OK;
+}
+
+static int32_t spi_send(const void *data, uint32_t num) {
+    if (!powered) return ARM_DRIVER_ERROR;
+    if (data == NULL || num == 0) return ARM_DRIVER_ERROR_PARAMETER;
+    if (busy) return ARM_DRIVER_ERROR_BUSY;
+
+    // Latch the chip select / data-command lines as they are right now.
+    tx_selected = !sim_gpio_line(PANEL_CS_BANK, PANEL_CS_PIN);
+    tx_dc = sim_gpio_line(PANEL_DC_BANK, PANEL_DC_PIN);
+    tx_data = data;
+    tx_num = num;
+    data_count = 0;
+
+    uint64_t shift_ns = (uint64_t)num * 8 * 1000000000ull / bus_hz;
+    busy = true;
+    done_at = sim_time_ns() + setup_ns + shift_ns;
+
+    ++stats.transfers;
+    stats.bytes += num;
+    stats.busy_ns += setup_ns + shift_ns;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t spi_receive(void *data, uint32_t num) {
+    (void)data;
+    (void)num;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+static int32_t spi_transfer(const void *data_out, void *data_in, uint32_t num) {
+    (void)data_in;
+    return spi_send(data_out, num);
+}
+
+static uint32_t spi_get_data_count(void) {
+    return data_count;
+}
+
+static int32_t spi_control(uint32_t control, uint32_t arg) {
+    switch (control & ARM_SPI_CONTROL_Msk) {
+    case ARM_SPI_MODE_MASTER:
+    case ARM_SPI_SET_BUS_SPEED:
+        // SPI1 sits on APB2 (72 MHz): the prescaler is a power of two >= 2.
+        bus_hz = SIM_CPU_HZ / 2;
+        while (bus_hz > arg && bus_hz > SIM_CPU_HZ / 256) bus_hz /= 2;
+        return ARM_DRIVER_OK;
+    case ARM_SPI_GET_BUS_SPEED:
+        return (int32_t)bus_hz;
+    case ARM_SPI_ABORT_TRANSFER:
+        busy = false;
+        done_at = SIM_NO_EVENT;
+        return ARM_DRIVER_OK;
+    default:
+        return ARM_DRIVER_OK;
+    }
+}
+
+static ARM_SPI_STATUS spi_get_status(void) {
+    return (ARM_SPI_STATUS){ .busy = busy };
+}
+
+ARM_DRIVER_SPI Driver_SPI1 = {
+    spi_get_version,
+    spi_get_capabilities,
+    spi_initialize,
+    spi_uninitialize,
+    spi_power_control,
+    spi_send,
+    spi_receive,
+    spi_transfer,
+    spi_get_data_count,
+    spi_control,
+    spi_get_status
+};
@@ -0,0 +1,187 @@
+#include "sim.h"
+
+/* ST7789 controller model. Decodes the command/parameter stream from SPI1
+ * (DC low = command, DC high = parameters or pixel data) into a 240x320
+ * RGB565 GRAM. CASET/RASET set the window, RAMWR streams big-endian pixels
+ * that wrap inside the window, MADCTL MX/MY/MV remap the address counter. */
+
+#define RST_BANK 'E'
+#define RST_PIN  3
+
+#define CMD_SWRESET 0x01
+#define CMD_SLPIN   0x10
+#define CMD_SLPOUT  0x11
+#define CMD_INVOFF  0x20
+#define CMD_INVON   0x21
+#define CMD_DISPOFF 0x28
+#define CMD_DISPON  0x29
+#define CMD_CASET   0x2A
+#define CMD_RASET   0x2B
+#define CMD_RAMWR   0x2C
+#define CMD_MADCTL  0x36
+#define CMD_COLMOD  0x3A
+#define CMD_NORON   0x13
+
+#define MADCTL_MY   0x80
+#define MADCTL_MX   0x40
+#define MADCTL_MV   0x20
+
+static uint16_t gram[SIM_ST7789_WIDTH * SIM_ST7789_HEIGHT];
+
+static uint8_t cmd;
+static uint8_t params[4];
+static uint32_t param_count;
+
+static uint16_t xs, xe = SIM_ST7789_WIDTH - 1;
+static uint16_t ys, ye = SIM_ST7789_HEIGHT - 1;
+static uint16_t cx, cy;
+static uint8_t pixel_hi;
+static bool pixel_half;
+
+static uint8_t madctl;
+static uint8_t colmod = 0x66;
+static bool display_on;
+static bool inverted;
+static bool asleep = true;
+static bool in_reset;
+
+static sim_st7789_stats_t stats;
+
+static void reset_state(void) {
+    cmd = 0;
+    param_count = 0;
+    xs = 0;
+    xe = SIM_ST7789_WIDTH - 1;
+    ys = 0;
+    ye = SIM_ST7789_HEIGHT - 1;
+    madctl = 0;
+    colmod = 0x66;
+    display_on = false;
+    inverted = false;
+    asleep = true;
+    pixel_half = false;
+}
+
+void sim_st7789_service(void) {
+    bool rst_low = sim_gpio_driven_low(RST_BANK, RST_PIN);
+    if (rst_low && !in_reset) reset_state();
+    in_reset = rst_low;
+}
+
+static void write_pixel(uint16_t color) {
+    uint16_t col = cx, row = cy;
+    if (madctl & MADCTL_MV) {
+        uint16_t t = col;
+        col = row;
+        row = t;
+    }
+    if (madctl & MADCTL_MX) col = SIM_ST7789_WIDTH - 1 - col;
+    if (madctl & MADCTL_MY) row = SIM_ST7789_HEIGHT - 1 - row;
+    if (col < SIM_ST7789_WIDTH && row < SIM_ST7789_HEIGHT) {
+        gram[row * SIM_ST7789_WIDTH + col] = color;
+    }
+    ++stats.pixels;
+
+    if (++cx > xe) {
+        cx = xs;
+        if (++cy > ye) cy = ys;
+    }
+}
+
+static void command(uint8_t c) {
+    cmd = c;
+    param_count = 0;
+    pixel_half = false;
+    ++stats.commands;
+
+    switch (c) {
+    case CMD_SWRESET: reset_state(); break;
+    case CMD_SLPIN:   asleep = true; break;
+    case CMD_SLPOUT:  asleep = false; break;
+    case CMD_INVOFF:  inverted = false; break;
+    case CMD_INVON:   inverted = true; break;
+    case CMD_DISPOFF: display_on = false; break;
+    case CMD_DISPON:  display_on = true; break;
+    case CMD_RAMWR:
+        cx = xs;
+        cy = ys;
+        ++stats.ramwr;
+        break;
+    case CMD_NORON:
+    case CMD_CASET:
+    case CMD_RASET:
+    case CMD_MADCTL:
+    case CMD_COLMOD:
+        break;
+    default:
+        ++stats.unknown_commands;
+        break;
+    }
+}
+
+static void parameter(uint8_t b) {
+    if (cmd == CMD_RAMWR) {
+        if (!pixel_half) {
+            pixel_hi = b;
+            pixel_half = true;
+        } else {
+            pixel_half = false;
+            write_pixel((uint16_t)(pixel_hi << 8) | b);
+        }
+        return;
+    }
+
+    if (param_count < sizeof(params)) params[param_count] = b;
+    ++param_count;
+
+    switch (cmd) {
+    case CMD_CASET:
+        if (param_count == 4) {
+            xs = (params[0] << 8) | params[1];
+            xe = (params[2] << 8) | params[3];
+        }
+        break;
+    case CMD_RASET:
+        if (param_count == 4) {
+            ys = (params[0] << 8) | params[1];
+            ye = (params[2] << 8) | params[3];
+        }
+        break;
+    case CMD_MADCTL:
+        if (param_count == 1) madctl = b;
+        break;
+    case CMD_COLMOD:
+        if (param_count == 1) colmod = b;
+        break;
+    default:
+        break;
+    }
+}
+
+void sim_st7789_receive(const uint8_t *data, uint32_t len, bool dc) {
+    if (in_reset) return;
+    for (uint32_t i = 0; i < len; ++i) {
+        if (dc) parameter(data[i]);
+        else command(data[i]);
+    }
+}
+
+const uint16_t *sim_st7789_framebuffer(void) {
+    return gram;
+}
+
+void sim_st7789_get_stats(sim_st7789_stats_t *out) {
+    *out = stats;
+}
+
+void sim_st7789_reset_stats(void) {
+    stats = (sim_st7789_stats_t){ 0 };
+}
+
+bool sim_st7789_display_on(void) {
+    return display_on && !asleep;
+}
+
+int sim_st7789_dump_png(const char *path) {
+    return sim_png_write_rgb565(path, gram, SIM_ST7789_WIDTH, SIM_ST7789_HEIGHT);
+}
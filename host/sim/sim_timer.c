@@ -0,0 +1,343 @@
+#include "sim.h"
+#include "sim_mmio.h"
+#include "stm32f10x.h"
+#include <stddef.h>
+#include <string.h>
+
+/* SysTick and the timers TIM1..TIM7.
+ *
+ * Both are kept in CPU cycles so LOAD/PSC values that are not a whole number
+ * of nanoseconds stay exact. Registers are re-read whenever the clock moves,
+ * so the firmware may reprogram them at any point like on the device. */
+
+SysTick_Type sim_systick;
+uint8_t *sim_tim_mem;
+static uint8_t *tim_view;
+
+void SysTick_Handler(void);
+__attribute__((weak)) void TIM1_UP_IRQHandler(void) {}
+__attribute__((weak)) void TIM2_IRQHandler(void) {}
+__attribute__((weak)) void TIM3_IRQHandler(void) {}
+__attribute__((weak)) void TIM4_IRQHandler(void) {}
+__attribute__((weak)) void TIM5_IRQHandler(void) {}
+__attribute__((weak)) void TIM6_IRQHandler(void) {}
+__attribute__((weak)) void TIM7_IRQHandler(void) {}
+
+static uint64_t to_cycles(uint64_t ns) {
+    return ns * SIM_CPU_MHZ / 1000;
+}
+
+static uint64_t to_ns(uint64_t cycles) {
+    return (cycles * 1000 + SIM_CPU_MHZ - 1) / SIM_CPU_MHZ;
+}
+
+/* ---------------------------------------------------------------------------
+ * SysTick: counts VAL down to 0, then fires and reloads LOAD. Any write to
+ * VAL clears it and restarts the period from LOAD.
+ * ------------------------------------------------------------------------- */
+static bool systick_running;
+static uint64_t systick_fire;      // cycle at which VAL reaches 0
+static uint32_t systick_val;       // last VAL written by the model
+
+static void systick_sync(uint64_t c) {
+    if (!(SysTick->CTRL & SysTick_CTRL_ENABLE)) {
+        systick_running = false;
+        return;
+    }
+    if (!systick_running || SysTick->VAL != systick_val) {
+        uint32_t val = systick_running ? 0 : (SysTick->VAL & 0xFFFFFF);
+        systick_fire = c + (val ? val : (SysTick->LOAD & 0xFFFFFF) + 1);
+        systick_running = true;
+        SysTick->VAL = systick_val = (uint32_t)(systick_fire - c - 1);
+    }
+}
+
+static void systick_service(uint64_t c) {
+    systick_sync(c);
+    if (!systick_running) return;
+
+    while (c >= systick_fire) {
+        systick_fire += (SysTick->LOAD & 0xFFFFFF) + 1;
+        SysTick->CTRL |= SysTick_CTRL_COUNTFLAG;
+        if (SysTick->CTRL & SysTick_CTRL_TICKINT) {
+            SysTick->VAL = systick_val = (uint32_t)(systick_fire - c - 1);
+            SysTick_Handler();
+            systick_sync(c);
+            if (!systick_running) return;
+        }
+    }
+    SysTick->VAL = systick_val = (uint32_t)(systick_fire - c - 1);
+}
+
+/* ---------------------------------------------------------------------------
+ * TIM1..TIM7 (up-counting): CNT counts at 72 MHz / (PSC + 1). Passing ARR is
+ * an update event (UIF, interrupt if UIE, stop if OPM); on TIM1 only every
+ * RCR + 1-th overflow is. On TIM1..TIM5 CNT reaching CCRx sets CCxIF and
+ * interrupts if CCxIE. Compare matches are only scheduled for channels with
+ * CCxIE set; the PWM outputs themselves are not modelled. With CR2.MMS =
+ * update, the update event is TRGO: TIM3 triggers the ADC1 regular group
+ * (EXTSEL = TIM3_TRGO), TIM2 and TIM4 its injected group (JEXTSEL =
+ * TIM2_TRGO, TIM4_TRGO). With DIER.UDE it also requests a DMA1 transfer on
+ * the timer's UP channel (TIM1: 5, TIM4: 7); with CR2.CCDS and DIER.CC3DE
+ * on the CC3 channel (TIM1: 6), which CCDS sends on update events.
+ * ------------------------------------------------------------------------- */
+typedef struct {
+    TIM_TypeDef *regs;      // model view of the registers
+    IRQn_Type irq;
+    void (*handler)(void);
+    uint8_t channels;       // capture/compare channels
+    int8_t adc_trgo;        // ADC1 EXTSEL code that TRGO drives, -1 if none
+    int8_t adc_jtrgo;       // ADC1 JEXTSEL code that TRGO drives, -1 if none
+    uint8_t dma_up;         // DMA1 channel of the update request, 0 if none
+    uint8_t dma_cc3;        // DMA1 channel of the CC3 request, 0 if none
+    bool running;
+    uint64_t base;          // cycle at which the counter was base_cnt
+    uint32_t base_cnt;
+    uint32_t rep;           // overflows left before the next update event
+    uint32_t sr;            // status flags raised and not yet cleared
+} sim_tim_t;
+
+// Same order and 0x400 spacing as TIM2_BASE..TIM7_BASE on the device, TIM1
+// after them
+static sim_tim_t timers[] = {
+    { .irq = TIM2_IRQn, .handler = TIM2_IRQHandler, .channels = 4, .adc_trgo = -1, .adc_jtrgo = 2 },
+    { .irq = TIM3_IRQn, .handler = TIM3_IRQHandler, .channels = 4, .adc_trgo = 4, .adc_jtrgo = -1 },
+    { .irq = TIM4_IRQn, .handler = TIM4_IRQHandler, .channels = 4, .adc_trgo = -1, .adc_jtrgo = 5, .dma_up = 7 },
+    { .irq = TIM5_IRQn, .handler = TIM5_IRQHandler, .channels = 4, .adc_trgo = -1, .adc_jtrgo = -1 },
+    { .irq = TIM6_IRQn, .handler = TIM6_IRQHandler, .channels = 0, .adc_trgo = -1, .adc_jtrgo = -1 },
+    { .irq = TIM7_IRQn, .handler = TIM7_IRQHandler, .channels = 0, .adc_trgo = -1, .adc_jtrgo = -1 },
+    { .irq = TIM1_UP_IRQn, .handler = TIM1_UP_IRQHandler, .channels = 4, .adc_trgo = -1, .adc_jtrgo = -1, .dma_up = 5, .dma_cc3 = 6 },
+};
+
+#define TIMER_COUNT (sizeof(timers) / sizeof(timers[0]))
+
+static void tim_set_flags(sim_tim_t *t, uint32_t flags) {
+    t->sr |= flags;
+    t->regs->SR = t->sr;
+}
+
+// Update event: with MMS = update it is also the TRGO pulse
+static bool tim_trgo_on_update(const sim_tim_t *t) {
+    return (t->adc_trgo >= 0 || t->adc_jtrgo >= 0) && (t->regs->CR2 & TIM_CR2_MMS) == TIM_CR2_MMS_1;
+}
+
+// DMA1 channel requested on update events, 0 if none
+static uint8_t tim_dma_on_update(const sim_tim_t *t) {
+    if (t->dma_up != 0 && (t->regs->DIER & TIM_DIER_UDE)) return t->dma_up;
+    if (t->dma_cc3 != 0 && (t->regs->CR2 & TIM_CR2_CCDS) && (t->regs->DIER & TIM_DIER_CC3DE)) {
+        return t->dma_cc3;
+    }
+    return 0;
+}
+
+static void tim_update_event(sim_tim_t *t, uint64_t at_ns) {
+    t->rep = t->regs->RCR & 0xFF;
+    uint8_t dma = tim_dma_on_update(t);
+    if (dma != 0) sim_dma_request(dma);
+    if (!tim_trgo_on_update(t)) return;
+    if (t->adc_trgo >= 0) sim_adc_ext_trigger((uint8_t)t->adc_trgo, at_ns);
+    if (t->adc_jtrgo >= 0) sim_adc_jext_trigger((uint8_t)t->adc_jtrgo, at_ns);
+}
+
+static bool tim_trgo_wakes(const sim_tim_t *t) {
+    if (!tim_trgo_on_update(t)) return false;
+    return (t->adc_trgo >= 0 && sim_adc_ext_trigger_wakes((uint8_t)t->adc_trgo)) ||
+           (t->adc_jtrgo >= 0 && sim_adc_jext_trigger_wakes((uint8_t)t->adc_jtrgo));
+}
+
+// The DMA transfer of the next update raises an interrupt somewhere ahead:
+// step through updates from then on
+static bool tim_dma_wakes(const sim_tim_t *t) {
+    uint8_t dma = tim_dma_on_update(t);
+    return dma != 0 && sim_dma_requests_to_irq(dma) != 0;
+}
+
+// Firmware stores: SR bits are cleared by writing 0 (rc_w0), a CNT write or
+// an UG event restarts the count from the new value.
+static void on_tim_write(size_t offset) {
+    sim_tim_t *t = &timers[offset / SIM_TIM_STRIDE];
+    size_t reg = offset % SIM_TIM_STRIDE;
+
+    if (reg == offsetof(TIM_TypeDef, SR)) {
+        t->sr &= t->regs->SR;
+        t->regs->SR = t->sr;
+    } else if (reg == offsetof(TIM_TypeDef, CNT)) {
+        t->running = false;
+    } else if (reg == offsetof(TIM_TypeDef, EGR)) {
+        if (t->regs->EGR & TIM_EGR_UG) {
+            t->regs->CNT = 0;
+            t->running = false;
+            if (!(t->regs->CR1 & TIM_CR1_URS)) tim_set_flags(t, TIM_SR_UIF);
+            tim_update_event(t, sim_time_ns());
+        }
+        t->regs->EGR = 0;
+    }
+}
+
+__attribute__((constructor)) static void tim_create(void) {
+    void *view;
+    sim_tim_mem = sim_mmio_create(TIMER_COUNT * SIM_TIM_STRIDE, &view, on_tim_write);
+    tim_view = view;
+    for (size_t i = 0; i < TIMER_COUNT; ++i) {
+        timers[i].regs = (TIM_TypeDef *)(tim_view + i * SIM_TIM_STRIDE);
+    }
+}
+
+static uint32_t tim_ccr(const sim_tim_t *t, uint32_t ch) {
+    const volatile uint32_t *ccr = &t->regs->CCR1;
+    return ccr[ch] & 0xFFFF;
+}
+
+static uint32_t tim_prescale(const sim_tim_t *t) {
+    return (t->regs->PSC & 0xFFFF) + 1;
+}
+
+static void tim_sync(sim_tim_t *t, uint64_t c) {
+    if (!(t->regs->CR1 & TIM_CR1_CEN)) {
+        t->running = false;
+        return;
+    }
+    if (!t->running) {
+        t->running = true;
+        t->base = c;
+        t->base_cnt = t->regs->CNT & 0xFFFF;
+    }
+}
+
+// Next time CNT passes ARR
+static uint64_t tim_overflow_cycle(const sim_tim_t *t) {
+    uint32_t arr = t->regs->ARR & 0xFFFF;
+    uint32_t left = t->base_cnt > arr ? 1 : arr + 1 - t->base_cnt;
+    return t->base + (uint64_t)left * tim_prescale(t);
+}
+
+static uint64_t tim_update_cycle(const sim_tim_t *t) {
+    uint64_t period = (uint64_t)((t->regs->ARR & 0xFFFF) + 1) * tim_prescale(t);
+    return tim_overflow_cycle(t) + t->rep * period;
+}
+
+// Earliest compare match of an interrupt-enabled channel before the next
+// update, SIM_NO_EVENT if none.
+static uint64_t tim_compare_cycle(const sim_tim_t *t) {
+    uint64_t next = SIM_NO_EVENT;
+    uint32_t arr = t->regs->ARR & 0xFFFF;
+    for (uint32_t ch = 0; ch < t->channels; ++ch) {
+        if (!(t->regs->DIER & (TIM_DIER_CC1IE << ch))) continue;
+        uint32_t ccr = tim_ccr(t, ch);
+        if (ccr <= t->base_cnt || ccr > arr) continue;
+        uint64_t e = t->base + (uint64_t)(ccr - t->base_cnt) * tim_prescale(t);
+        if (e < next) next = e;
+    }
+    return next;
+}
+
+// The interrupt line is level triggered: a flag raised while the IRQ was
+// disabled in the NVIC is taken once it is enabled again.
+static bool tim_irq_asserted(const sim_tim_t *t) {
+    return (t->sr & t->regs->DIER & 0x1F) && sim_nvic_enabled(t->irq);
+}
+
+static void tim_service(sim_tim_t *t, uint64_t c) {
+    tim_sync(t, c);
+    if (!t->running) return;
+
+    for (;;) {
+        uint64_t update = tim_overflow_cycle(t);
+        uint64_t compare = tim_compare_cycle(t);
+
+        if (compare < update && compare <= c) {
+            uint32_t matched = 0;
+            t->base_cnt += (uint32_t)((compare - t->base) / tim_prescale(t));
+            t->base = compare;
+            for (uint32_t ch = 0; ch < t->channels; ++ch) {
+                if (tim_ccr(t, ch) == t->base_cnt) matched |= TIM_SR_CC1IF << ch;
+            }
+            tim_set_flags(t, matched);
+            t->regs->CNT = t->base_cnt;
+        } else if (update <= c && t->rep > 0) {
+            // Overflow counted by the repetition counter, no update event
+            t->base = update;
+            t->base_cnt = 0;
+            t->regs->CNT = 0;
+            t->rep--;
+        } else if (update <= c) {
+            t->base = update;
+            t->base_cnt = 0;
+            tim_set_flags(t, TIM_SR_UIF);
+            t->regs->CNT = 0;
+            tim_update_event(t, to_ns(update));
+            if (t->regs->CR1 & TIM_CR1_OPM) {
+                t->regs->CR1 &= ~TIM_CR1_CEN;
+                t->running = false;
+            }
+        } else {
+            break;
+        }
+        tim_sync(t, t->base);
+        if (!t->running) return;
+    }
+    t->regs->CNT = t->base_cnt + (uint32_t)((c - t->base) / tim_prescale(t));
+}
+
+/* ------------------------------------------------------------------------- */
+
+void sim_timer_reset(void) {
+    memset(&sim_systick, 0, sizeof(sim_systick));
+    systick_running = false;
+    systick_val = 0;
+    for (size_t i = 0; i < TIMER_COUNT; ++i) {
+        memset(timers[i].regs, 0, sizeof(TIM_TypeDef));
+        timers[i].running = false;
+        timers[i].rep = 0;
+        timers[i].sr = 0;
+    }
+}
+
+void sim_timer_service(uint64_t now) {
+    uint64_t c = to_cycles(now);
+    bool pended = sim_nvic_any_pending();
+
+    // Bring every counter up to date first, so handlers read current values
+    for (size_t i = 0; i < TIMER_COUNT; ++i) {
+        tim_service(&timers[i], c);
+    }
+    systick_service(c);
+    for (size_t i = 0; i < TIMER_COUNT; ++i) {
+        sim_tim_t *t = &timers[i];
+        bool taken = pended && sim_nvic_take_pending(t->irq);
+        if (taken || tim_irq_asserted(t)) t->handler();
+    }
+}
+
+uint64_t sim_timer_next_event(uint64_t now) {
+    uint64_t c = to_cycles(now);
+    uint64_t next = SIM_NO_EVENT;
+    bool pended = sim_nvic_any_pending();
+
+    systick_sync(c);
+    if (systick_running && (SysTick->CTRL & SysTick_CTRL_TICKINT)) {
+        next = to_ns(systick_fire);
+    }
+    for (size_t i = 0; i < TIMER_COUNT; ++i) {
+        sim_tim_t *t = &timers[i];
+        if ((pended && sim_nvic_pending(t->irq)) || tim_irq_asserted(t)) return now;
+        tim_sync(t, c);
+        if (!t->running) continue;
+        uint64_t e = SIM_NO_EVENT;
+        if (sim_nvic_enabled(t->irq)) {
+            e = tim_compare_cycle(t);
+            if (t->regs->DIER & TIM_DIER_UIE) {
+                uint64_t update = tim_update_cycle(t);
+                if (update < e) e = update;
+            }
+        }
+        // TRGO and the update DMA request are caught up like the counter
+        // unless the ADC or DMA channel they drive can raise an interrupt
+        if (tim_trgo_wakes(t) || tim_dma_wakes(t)) {
+            uint64_t update = tim_update_cycle(t);
+            if (update < e) e = update;
+        }
+        if (e != SIM_NO_EVENT && to_ns(e) < next) next = to_ns(e);
+    }
+    return next;
+}
@@ -0,0 +1,197 @@
+#include "sim.h"
+#include "Driver_USART.h"
+#include "stm32f10x.h"
+#include <string.h>
+
+/* Driver_USART1 stand-in: 10 bit times per byte at the configured baud rate.
+ * Transmitted bytes are written to a host stream, injected bytes complete the
+ * pending Receive() or raise ARM_USART_EVENT_RX_TIMEOUT after one idle frame. */
+
+#define RX_QUEUE_SIZE 8192
+
+// Register block for code that drives USART1 directly (simple_usart1.c).
+USART_TypeDef sim_usart1;
+
+static ARM_USART_SignalEvent_t cb_event;
+static uint32_t baud = 115200;
+static FILE *output;
+static bool output_set;
+
+static bool tx_busy;
+static uint64_t tx_done_at = SIM_NO_EVENT;
+static const uint8_t *tx_data;
+static uint32_t tx_num;
+static uint32_t tx_count;
+
+static uint8_t *rx_buf;
+static uint32_t rx_num;
+static uint32_t rx_count;
+static bool rx_busy;
+
+static uint8_t rx_queue[RX_QUEUE_SIZE];
+static uint32_t rx_queue_len;
+static uint32_t rx_queue_pos;
+static uint64_t rx_next_at = SIM_NO_EVENT;
+static uint64_t rx_idle_at = SIM_NO_EVENT;
+
+static uint64_t frame_ns(void) {
+    return 10ull * 1000000000ull / baud;
+}
+
+void sim_usart_set_output(FILE *out) {
+    output = out;
+    output_set = true;
+}
+
+void sim_usart_inject(const void *data, uint32_t len) {
+    if (rx_queue_pos == rx_queue_len) rx_queue_pos = rx_queue_len = 0;
+    if (len > RX_QUEUE_SIZE - rx_queue_len) len = RX_QUEUE_SIZE - rx_queue_len;
+    memcpy(&rx_queue[rx_queue_len], data, len);
+    rx_queue_len += len;
+    if (rx_next_at == SIM_NO_EVENT) rx_next_at = sim_time_ns() + frame_ns();
+}
+
+uint64_t sim_usart_next_event(void) {
+    uint64_t next = tx_busy ? tx_done_at : SIM_NO_EVENT;
+    if (rx_next_at < next) next = rx_next_at;
+    if (rx_idle_at < next) next = rx_idle_at;
+    return next;
+}
+
+void sim_usart_service(uint64_t now) {
+    if (tx_busy && now >= tx_done_at) {
+        FILE *out = output_set ? output : stdout;
+        if (out) {
+            fwrite(tx_data, 1, tx_num, out);
+            fflush(out);
+        }
+        tx_count = tx_num;
+        tx_busy = false;
+        tx_done_at = SIM_NO_EVENT;
+        if (cb_event) cb_event(ARM_USART_EVENT_SEND_COMPLETE | ARM_USART_EVENT_TX_COMPLETE);
+    }
+
+    // One byte per frame; bytes arriving with no Receive() pending are lost.
+    while (rx_next_at <= now) {
+        uint8_t byte = rx_queue[rx_queue_pos++];
+        if (rx_busy && rx_count < rx_num) rx_buf[rx_count++] = byte;
+        rx_next_at = (rx_queue_pos < rx_queue_len) ? rx_next_at + frame_ns() : SIM_NO_EVENT;
+        rx_idle_at = now + frame_ns();
+        if (rx_busy && rx_count == rx_num) {
+            rx_busy = false;
+            rx_idle_at = SIM_NO_EVENT;
+            if (cb_event) cb_event(ARM_USART_EVENT_RECEIVE_COMPLETE);
+        }
+    }
+
+    if (rx_idle_at <= now) {
+        rx_idle_at = SIM_NO_EVENT;
+        if (rx_busy && rx_count > 0 && cb_event) cb_event(ARM_USART_EVENT_RX_TIMEOUT);
+    }
+}
+
+static ARM_DRIVER_VERSION usart_get_version(void) {
+    return (ARM_DRIVER_VERSION){ 0x0203, 0x0100 };
+}
+
+static ARM_USART_CAPABILITIES usart_get_capabilities(void) {
+    return (ARM_USART_CAPABILITIES){ .asynchronous = 1 };
+}
+
+static int32_t usart_initialize(ARM_USART_SignalEvent_t cb) {
+    cb_event = cb;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t usart_uninitialize(void) {
+    cb_event = NULL;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t usart_power_control(ARM_POWER_STATE state) {
+    (void)state;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t usart_send(const void *data, uint32_t num) {
+    if (data == NULL || num == 0) return ARM_DRIVER_ERROR_PARAMETER;
+    if (tx_busy) return ARM_DRIVER_ERROR_BUSY;
+    tx_data = data;
+    tx_num = num;
+    tx_count = 0;
+    tx_busy = true;
+    tx_done_at = sim_time_ns() + num * frame_ns();
+    return ARM_DRIVER_OK;
+}
+
+static int32_t usart_receive(void *data, uint32_t num) {
+    if (data == NULL || num == 0) return ARM_DRIVER_ERROR_PARAMETER;
+    if (rx_busy) return ARM_DRIVER_ERROR_BUSY;
+    rx_buf = data;
+    rx_num = num;
+    rx_count = 0;
+    rx_busy = true;
+    return ARM_DRIVER_OK;
+}
+
+static int32_t usart_transfer(const void *data_out, void *data_in, uint32_t num) {
+    (void)data_out;
+    (void)data_in;
+    (void)num;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+static uint32_t usart_get_tx_count(void) {
+    return tx_count;
+}
+
+static uint32_t usart_get_rx_count(void) {
+    return rx_count;
+}
+
+static int32_t usart_control(uint32_t control, uint32_t arg) {
+    switch (control & ARM_USART_CONTROL_Msk) {
+    case ARM_USART_MODE_ASYNCHRONOUS:
+        baud = arg;
+        return ARM_DRIVER_OK;
+    case ARM_USART_ABORT_SEND:
+        tx_busy = false;
+        tx_done_at = SIM_NO_EVENT;
+        return ARM_DRIVER_OK;
+    case ARM_USART_ABORT_RECEIVE:
+        rx_busy = false;
+        return ARM_DRIVER_OK;
+    default:
+        return ARM_DRIVER_OK;
+    }
+}
+
+static ARM_USART_STATUS usart_get_status(void) {
+    return (ARM_USART_STATUS){ .tx_busy = tx_busy, .rx_busy = rx_busy };
+}
+
+static int32_t usart_set_modem_control(ARM_USART_MODEM_CONTROL control) {
+    (void)control;
+    return ARM_DRIVER_ERROR_UNSUPPORTED;
+}
+
+static ARM_USART_MODEM_STATUS usart_get_modem_status(void) {
+    return (ARM_USART_MODEM_STATUS){ 0 };
+}
+
+ARM_DRIVER_USART Driver_USART1 = {
+    usart_get_version,
+    usart_get_capabilities,
+    usart_initialize,
+    usart_uninitialize,
+    usart_power_control,
+    usart_send,
+    usart_receive,
+    usart_transfer,
+    usart_get_tx_count,
+    usart_get_rx_count,
+    usart_control,
+    usart_get_status,
+    usart_set_modem_control,
+    usart_get_modem_status
+};
@@ -1,37 +1,27 @@
 #include "RTE_Components.h"
-#include "libs/led/led_gpio.h"
+#include "libs/led/led_seq.h"
 #include <stdint.h>
 #include CMSIS_device_header
 
-struct LED_INFO {
-    char bank;
-    uint8_t pin;
-} led_list[4] = { {'D', 12}, {'D', 11},
-                    {'D', 9}, {'B', 8} };
-static inline void spin( volatile uint32_t tick ) {
-    while ( tick-- ) {
-        asm("nop");
-    }
-}
+static const gpio_pin_t led_list[4] = { GPIO_PIN_INIT('D', 12), GPIO_PIN_INIT('D', 11),
+                                        GPIO_PIN_INIT('D', 9), GPIO_PIN_INIT('B', 8) };
+
+// Light the LEDs one by one, then turn them off one by one
+static const led_seq_step_t chaser[] = {
+    { 0x1, 150 }, { 0x3, 150 }, { 0x7, 150 }, { 0xF, 150 },
+    { 0xE, 150 }, { 0xC, 150 }, { 0x8, 150 }, { 0x0, 150 },
+};
+
+static led_seq_t chaser_track;
+
 int main() {
+    // Configures the pins (clocks included) and starts the utimer on TIM5
+    led_seq_init(led_list, 4, true);
 
-    // Enable GPIOs in RCC APB2ENR
-    RCC->APB2ENR |= RCC_APB2ENR_IOPDEN;
-    RCC->APB2ENR |= RCC_APB2ENR_IOPBEN;
-    // Set the target gpio output
-    for ( uint8_t i = 0; i < 4; ++i ) {
-        led_init(led_list[i].bank, led_list[i].pin);
-    }
-    
-    for (;;) {
-        for ( uint8_t i = 0; i < 4; ++i ) {
-            led_on(led_list[i].bank, led_list[i].pin);
-            spin(1000000);
-        }
+    // Every step is applied from the TIM5 interrupt; the core sleeps between
+    led_seq_play(&chaser_track, chaser, 8, 0xF, LED_SEQ_FOREVER);
 
-        for ( uint8_t i = 0; i < 4; ++i ) {
-            led_off(led_list[i].bank, led_list[i].pin);
-            spin(1000000);
-        }
+    for (;;) {
+        __WFI();
     }
 }
@@ -5,10 +5,14 @@
 #include CMSIS_device_header
 #include "libs/console/console.h"
 #include "libs/delay/delay.h"
+#include "libs/key/key.h"
 #include "libs/st7789/simple_st7789_driver.h"
 
 #define ROWS_IN_A_CHUNK 4
 
+// Key 1 -> PC1, debounced by the EXTI1 and TIM5 interrupts
+static const gpio_pin_t key_list[1] = { GPIO_PIN_INIT('C', 1) };
+
 void st7789_read_chunks() {
     uint8_t buf[MAX_CHUNK_SIZE];
     uint32_t buf_len;
@@ -27,18 +31,21 @@ void st7789_read_chunks() {
 }
 int main() {
     RCC->APB2ENR |= RCC_APB2ENR_IOPAEN;
-    RCC->APB2ENR |= RCC_APB2ENR_IOPCEN;
     RCC->APB2ENR |= RCC_APB2ENR_IOPEEN;
     delay_init();
     console_init();
     simple_st7789_init();
 
-    // Key 1 -> PC1
-    GPIOC->CRL &= ~(0b1111 << 4);
-    GPIOC->CRL |= (0b0100 << 4);
+    key_init(key_list, 1);
 
     for (;;) {
-        if ( !( GPIOC->IDR & (1<<1) ) ) {
+        key_event_t ev;
+        // Sleep until the key driver queues an event
+        if ( !key_get(&ev) ) {
+            delay_idle(1000);
+            continue;
+        }
+        if ( ev.type == KEY_EVENT_PRESS ) {
             static const char* ready_msg = "IMAGE_RECEIVER_READY\n";
             console_info(ready_msg, strlen(ready_msg));
             simple_st7789_fill_screen(COLOR_WHITE);
@@ -3,12 +3,23 @@
 #include "core/lv_obj.h"
 #include "widgets/lv_label.h"
 #include <stdint.h>
+#include <string.h>
 #include CMSIS_device_header
 #include "libs/console/console.h"
 #include "libs/delay/delay.h"
 #include "libs/dht11/dht11.h"
+#include "libs/dht11/dht11_service.h"
+#include "libs/dsp/dsp.h"
+#include "libs/gui/gui.h"
+#include "libs/gui/gui_bind.h"
+#include "libs/profile/profile.h"
+#include "libs/sched/sched.h"
+#include "libs/st7789/st7789_spi_trace.h"
 #include "interface/adc/adc.h"
+#include "interface/adc/adc_scan.h"
+#include "interface/adc/adc_watch.h"
 #include "lv_port_disp.h"
+#include "lv_port_indev.h"
 
 // Widgets
 static lv_obj_t * slider_temperature;
@@ -19,44 +30,186 @@ static lv_obj_t * bar_adc_pb0;
 static lv_obj_t * bar_adc_pc3;
 static lv_obj_t * label_adc_pb0;
 static lv_obj_t * label_adc_pc3;
+static lv_obj_t * led_status;
 
 // Sensor data
 static dht11_dt dht11_data;
-static uint16_t adc_pb0_value = 0;
-static uint16_t adc_pc3_value = 0;
 
-static void update_sensor_data()
+// PB0 and PC3 are sampled at 1 kHz into this ring by DMA; every half of it
+// (32 ms) goes through a CIC decimator by 16 and a 5 Hz low-pass
+static const ADC_CHANNEL adc_channels[] = { ADC_CH8_PB0, ADC_CH13_PC3 };
+#define ADC_CHANNELS    2
+#define ADC_RATE_HZ     1000
+#define ADC_FRAMES      32
+#define ADC_CIC_SHIFT   4
+static uint16_t adc_ring[2 * ADC_FRAMES * ADC_CHANNELS];
+static dsp_cic_t adc_cic[ADC_CHANNELS];
+static dsp_biquad_t adc_lowpass[ADC_CHANNELS];
+
+// The UI hears about a channel only when it moved by 1% (41 counts); PB0
+// above 90% turns the LED red until it drops under 85%, watched on every
+// raw conversion by the ADC analog watchdog. The watch callbacks post to
+// the widgets' slots from interrupt context; the main loop applies them.
+static adc_watch_t adc_watch_ui[ADC_CHANNELS];
+static adc_watch_t adc_watch_alarm;
+static gui_slot_t adc_slot[ADC_CHANNELS];
+static gui_slot_t alarm_slot;
+
+// Widgets are bound to their values: an update that would not change what
+// is shown costs a compare, and an ADC channel redraws at most every 100 ms
+#define ADC_UI_MIN_MS   100
+typedef struct {
+    gui_bind_t bar;             // percent
+    gui_bind_t label;           // raw value, shown with the percent
+    gui_bind_text_t text;
+} adc_view_t;
+static adc_view_t adc_view[ADC_CHANNELS];
+static gui_bind_t temp_slider_bind, temp_label_bind, humi_slider_bind, humi_label_bind;
+static gui_bind_text_t temp_text = { .fmt = "%d°C" };
+static gui_bind_text_t humi_text = { .fmt = "%d%%" };
+
+static sched_job_t lvgl_job;
+static sched_job_t dht11_job;
+static dht11_service_t dht11_svc;
+
+static void lvgl_task(void *arg)
 {
-    // DHT11 Sensor
-    static uint32_t last_dht11_read = 0;
-    uint32_t current_tick = delay_get_tick();
-    
-    if(timer_expired(&last_dht11_read, 2000, current_tick)) {
-        uint8_t result = dht11_read(&dht11_data);
-        if(result == 0) {
-            int temp_range = dht11_data.temp > 50 ? 50 : dht11_data.temp;
-            lv_slider_set_value(slider_temperature, temp_range, LV_ANIM_ON);
-            lv_label_set_text_fmt(label_temp_value, "%d°C", dht11_data.temp);
-            
-            lv_slider_set_value(slider_humidity, dht11_data.humity, LV_ANIM_ON);
-            lv_label_set_text_fmt(label_humi_value, "%d%%", dht11_data.humity);
-        }
+    (void)arg;
+    // Values held back by a binding's rate limit
+    uint32_t bind_next = gui_bind_poll();
+
+    PROFILE_BEGIN(lv_timer_handler);
+    uint32_t next = lv_timer_handler();
+    PROFILE_END(lv_timer_handler);
+
+    // Sleep until LVGL's next timer is due instead of polling it every 5 ms
+    if(next == LV_NO_TIMER_READY) next = LV_DISP_DEF_REFR_PERIOD;
+    if(bind_next < next) next = bind_next;
+    sched_set_next(&lvgl_job, next);
+}
+
+// DHT11 Sensor: the service reads it in the background, show new samples
+static void dht11_task(void *arg)
+{
+    (void)arg;
+    static uint32_t shown_update = 0;
+    dht11_sample_t sample;
+
+    uint32_t update = dht11_service_get(&dht11_svc, &sample);
+    if(update == shown_update || !(sample.flags & DHT11_SAMPLE_VALID)) return;
+    shown_update = update;
+    dht11_data = sample.data;
+
+    int temp_range = dht11_data.temp > 50 ? 50 : dht11_data.temp;
+    bool changed = gui_bind_set(&temp_slider_bind, temp_range);
+    changed |= gui_bind_set(&temp_label_bind, dht11_data.temp);
+    changed |= gui_bind_set(&humi_slider_bind, dht11_data.humity);
+    changed |= gui_bind_set(&humi_label_bind, dht11_data.humity);
+
+    // Let LVGL start the animations right away
+    if(changed) sched_set_next(&lvgl_job, 0);
+}
+
+// DMA half-block: filter each channel down to one value, off the UI path
+static void adc_block(const uint16_t *block, uint16_t frames, void *arg)
+{
+    (void)arg;
+    q15_t out[ADC_FRAMES >> ADC_CIC_SHIFT];
+
+    PROFILE_BEGIN(adc_dsp);
+    for(uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+        uint16_t n = dsp_cic_decimate(&adc_cic[ch], block + ch, ADC_CHANNELS, out, frames);
+        dsp_biquad_process(&adc_lowpass[ch], out, out, n);
+        if(n > 0) adc_watch_feed(adc_channels[ch], dsp_q15_to_adc(out[n - 1]));
     }
-    
-    // ADC Sensors
-    static uint32_t last_adc_read = 0;
-    if(timer_expired(&last_adc_read, 100, current_tick)) {
-        // PB0
-        adc_pb0_value = adc_get_single(ADC_CH8_PB0);
-        uint8_t pb0_percent = (adc_pb0_value * 100) / 4095;
-        lv_bar_set_value(bar_adc_pb0, pb0_percent, LV_ANIM_ON);
-        lv_label_set_text_fmt(label_adc_pb0, "%d%% (%d)", pb0_percent, adc_pb0_value);
-        
-        // PC3
-        adc_pc3_value = adc_get_single(ADC_CH13_PC3);
-        uint8_t pc3_percent = (adc_pc3_value * 100) / 4095;
-        lv_bar_set_value(bar_adc_pc3, pc3_percent, LV_ANIM_ON);
-        lv_label_set_text_fmt(label_adc_pc3, "%d%% (%d)", pc3_percent, adc_pc3_value);
+    PROFILE_END(adc_dsp);
+}
+
+// ADC watch callbacks (interrupt context): post the value to the widget
+static void adc_changed(adc_watch_t *watch, ADC_WATCH_EVENT event, uint16_t value, void *arg)
+{
+    (void)watch;
+    (void)event;
+    uint8_t ch = (uint8_t)(uintptr_t)arg;
+    gui_post(&adc_slot[ch], value);
+}
+
+static void adc_alarm_changed(adc_watch_t *watch, ADC_WATCH_EVENT event, uint16_t value, void *arg)
+{
+    (void)watch;
+    (void)value;
+    (void)arg;
+    gui_post(&alarm_slot, event == ADC_WATCH_ABOVE);
+}
+
+static int32_t adc_percent(int32_t value)
+{
+    return (value * 100 + 2047) / 4095;
+}
+
+static void adc_label_show(lv_obj_t * label, int32_t value, void * text)
+{
+    char buf[GUI_BIND_TEXT_LEN];
+    lv_snprintf(buf, sizeof(buf), "%d%% (%d)", (int)adc_percent(value), (int)value);
+    gui_bind_label_text(label, text, buf);
+}
+
+// Slot appliers (main loop): the bar's slot also writes its label
+static void adc_show(lv_obj_t * bar, int32_t value, void * arg)
+{
+    (void)bar;
+    adc_view_t * view = arg;
+    gui_bind_set(&view->bar, adc_percent(value));
+    gui_bind_set(&view->label, value);
+}
+
+static void alarm_show(lv_obj_t * led, int32_t alarm, void * arg)
+{
+    (void)arg;
+    lv_led_set_color(led, alarm ? lv_palette_main(LV_PALETTE_RED) : lv_theme_get_color_primary(led));
+}
+
+// Widget updates posted by interrupts: each slot once, with its latest value
+static void handle_gui_updates(void)
+{
+    PROFILE_BEGIN(adc_ui);
+    uint32_t applied = gui_process();
+    PROFILE_END(adc_ui);
+
+    if(applied) sched_set_next(&lvgl_job, 0);
+}
+
+// Keys: LVGL reads its input devices only when the key driver queued an
+// event, then redraws right away
+static void handle_keys(void)
+{
+    if(lv_port_indev_process()) sched_set_next(&lvgl_job, 0);
+}
+
+// Console commands: "prof" prints the profiler probes, "prof reset" clears
+// them, "dht" prints the DHT11 value and error counters. With
+// ST7789_SPI_TRACE, "trace" prints the SPI summary and recent transfers of
+// the display and "trace reset" starts a new window.
+static void handle_console(void)
+{
+    static uint8_t cmd[MAX_CHUNK_SIZE];
+    uint32_t len;
+
+    if(console_read(cmd, &len) != CONSOLE_READ_OK) return;
+    while(len > 0 && (cmd[len - 1] == '\r' || cmd[len - 1] == '\n')) --len;
+
+    if(len == 4 && memcmp(cmd, "prof", 4) == 0) {
+        profile_dump();
+    } else if(len == 10 && memcmp(cmd, "prof reset", 10) == 0) {
+        profile_reset();
+    } else if(len == 3 && memcmp(cmd, "dht", 3) == 0) {
+        dht11_service_dump(&dht11_svc);
+#if ST7789_SPI_TRACE
+    } else if(len == 5 && memcmp(cmd, "trace", 5) == 0) {
+        st7789_spi_trace_dump(1);
+    } else if(len == 11 && memcmp(cmd, "trace reset", 11) == 0) {
+        st7789_spi_trace_reset();
+#endif
     }
 }
 
@@ -130,14 +283,29 @@ static void create_ui(void)
     lv_obj_align_to(label_adc_pc3, bar_adc_pc3, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
     
     // 6. LED Indicator
-    lv_obj_t * led = lv_led_create(lv_scr_act());
-    lv_obj_set_size(led, 30, 30);
-    lv_obj_align(led, LV_ALIGN_BOTTOM_LEFT, 20, -20);
-    lv_led_on(led);
+    led_status = lv_led_create(lv_scr_act());
+    lv_obj_set_size(led_status, 30, 30);
+    lv_obj_align(led_status, LV_ALIGN_BOTTOM_LEFT, 20, -20);
+    lv_led_on(led_status);
     
     lv_obj_t * led_label = lv_label_create(lv_scr_act());
     lv_label_set_text(led_label, "System Running");
-    lv_obj_align_to(led_label, led, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
+    lv_obj_align_to(led_label, led_status, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
+
+    // Slots of the widgets updated from interrupts
+    gui_slot_init(&adc_slot[0], bar_adc_pb0, adc_show, &adc_view[0]);
+    gui_slot_init(&adc_slot[1], bar_adc_pc3, adc_show, &adc_view[1]);
+    gui_slot_init(&alarm_slot, led_status, alarm_show, NULL);
+
+    // Bindings of the widgets to their values
+    gui_bind_init(&adc_view[0].bar, bar_adc_pb0, gui_bind_show_bar, NULL, ADC_UI_MIN_MS);
+    gui_bind_init(&adc_view[0].label, label_adc_pb0, adc_label_show, &adc_view[0].text, ADC_UI_MIN_MS);
+    gui_bind_init(&adc_view[1].bar, bar_adc_pc3, gui_bind_show_bar, NULL, ADC_UI_MIN_MS);
+    gui_bind_init(&adc_view[1].label, label_adc_pc3, adc_label_show, &adc_view[1].text, ADC_UI_MIN_MS);
+    gui_bind_init(&temp_slider_bind, slider_temperature, gui_bind_show_slider, NULL, 0);
+    gui_bind_init(&temp_label_bind, label_temp_value, gui_bind_show_label, &temp_text, 0);
+    gui_bind_init(&humi_slider_bind, slider_humidity, gui_bind_show_slider, NULL, 0);
+    gui_bind_init(&humi_label_bind, label_humi_value, gui_bind_show_label, &humi_text, 0);
 }
 
 int main() {
@@ -147,20 +315,52 @@ int main() {
     RCC->APB2ENR |= RCC_APB2ENR_IOPEEN;
 
     delay_init();
+    profile_init();
     console_init();
     
     console_info((uint8_t*)"System starting...\n", 20);
 
     dht11_init();
+    dht11_service_start(&dht11_svc, &dht11_board, DHT11_MIN_INTERVAL_MS);
     console_info((uint8_t*)"DHT11 initialized\r\n", 19);
 
-    adc_init(ADC_CH8_PB0);   // PB0
-    adc_init(ADC_CH13_PC3);  // PC3
+    for(uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+        dsp_cic_init(&adc_cic[ch], 3, ADC_CIC_SHIFT);
+        dsp_biquad_lowpass(&adc_lowpass[ch], 5.0f, (float)ADC_RATE_HZ / (1 << ADC_CIC_SHIFT));
+    }
+    adc_scan_config_t adc_scan = {
+        .channels = adc_channels,       // PB0, PC3
+        .count = ADC_CHANNELS,
+        .sample_time = ADC_SMP_239_5,
+        .buffer = adc_ring,
+        .frames = ADC_FRAMES,
+        .on_block = adc_block,
+        .sample_rate_hz = ADC_RATE_HZ,
+    };
+    for(uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+        adc_watch_ui[ch] = (adc_watch_t){
+            .channel = adc_channels[ch],
+            .low = 0, .high = 0xFFFF,   // no levels, changes only
+            .delta = 41,
+            .fn = adc_changed,
+            .arg = (void *)(uintptr_t)ch,
+        };
+        adc_watch_add(&adc_watch_ui[ch]);
+    }
+    adc_watch_alarm = (adc_watch_t){
+        .channel = ADC_CH8_PB0,
+        .low = 3481, .high = 3686,      // 85% .. 90%
+        .fast = 1,
+        .fn = adc_alarm_changed,
+    };
+    adc_scan_start(&adc_scan);
+    adc_watch_add(&adc_watch_alarm);
     console_info((uint8_t*)"ADC channels initialized\r\n", 27);
 
     // Initialize LVGL
     lv_init();
     lv_port_disp_init();
+    lv_port_indev_init();       // key 1 (PC1) steps the focus through the sliders
     console_info((uint8_t*)"LVGL initialized\r\n", 19);
 
     // Create UI
@@ -170,12 +370,15 @@ int main() {
     console_info((uint8_t*)"Starting main loop...\r\n", 24);
 
 
-    for (;;) {
-        static uint32_t last_lv_timer = 0;
-        uint32_t current_tick = delay_get_tick();
-        if ( timer_expired(&last_lv_timer, 5, current_tick))
-            lv_timer_handler();
+    // Event driven main loop: run what is due, then sleep until the next
+    // deadline or until an interrupt (e.g. console input, a key) wakes the core.
+    sched_add(&lvgl_job, lvgl_task, NULL, 0, LV_DISP_DEF_REFR_PERIOD);
+    sched_add(&dht11_job, dht11_task, NULL, 500, 500);
 
-        update_sensor_data();
+    for (;;) {
+        handle_console();
+        handle_keys();
+        handle_gui_updates();
+        sched_poll();
     }
 }
@@ -4,31 +4,24 @@
 #include CMSIS_device_header
 #include "st7789/simple_st7789_driver.h"
 #include "delay/delay.h"
-#include "led/led_gpio.h"
+#include "pwm/pwm_led.h"
+#include "led/led_seq.h"
 #include "dht11/dht11.h"
+#include "dht11/dht11_service.h"
 #include "stdio.h"
 
 uint8_t DHT11_Status;
 
-struct LED_INFO {
-    char bank;
-    uint8_t pin;
-} led_list[4] = { {'D', 12}, {'D', 11},
-                    {'D', 9}, {'B', 8} };
+// LED1 (PD12) is on TIM4 PWM; the sequencer drives LED2..LED4
+static const gpio_pin_t seq_leds[3] = { GPIO_PIN_INIT('D', 11), GPIO_PIN_INIT('D', 9),
+                                        GPIO_PIN_INIT('B', 8) };
 
-osThreadId_t LED1_Thread_Handle;
-const osThreadAttr_t LED1Task_attributes = {
-   .name = "LED1Task",
-   .priority = (osPriority_t) osPriorityNormal,
-   .stack_size = 128 * 4
-};
+// LED1 breathes on TIM4 PWM: DMA plays the table, no thread needed
+static uint16_t led1_breath[PWM_LED_STEPS(2000)];
 
-osThreadId_t LED2_Thread_Handle;
-const osThreadAttr_t LED2Task_attributes = {
-   .name = "LED2Task",
-   .priority = (osPriority_t) osPriorityNormal,
-   .stack_size = 128 * 4
-};
+// LED2 flashes from the TIM5 interrupt instead of a thread of its own
+static const led_seq_step_t led2_flash[] = { { 0x1, 100 }, { 0x0, 100 } };
+static led_seq_t led2_track;
 
 osThreadId_t DHT11_READ_Thread_Handle;
 const osThreadAttr_t DHT11_READ_Task_attributes = {
@@ -44,25 +37,8 @@ const osThreadAttr_t DHT11_DISPLAY_Task_attributes = {
    .stack_size = 128 * 4
 };
 
-void LED1_Task() {
-    for(;;) {
-        led_on(led_list[0].bank, led_list[0].pin);
-        delay_ms(100);
-        led_off(led_list[0].bank, led_list[0].pin);
-        delay_ms(500);
-    }
-}
-
-void LED2_Task() {
-    for(;;) {
-        led_on(led_list[1].bank, led_list[1].pin);
-        delay_ms(100);
-        led_off(led_list[1].bank, led_list[1].pin);
-        delay_ms(100);
-    }
-}
-
 osMessageQueueId_t DHT11_MSG_Handle = NULL;
+static dht11_service_t dht11_svc;
 
 void DHT11_Read_Task() {
     DHT11_Status = dht11_init();
@@ -72,13 +48,18 @@ void DHT11_Read_Task() {
         simple_st7789_draw_string(5, 21, "DHT11 Failed.", COLOR_BLACK, COLOR_WHITE);
     }
     DHT11_MSG_Handle = osMessageQueueNew(4, sizeof(dht11_dt), NULL);
-    dht11_dt data;
+    dht11_service_start(&dht11_svc, &dht11_board, DHT11_MIN_INTERVAL_MS);
+
+    // Forward every new valid sample; the service does the timing and reading
+    uint32_t last_update = 0;
+    dht11_sample_t sample;
     for(;;) {
-        uint8_t res = dht11_read(&data);
-        if ( res == 0 ) {
-            osMessageQueuePut(DHT11_MSG_Handle, &data, NULL, osWaitForever);
+        uint32_t update = dht11_service_get(&dht11_svc, &sample);
+        if ( update != last_update && sample.last_status == 0 ) {
+            osMessageQueuePut(DHT11_MSG_Handle, &sample.data, NULL, osWaitForever);
         }
-        delay_ms(2000);
+        last_update = update;
+        delay_ms(500);
     }
 }
 
@@ -102,8 +83,6 @@ void DHT11_Display_Task() {
 }
 
 void rtos_tasks_init() {
-    LED1_Thread_Handle = osThreadNew( LED1_Task, NULL, &LED1Task_attributes );
-    LED2_Thread_Handle = osThreadNew( LED2_Task, NULL, &LED2Task_attributes );
     DHT11_READ_Thread_Handle = osThreadNew(DHT11_Read_Task, NULL, &DHT11_READ_Task_attributes);
     DHT11_DISPLAY_Thread_Handle = osThreadNew(DHT11_Display_Task, NULL, &DHT11_DISPLAY_Task_attributes);
 }
@@ -119,9 +98,12 @@ int main() {
     simple_st7789_init();
     simple_st7789_fill_screen(COLOR_WHITE);
 
-    for ( uint8_t i = 0; i < 4; ++i ) {
-        led_init(led_list[i].bank, led_list[i].pin);
-    }
+    led_seq_init(seq_leds, 3, true);
+    led_seq_play(&led2_track, led2_flash, 2, 0x1, LED_SEQ_FOREVER);
+    pwm_led_init(PWM_LED_STATUS);
+    pwm_led_fill_fade(led1_breath, PWM_LED_STEPS(1000), 0, 255);
+    pwm_led_fill_fade(led1_breath + PWM_LED_STEPS(1000), PWM_LED_STEPS(1000), 255, 0);
+    pwm_led_play(PWM_LED_STATUS, led1_breath, PWM_LED_STEPS(2000), true);
 
     rtos_tasks_init();
 